@@ -23,6 +23,9 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+#include <semaphore.h>
 
 #include <nuttx/init.h>
 #include <nuttx/arch.h>
@@ -31,6 +34,7 @@
 
 #include "Audio.h"
 #include "MemoryUtil.h"
+#include "DspRegistry.h"
 
 #include <File.h>
 
@@ -42,9 +46,6 @@
 
 #include <asmp/mpshm.h>
 
-extern "C" void  input_device_callback(uint32_t);
-extern "C" void  output_device_callback(uint32_t);
-
 /* Timeout waiting for command reception. Unit is milliseconds. */
 
 #define RESPONSE_TIMEOUT 10
@@ -314,6 +315,12 @@ err_t AudioClass::begin_player(void)
       return AUDIOLIB_ECODE_AUDIOCOMMAND_ERROR;
     }
 
+  for (int i = 0; i < 2; i++)
+    {
+      sem_init(&m_player_wm_sem[i], 0, 0);
+      m_player_wm_waiting[i] = false;
+    }
+
   print_dbg("cmplt Activation\n");
 
   return AUDIOLIB_ECODE_OK;
@@ -383,6 +390,11 @@ err_t AudioClass::end_player(void)
   AS_DeleteOutputMix();
   AS_DeleteRenderer();
 
+  for (int i = 0; i < 2; i++)
+    {
+      sem_destroy(&m_player_wm_sem[i]);
+    }
+
   return AUDIOLIB_ECODE_OK;
 }
 
@@ -412,7 +424,7 @@ err_t AudioClass::activateAudio(void)
   ids.effector    = 0xFF;
   ids.recognizer  = 0xFF;
 
-  AS_CreateAudioManager(ids, (m_attention_callback) ? m_attention_callback : attentionCallback);
+  AS_CreateAudioManager(ids, attention_callback);
 
   ret = powerOn();
   if (ret != AUDIOLIB_ECODE_OK)
@@ -432,17 +444,9 @@ err_t AudioClass::powerOn(void)
   command.header.command_code  = AUDCMD_POWERON;
   command.header.sub_code      = 0x00;
   command.power_on_param.enable_sound_effect = AS_DISABLE_SOUNDEFFECT;
-  AS_SendAudioCommand(&command);
 
-  AudioResult result;
-  AS_ReceiveAudioResult(&result);
-
-  if (result.header.result_code != AUDRLT_STATUSCHANGED)
+  if (exec_command(&command, AUDRLT_STATUSCHANGED) != AUDIOLIB_ECODE_OK)
     {
-      print_err("ERROR: Command(0x%x) fails. Result code(0x%x) Module id(%d) Error code(0x%lx) subcode(0x%lx)\n",
-                command.header.command_code, result.header.result_code, result.error_response_param.module_id,
-                result.error_response_param.error_code, result.error_response_param.error_sub_code);
-      print_dbg("ERROR: %s\n", error_msg[result.error_response_param.error_code]);
       return AUDIOLIB_ECODE_AUDIOCOMMAND_ERROR;
     }
 
@@ -458,17 +462,9 @@ err_t AudioClass::powerOff(void)
   command.header.packet_length = LENGTH_SET_POWEROFF_STATUS;
   command.header.command_code  = AUDCMD_SETPOWEROFFSTATUS;
   command.header.sub_code      = 0x00;
-  AS_SendAudioCommand(&command);
 
-  AudioResult result;
-  AS_ReceiveAudioResult(&result);
-
-  if (result.header.result_code != AUDRLT_STATUSCHANGED)
+  if (exec_command(&command, AUDRLT_STATUSCHANGED) != AUDIOLIB_ECODE_OK)
     {
-      print_err("ERROR: Command(0x%x) fails. Result code(0x%x) Module id(%d) Error code(0x%lx) subcode(0x%lx)\n",
-                command.header.command_code, result.header.result_code, result.error_response_param.module_id,
-                result.error_response_param.error_code, result.error_response_param.error_sub_code);
-      print_dbg("ERROR: %s\n", error_msg[result.error_response_param.error_code]);
       return AUDIOLIB_ECODE_AUDIOCOMMAND_ERROR;
     }
 
@@ -484,17 +480,9 @@ err_t AudioClass::setReadyMode(void)
   command.header.packet_length = LENGTH_SET_READY_STATUS;
   command.header.command_code  = AUDCMD_SETREADYSTATUS;
   command.header.sub_code      = 0x00;
-  AS_SendAudioCommand(&command);
 
-  AudioResult result;
-  AS_ReceiveAudioResult(&result);
-
-  if (result.header.result_code != AUDRLT_STATUSCHANGED)
+  if (exec_command(&command, AUDRLT_STATUSCHANGED) != AUDIOLIB_ECODE_OK)
     {
-      print_err("ERROR: Command(0x%x) fails. Result code(0x%x) Module id(%d) Error code(0x%lx) subcode(0x%lx)\n",
-                command.header.command_code, result.header.result_code, result.error_response_param.module_id,
-                result.error_response_param.error_code, result.error_response_param.error_sub_code);
-      print_dbg("ERROR: %s\n", error_msg[result.error_response_param.error_code]);
       return AUDIOLIB_ECODE_AUDIOCOMMAND_ERROR;
     }
 
@@ -536,9 +524,18 @@ err_t AudioClass::setPlayerMode(uint8_t device, uint8_t sp_drv, uint32_t player0
   assert(layout_no < NUM_MEM_LAYOUTS);
   createStaticPools(layout_no);
 
+  /* Output settings are sent without waiting for the results,
+   * and completed together with the status change below.
+   */
+
+  bool batch = m_cmd_batch;
+  m_cmd_batch = true;
+
   AudioClass::set_output(device, sp_drv);
 
-  print_dbg("set output cmplt\n");
+  m_cmd_batch = batch;
+
+  print_dbg("set output posted\n");
 
   /* Allocate ES buffer */
 
@@ -580,11 +577,28 @@ err_t AudioClass::setPlayerMode(uint8_t device, uint8_t sp_drv, uint32_t player0
         }
     }
 
+  /* Default watermarks for fillFrames() and waitFrames(). */
+
+  m_player_fifo_size[0] = (m_player0_simple_fifo_buf) ? player0bufsize : 0;
+  m_player_fifo_size[1] = (m_player1_simple_fifo_buf) ? player1bufsize : 0;
+
+  m_metrics.setCapacity(AUDIOMETRICS_FIFO_PLAYER0, m_player_fifo_size[0]);
+  m_metrics.setCapacity(AUDIOMETRICS_FIFO_PLAYER1, m_player_fifo_size[1]);
+
+  for (int i = 0; i < 2; i++)
+    {
+      m_player_high_wm[i]    = m_player_fifo_size[i];
+      m_player_low_wm[i]     = m_player_fifo_size[i] / 2;
+      m_player_wm_waiting[i] = false;
+    }
+
+  /* Player calls back when it takes data from FIFO. */
+
   m_player0_input_device_handler.simple_fifo_handler = (void*)(&m_player0_simple_fifo_handle);
-  m_player0_input_device_handler.callback_function = input_device_callback; /*??*/
+  m_player0_input_device_handler.callback_function = player0_input_callback;
 
   m_player1_input_device_handler.simple_fifo_handler = (void*)(&m_player1_simple_fifo_handle);
-  m_player1_input_device_handler.callback_function = input_device_callback; /*??*/
+  m_player1_input_device_handler.callback_function = player1_input_callback;
 
   AudioCommand command;
   command.header.packet_length = LENGTH_SET_PLAYER_STATUS;
@@ -599,17 +613,8 @@ err_t AudioClass::setPlayerMode(uint8_t device, uint8_t sp_drv, uint32_t player0
   command.set_player_sts_param.player1.ram_handler   = &m_player1_input_device_handler;
   command.set_player_sts_param.player1.output_device = device;
 
-  AS_SendAudioCommand(&command);
-
-  AudioResult result;
-  AS_ReceiveAudioResult(&result);
-
-  if (result.header.result_code != AUDRLT_STATUSCHANGED)
+  if (exec_command(&command, AUDRLT_STATUSCHANGED) != AUDIOLIB_ECODE_OK)
     {
-      print_err("ERROR: Command(0x%x) fails. Result code(0x%x) Module id(%d) Error code(0x%lx) subcode(0x%lx)\n",
-                command.header.command_code, result.header.result_code, result.error_response_param.module_id,
-                result.error_response_param.error_code, result.error_response_param.error_sub_code);
-      print_dbg("ERROR: %s\n", error_msg[result.error_response_param.error_code]);
       return AUDIOLIB_ECODE_AUDIOCOMMAND_ERROR;
     }
 
@@ -661,6 +666,8 @@ err_t AudioClass::initPlayer(PlayerId id, uint8_t codec_type, const char* codec_
   command.player.init_param.sampling_rate = sampling_rate;
   snprintf(command.player.init_param.dsp_path, AS_AUDIO_DSP_PATH_LEN, "%s", codec_path);
 
+  flush_commands();
+
   AS_SendAudioCommand(&command);
 
   AudioResult result;
@@ -690,6 +697,8 @@ err_t AudioClass::startPlayer(PlayerId id)
 
   command.player.player_id = (id == Player0) ? AS_PLAYER_ID_0 : AS_PLAYER_ID_1;
 
+  flush_commands();
+
   AS_SendAudioCommand(&command);
 
   AudioResult result;
@@ -720,17 +729,9 @@ err_t AudioClass::setBeep(char en, short vol, short freq)
   command.set_beep_param.beep_en   = en;
   command.set_beep_param.beep_vol  = vol;
   command.set_beep_param.beep_freq = freq;
-  AS_SendAudioCommand(&command);
-
-  AudioResult result;
-  AS_ReceiveAudioResult(&result);
 
-  if (result.header.result_code != AUDRLT_SETBEEPCMPLT)
+  if (send_command(&command, AUDRLT_SETBEEPCMPLT) != AUDIOLIB_ECODE_OK)
     {
-      print_err("ERROR: Command(0x%x) fails. Result code(0x%x) Module id(%d) Error code(0x%lx) subcode(0x%lx)\n",
-                command.header.command_code, result.header.result_code, result.error_response_param.module_id,
-                result.error_response_param.error_code, result.error_response_param.error_sub_code);
-      print_dbg("ERROR: %s\n", error_msg[result.error_response_param.error_code]);
       return AUDIOLIB_ECODE_AUDIOCOMMAND_ERROR;
     }
 
@@ -755,6 +756,8 @@ err_t AudioClass::stopPlayer(PlayerId id, uint8_t mode)
   command.player.player_id = (id == Player0) ? AS_PLAYER_ID_0 : AS_PLAYER_ID_1;
   command.player.stop_param.stop_mode = mode;
 
+  flush_commands();
+
   AS_SendAudioCommand(&command);
 
   AudioResult result;
@@ -789,17 +792,8 @@ err_t AudioClass::setVolume(int master_db)
   command.set_volume_param.input2_db = 0; /* 0dB */
   command.set_volume_param.master_db = master_db;
 
-  AS_SendAudioCommand(&command);
-
-  AudioResult result;
-  AS_ReceiveAudioResult(&result);
-
-  if (result.header.result_code != AUDRLT_SETVOLUMECMPLT)
+  if (send_command(&command, AUDRLT_SETVOLUMECMPLT) != AUDIOLIB_ECODE_OK)
     {
-      print_err("ERROR: Command(0x%x) fails. Result code(0x%x) Module id(%d) Error code(0x%lx) subcode(0x%lx)\n",
-                command.header.command_code, result.header.result_code, result.error_response_param.module_id,
-                result.error_response_param.error_code, result.error_response_param.error_sub_code);
-      print_dbg("ERROR: %s\n", error_msg[result.error_response_param.error_code]);
       return AUDIOLIB_ECODE_AUDIOCOMMAND_ERROR;
     }
 
@@ -819,17 +813,8 @@ err_t AudioClass::setVolume(int master, int player0, int player1)
   command.set_volume_param.input2_db = player1;
   command.set_volume_param.master_db = master;
 
-  AS_SendAudioCommand(&command);
-
-  AudioResult result;
-  AS_ReceiveAudioResult(&result);
-
-  if (result.header.result_code != AUDRLT_SETVOLUMECMPLT)
+  if (send_command(&command, AUDRLT_SETVOLUMECMPLT) != AUDIOLIB_ECODE_OK)
     {
-      print_err("ERROR: Command(0x%x) fails. Result code(0x%x) Module id(%d) Error code(0x%lx) subcode(0x%lx)\n",
-                command.header.command_code, result.header.result_code, result.error_response_param.module_id,
-                result.error_response_param.error_code, result.error_response_param.error_sub_code);
-      print_dbg("ERROR: %s\n", error_msg[result.error_response_param.error_code]);
       return AUDIOLIB_ECODE_AUDIOCOMMAND_ERROR;
     }
 
@@ -849,17 +834,8 @@ err_t AudioClass::setLRgain(PlayerId id, unsigned char l_gain, unsigned char r_g
   command.player.set_gain_param.l_gain = l_gain;
   command.player.set_gain_param.r_gain = r_gain;
 
-  AS_SendAudioCommand(&command);
-
-  AudioResult result;
-  AS_ReceiveAudioResult(&result);
-
-  if (result.header.result_code != AUDRLT_SETGAIN_CMPLT)
+  if (send_command(&command, AUDRLT_SETGAIN_CMPLT) != AUDIOLIB_ECODE_OK)
     {
-      print_err("ERROR: Command(0x%x) fails. Result code(0x%x) Module id(%d) Error code(0x%lx) subcode(0x%lx)\n",
-                command.header.command_code, result.header.result_code, result.error_response_param.module_id,
-                result.error_response_param.error_code, result.error_response_param.error_sub_code);
-      print_dbg("ERROR: %s\n", error_msg[result.error_response_param.error_code]);
       return AUDIOLIB_ECODE_AUDIOCOMMAND_ERROR;
     }
 
@@ -960,6 +936,144 @@ err_t AudioClass::writeFrames(PlayerId id, uint8_t *data, uint32_t write_size)
   return ret;
 }
 
+/*--------------------------------------------------------------------------*/
+err_t AudioClass::setPlayerWatermark(PlayerId id, uint32_t low, uint32_t high)
+{
+  int i = (id == Player0) ? 0 : 1;
+
+  if ((low >= high) || (high > m_player_fifo_size[i]))
+    {
+      print_err("ERROR: Invalid watermark.\n");
+      return AUDIOLIB_ECODE_PARAMETER_ERROR;
+    }
+
+  m_player_low_wm[i]  = low;
+  m_player_high_wm[i] = high;
+
+  return AUDIOLIB_ECODE_OK;
+}
+
+/*--------------------------------------------------------------------------*/
+err_t AudioClass::fillFrames(PlayerId id, File& myFile)
+{
+  int i = (id == Player0) ? 0 : 1;
+
+  uint32_t *p_fifo = (id == Player0)
+    ? m_player0_simple_fifo_buf : m_player1_simple_fifo_buf;
+
+  if (!p_fifo)
+    {
+      print_err("Buffer is not allocated.\n");
+      return AUDIOLIB_ECODE_SIMPLEFIFO_ERROR;
+    }
+
+  char *buf = (id == Player0) ? m_es_player0_buf : m_es_player1_buf;
+  uint32_t buf_size = (id == Player0) ? FIFO_FRAME_SIZE : WRITE_FIFO_FRAME_SIZE;
+  CMN_SimpleFifoHandle *handle = (id == Player0) ? &m_player0_simple_fifo_handle : &m_player1_simple_fifo_handle;
+
+  uint32_t occupied = CMN_SimpleFifoGetOccupiedSize(handle);
+
+  while (occupied < m_player_high_wm[i])
+    {
+      uint32_t size = m_player_high_wm[i] - occupied;
+      if (size > buf_size)
+        {
+          size = buf_size;
+        }
+
+      /* Never read more than the FIFO can take, or the data is lost. */
+
+      uint32_t vacant = CMN_SimpleFifoGetVacantSize(handle);
+      if (size > vacant)
+        {
+          size = vacant;
+        }
+
+      if (size == 0)
+        {
+          break;
+        }
+
+      int ret = myFile.read(buf, size);
+      if (ret < 0)
+        {
+          print_err("Fail to read file. errno:%d\n", get_errno());
+          return AUDIOLIB_ECODE_FILEACCESS_ERROR;
+        }
+
+      if (ret == 0)
+        {
+          return AUDIOLIB_ECODE_FILEEND;
+        }
+
+      if (CMN_SimpleFifoOffer(handle, (const void*)buf, ret) == 0)
+        {
+          print_err("Simple FIFO is full!\n");
+          return AUDIOLIB_ECODE_SIMPLEFIFO_ERROR;
+        }
+
+      occupied += ret;
+    }
+
+  return AUDIOLIB_ECODE_OK;
+}
+
+/*--------------------------------------------------------------------------*/
+err_t AudioClass::waitFrames(PlayerId id, uint32_t timeout_ms)
+{
+  int i = (id == Player0) ? 0 : 1;
+  CMN_SimpleFifoHandle *handle = (id == Player0) ? &m_player0_simple_fifo_handle : &m_player1_simple_fifo_handle;
+
+  if (!m_player_fifo_size[i])
+    {
+      print_err("Buffer is not allocated.\n");
+      return AUDIOLIB_ECODE_SIMPLEFIFO_ERROR;
+    }
+
+  /* Discard stale notifications, and then arm the player callback. */
+
+  while (sem_trywait(&m_player_wm_sem[i]) == 0);
+
+  m_player_wm_waiting[i] = true;
+
+  if (CMN_SimpleFifoGetOccupiedSize(handle) <= m_player_low_wm[i])
+    {
+      m_player_wm_waiting[i] = false;
+      return AUDIOLIB_ECODE_OK;
+    }
+
+  int ret;
+
+  if (timeout_ms == 0)
+    {
+      while ((ret = sem_wait(&m_player_wm_sem[i])) < 0 && errno == EINTR);
+    }
+  else
+    {
+      struct timespec abstime;
+
+      clock_gettime(CLOCK_REALTIME, &abstime);
+      abstime.tv_sec  += timeout_ms / 1000;
+      abstime.tv_nsec += (timeout_ms % 1000) * 1000000;
+      if (abstime.tv_nsec >= 1000000000)
+        {
+          abstime.tv_sec++;
+          abstime.tv_nsec -= 1000000000;
+        }
+
+      while ((ret = sem_timedwait(&m_player_wm_sem[i], &abstime)) < 0 && errno == EINTR);
+    }
+
+  m_player_wm_waiting[i] = false;
+
+  if (ret < 0)
+    {
+      return (errno == ETIMEDOUT) ? AUDIOLIB_ECODE_TIMEOUT : AUDIOLIB_ECODE_SIMPLEFIFO_ERROR;
+    }
+
+  return AUDIOLIB_ECODE_OK;
+}
+
 /****************************************************************************
  * Recoder API on Audio Class
  ****************************************************************************/
@@ -1002,17 +1116,37 @@ err_t AudioClass::setRecorderMode(uint8_t input_device, int32_t input_gain, uint
 
   CMN_SimpleFifoClear(&m_recorder_simple_fifo_handle);
 
+  m_metrics.setCapacity(AUDIOMETRICS_FIFO_RECORDER, bufsize);
+
   m_output_device_handler.simple_fifo_handler = (void*)(&m_recorder_simple_fifo_handle);
-  m_output_device_handler.callback_function = output_device_callback;
+  m_output_device_handler.callback_function = recorder_output_callback;
+
+  /* Complete the posted commands before the mode change. */
+
+  if (flush_commands() != AUDIOLIB_ECODE_OK)
+    {
+      return AUDIOLIB_ECODE_AUDIOCOMMAND_ERROR;
+    }
+
+  /* Mic mapping is sent together with the status change below. Both of
+   * them are in flight at once, so the queue must hold two commands.
+   */
+
+  static_assert(AUDIOLIB_COMMAND_QUEUE_SIZE >= 2,
+                "setRecorderMode() posts two commands at once");
 
-  if ((input_device == AS_SETRECDR_STS_INPUTDEVICE_MIC) && is_digital)
+  bool mic_map = (input_device == AS_SETRECDR_STS_INPUTDEVICE_MIC) && is_digital;
+
+  if (mic_map)
     {
       uint8_t dig_map[] = { 0x5, 0x6, 0x7, 0x8, 0x9, 0xa, 0xb, 0xc };
 
-      if (set_mic_map(dig_map) != AUDIOLIB_ECODE_OK)
-        {
-          print_err("Set mic mapping error!\n");
-        }
+      bool batch = m_cmd_batch;
+      m_cmd_batch = true;
+
+      set_mic_map(dig_map);
+
+      m_cmd_batch = batch;
     }
 
   AudioCommand command;
@@ -1026,17 +1160,17 @@ err_t AudioClass::setRecorderMode(uint8_t input_device, int32_t input_gain, uint
   command.set_recorder_status_param.output_device = AS_SETRECDR_STS_OUTPUTDEVICE_RAM;
   command.set_recorder_status_param.output_device_handler = &m_output_device_handler;
 
-  AS_SendAudioCommand(&command);
+  post_command(&command, AUDRLT_STATUSCHANGED);
 
-  AudioResult result;
-  AS_ReceiveAudioResult(&result);
+  /* A mic mapping error is only reported, and recording is started. */
 
-  if (result.header.result_code != AUDRLT_STATUSCHANGED)
+  if (mic_map && (complete_command() != AUDIOLIB_ECODE_OK))
+    {
+      print_err("Set mic mapping error!\n");
+    }
+
+  if (complete_command() != AUDIOLIB_ECODE_OK)
     {
-      print_err("ERROR: Command(0x%x) fails. Result code(0x%x) Module id(%d) Error code(0x%lx) subcode(0x%lx)\n",
-                command.header.command_code, result.header.result_code, result.error_response_param.module_id,
-                result.error_response_param.error_code, result.error_response_param.error_sub_code);
-      print_dbg("ERROR: %s\n", error_msg[result.error_response_param.error_code]);
       return AUDIOLIB_ECODE_AUDIOCOMMAND_ERROR;
     }
 
@@ -1075,16 +1209,9 @@ err_t AudioClass::initMicFrontend(uint8_t ch_num, uint8_t bit_length, uint16_t s
            AS_PREPROCESS_FILE_PATH_LEN, "%c",
            '\0');
   command.init_micfrontend_param.data_dest = AsMicFrontendDataToRecorder;
-  AS_SendAudioCommand(&command);
 
-  AudioResult result;
-  AS_ReceiveAudioResult(&result);
-  if (result.header.result_code != AUDRLT_INIT_MICFRONTEND)
+  if (exec_command(&command, AUDRLT_INIT_MICFRONTEND) != AUDIOLIB_ECODE_OK)
     {
-      print_err("ERROR: Command(0x%x) fails. Result code(0x%x) Module id(%d) Error code(0x%lx) subcode(0x%lx)\n",
-                command.header.command_code, result.header.result_code, result.error_response_param.module_id,
-                result.error_response_param.error_code, result.error_response_param.error_sub_code);
-      print_dbg("ERROR: %s\n", error_msg[result.error_response_param.error_code]);
       return AUDIOLIB_ECODE_AUDIOCOMMAND_ERROR;
     }
 
@@ -1098,16 +1225,9 @@ err_t AudioClass::init_recorder_wav(AudioCommand* command, uint32_t sampling_rat
   command->recorder.init_param.channel_number = channel_number;
   command->recorder.init_param.bit_length     = bit_length;
   command->recorder.init_param.codec_type     = AS_CODECTYPE_PCM;
-  AS_SendAudioCommand(command);
 
-  AudioResult result;
-  AS_ReceiveAudioResult(&result);
-  if (result.header.result_code != AUDRLT_INITRECCMPLT)
+  if (exec_command(command, AUDRLT_INITRECCMPLT) != AUDIOLIB_ECODE_OK)
     {
-      print_err("ERROR: Command(0x%x) fails. Result code(0x%x) Module id(%d) Error code(0x%lx) subcode(0x%lx)\n",
-                command->header.command_code, result.header.result_code, result.error_response_param.module_id,
-                result.error_response_param.error_code, result.error_response_param.error_sub_code);
-      print_dbg("ERROR: %s\n", error_msg[result.error_response_param.error_code]);
       return AUDIOLIB_ECODE_AUDIOCOMMAND_ERROR;
     }
 
@@ -1134,16 +1254,9 @@ err_t AudioClass::init_recorder_mp3(AudioCommand* command, uint32_t sampling_rat
   command->recorder.init_param.bit_length     = bit_length;
   command->recorder.init_param.codec_type     = m_codec_type;
   command->recorder.init_param.bitrate        = AS_BITRATE_96000;
-  AS_SendAudioCommand(command);
 
-  AudioResult result;
-  AS_ReceiveAudioResult(&result);
-  if (result.header.result_code != AUDRLT_INITRECCMPLT)
+  if (exec_command(command, AUDRLT_INITRECCMPLT) != AUDIOLIB_ECODE_OK)
     {
-      print_err("ERROR: Command(0x%x) fails. Result code(0x%x) Module id(%d) Error code(0x%lx) subcode(0x%lx)\n",
-                command->header.command_code, result.header.result_code, result.error_response_param.module_id,
-                result.error_response_param.error_code, result.error_response_param.error_sub_code);
-      print_dbg("ERROR: %s\n", error_msg[result.error_response_param.error_code]);
       return AUDIOLIB_ECODE_AUDIOCOMMAND_ERROR;
     }
 
@@ -1159,16 +1272,9 @@ err_t AudioClass::init_recorder_opus(AudioCommand* command, uint32_t sampling_ra
   command->recorder.init_param.codec_type     = m_codec_type;
   command->recorder.init_param.bitrate        = AS_BITRATE_8000;
   command->recorder.init_param.computational_complexity = AS_INITREC_COMPLEXITY_0;
-  AS_SendAudioCommand(command);
 
-  AudioResult result;
-  AS_ReceiveAudioResult(&result);
-  if (result.header.result_code != AUDRLT_INITRECCMPLT)
+  if (exec_command(command, AUDRLT_INITRECCMPLT) != AUDIOLIB_ECODE_OK)
     {
-      print_err("ERROR: Command(0x%x) fails. Result code(0x%x) Module id(%d) Error code(0x%lx) subcode(0x%lx)\n",
-                command->header.command_code, result.header.result_code, result.error_response_param.module_id,
-                result.error_response_param.error_code, result.error_response_param.error_sub_code);
-      print_dbg("ERROR: %s\n", error_msg[result.error_response_param.error_code]);
       return AUDIOLIB_ECODE_AUDIOCOMMAND_ERROR;
     }
 
@@ -1182,16 +1288,9 @@ err_t AudioClass::init_recorder_pcm(AudioCommand* command, uint32_t sampling_rat
   command->recorder.init_param.channel_number = channel_number;
   command->recorder.init_param.bit_length     = bit_length;
   command->recorder.init_param.codec_type     = m_codec_type;
-  AS_SendAudioCommand(command);
 
-  AudioResult result;
-  AS_ReceiveAudioResult(&result);
-  if (result.header.result_code != AUDRLT_INITRECCMPLT)
+  if (exec_command(command, AUDRLT_INITRECCMPLT) != AUDIOLIB_ECODE_OK)
     {
-      print_err("ERROR: Command(0x%x) fails. Result code(0x%x) Module id(%d) Error code(0x%lx) subcode(0x%lx)\n",
-                command->header.command_code, result.header.result_code, result.error_response_param.module_id,
-                result.error_response_param.error_code, result.error_response_param.error_sub_code);
-      print_dbg("ERROR: %s\n", error_msg[result.error_response_param.error_code]);
       return AUDIOLIB_ECODE_AUDIOCOMMAND_ERROR;
     }
 
@@ -1278,17 +1377,8 @@ err_t AudioClass::startRecorder(void)
   command.header.command_code  = AUDCMD_STARTREC;
   command.header.sub_code      = 0x00;
 
-  AS_SendAudioCommand(&command);
-
-  AudioResult result;
-  AS_ReceiveAudioResult(&result);
-
-  if (result.header.result_code != AUDRLT_RECCMPLT)
+  if (exec_command(&command, AUDRLT_RECCMPLT) != AUDIOLIB_ECODE_OK)
     {
-      print_err("ERROR: Command(0x%x) fails. Result code(0x%x) Module id(%d) Error code(0x%lx) subcode(0x%lx)\n",
-                command.header.command_code, result.header.result_code, result.error_response_param.module_id,
-                result.error_response_param.error_code, result.error_response_param.error_sub_code);
-      print_dbg("ERROR: %s\n", error_msg[result.error_response_param.error_code]);
       return AUDIOLIB_ECODE_AUDIOCOMMAND_ERROR;
     }
 
@@ -1306,17 +1396,8 @@ err_t AudioClass::stopRecorder(void)
   command.header.command_code  = AUDCMD_STOPREC;
   command.header.sub_code      = 0x00;
 
-  AS_SendAudioCommand(&command);
-
-  AudioResult result;
-  AS_ReceiveAudioResult(&result);
-
-  if (result.header.result_code != AUDRLT_STOPRECCMPLT)
+  if (exec_command(&command, AUDRLT_STOPRECCMPLT) != AUDIOLIB_ECODE_OK)
     {
-      print_err("ERROR: Command(0x%x) fails. Result code(0x%x) Module id(%d) Error code(0x%lx) subcode(0x%lx)\n",
-                command.header.command_code, result.header.result_code, result.error_response_param.module_id,
-                result.error_response_param.error_code, result.error_response_param.error_sub_code);
-      print_dbg("ERROR: %s\n", error_msg[result.error_response_param.error_code]);
       return AUDIOLIB_ECODE_AUDIOCOMMAND_ERROR;
     }
 
@@ -1365,34 +1446,38 @@ err_t AudioClass::writeWavHeader(File& myFile)
 /*--------------------------------------------------------------------------*/
 err_t AudioClass::readFrames(File& myFile)
 {
-  if (!m_recorder_simple_fifo_buf)
+  const uint8_t *area[2];
+  uint32_t size[2];
+
+  err_t rst = peekFrames(&area[0], &size[0], &area[1], &size[1]);
+  if (rst != AUDIOLIB_ECODE_OK)
     {
-      print_err("ERROR: FIFO area is not allocated.\n");
-      return AUDIOLIB_ECODE_SIMPLEFIFO_ERROR;
+      return rst;
     }
 
-  size_t data_size = CMN_SimpleFifoGetOccupiedSize(&m_recorder_simple_fifo_handle);
-  print_dbg("dsize = %d\n", data_size);
+  print_dbg("dsize = %d\n", size[0] + size[1]);
 
-  while (data_size > 0)
-    {
-      int size = (data_size > FIFO_FRAME_SIZE) ? FIFO_FRAME_SIZE : data_size;
+  /* Write recorded data to the file directly from FIFO. */
 
-      if (CMN_SimpleFifoPoll(&m_recorder_simple_fifo_handle, (void*)m_es_recorder_buf, size) == 0)
+  for (int i = 0; i < 2; i++)
+    {
+      if (size[i] == 0)
         {
-          print_err("ERROR: Fail to get data from simple FIFO.\n");
-          return AUDIOLIB_ECODE_SIMPLEFIFO_ERROR;
+          continue;
         }
 
-      int ret = myFile.write((uint8_t*)&m_es_recorder_buf, size);
-      m_es_size += size;
-      data_size -= size;
-
+      int ret = myFile.write(area[i], size[i]);
       if (ret < 0)
         {
           print_err("ERROR: Cannot write recorded data to output file.\n");
           return AUDIOLIB_ECODE_FILEACCESS_ERROR;
         }
+
+      rst = releaseFrames(size[i]);
+      if (rst != AUDIOLIB_ECODE_OK)
+        {
+          return rst;
+        }
     }
 
   return AUDIOLIB_ECODE_OK;
@@ -1451,6 +1536,80 @@ err_t AudioClass::readFrames(char* p_buffer, uint32_t buffer_size, uint32_t* rea
   return rst;
 }
 
+/*--------------------------------------------------------------------------*/
+err_t AudioClass::peekFrames(const uint8_t** area1, uint32_t* size1, const uint8_t** area2, uint32_t* size2)
+{
+  if (!area1 || !size1 || !area2 || !size2)
+    {
+      print_err("ERROR: Area not specified.\n");
+      return AUDIOLIB_ECODE_BUFFER_AREA_ERROR;
+    }
+
+  *area1 = NULL;
+  *size1 = 0;
+  *area2 = NULL;
+  *size2 = 0;
+
+  if (!m_recorder_simple_fifo_buf)
+    {
+      print_err("ERROR: FIFO area is not allocated.\n");
+      return AUDIOLIB_ECODE_SIMPLEFIFO_ERROR;
+    }
+
+  size_t data_size = CMN_SimpleFifoGetOccupiedSize(&m_recorder_simple_fifo_handle);
+  if (data_size == 0)
+    {
+      return AUDIOLIB_ECODE_OK;
+    }
+
+  CMN_SimpleFifoPeekHandle peek_handle;
+  if (CMN_SimpleFifoPeek(&m_recorder_simple_fifo_handle, &peek_handle, data_size) == 0)
+    {
+      print_err("ERROR: Fail to peek data in simple FIFO.\n");
+      return AUDIOLIB_ECODE_SIMPLEFIFO_ERROR;
+    }
+
+  *area1 = (const uint8_t*)peek_handle.m_pChunk1;
+  *size1 = (uint32_t)peek_handle.m_sz1;
+  *area2 = (const uint8_t*)peek_handle.m_pChunk2;
+  *size2 = (uint32_t)peek_handle.m_sz2;
+
+  return AUDIOLIB_ECODE_OK;
+}
+
+/*--------------------------------------------------------------------------*/
+err_t AudioClass::releaseFrames(uint32_t size)
+{
+  if (!m_recorder_simple_fifo_buf)
+    {
+      print_err("ERROR: FIFO area is not allocated.\n");
+      return AUDIOLIB_ECODE_SIMPLEFIFO_ERROR;
+    }
+
+  if (size == 0)
+    {
+      return AUDIOLIB_ECODE_OK;
+    }
+
+  if (size > CMN_SimpleFifoGetOccupiedSize(&m_recorder_simple_fifo_handle))
+    {
+      print_err("ERROR: Release size exceeds recorded data.\n");
+      return AUDIOLIB_ECODE_PARAMETER_ERROR;
+    }
+
+  /* Poll without destination buffer only moves read pointer of FIFO. */
+
+  if (CMN_SimpleFifoPoll(&m_recorder_simple_fifo_handle, NULL, size) == 0)
+    {
+      print_err("ERROR: Fail to release data in simple FIFO.\n");
+      return AUDIOLIB_ECODE_SIMPLEFIFO_ERROR;
+    }
+
+  m_es_size += size;
+
+  return AUDIOLIB_ECODE_OK;
+}
+
 /*--------------------------------------------------------------------------*/
 err_t AudioClass::setRenderingClockMode(AsClkMode mode)
 {
@@ -1461,17 +1620,8 @@ err_t AudioClass::setRenderingClockMode(AsClkMode mode)
   command.header.sub_code      = 0x00;
   command.set_renderingclk_param.clk_mode = mode;
 
-  AS_SendAudioCommand(&command);
-
-  AudioResult result;
-  AS_ReceiveAudioResult(&result);
-
-  if (result.header.result_code != AUDRLT_SETRENDERINGCLKCMPLT)
+  if (send_command(&command, AUDRLT_SETRENDERINGCLKCMPLT) != AUDIOLIB_ECODE_OK)
     {
-      print_err("ERROR: Command(0x%x) fails. Result code(0x%x) Module id(%d) Error code(0x%lx) subcode(0x%lx)\n",
-                command.header.command_code, result.header.result_code, result.error_response_param.module_id,
-                result.error_response_param.error_code, result.error_response_param.error_sub_code);
-      print_dbg("ERROR: %s\n", error_msg[result.error_response_param.error_code]);
       return AUDIOLIB_ECODE_AUDIOCOMMAND_ERROR;
     }
 
@@ -1483,6 +1633,19 @@ err_t AudioClass::setRenderingClockMode(AsClkMode mode)
  ****************************************************************************/
 err_t AudioClass::setThroughMode(ThroughInput input, ThroughI2sOut i2s_out, bool sp_out, int32_t input_gain, uint8_t sp_drv)
 {
+  /* The output and mic settings, and the through paths, are sent without
+   * waiting for the results. The status change in between completes the
+   * posted commands before and after itself.
+   */
+
+  if ((input != MicIn) && (input != I2sIn) && (input != BothIn))
+    {
+      return AUDIOLIB_ECODE_PARAMETER_ERROR;
+    }
+
+  bool batch = m_cmd_batch;
+  m_cmd_batch = true;
+
   if (i2s_out == None)
     {
       AudioClass::set_output(AS_SETPLAYER_OUTPUTDEVICE_SPHP, sp_drv);
@@ -1501,7 +1664,11 @@ err_t AudioClass::setThroughMode(ThroughInput input, ThroughI2sOut i2s_out, bool
     {
       case MicIn:
         init_mic_gain(AS_SETRECDR_STS_INPUTDEVICE_MIC,input_gain);
-        send_set_through();
+        if (send_set_through() != AUDIOLIB_ECODE_OK)
+          {
+            m_cmd_batch = batch;
+            return AUDIOLIB_ECODE_AUDIOCOMMAND_ERROR;
+          }
 
         command.set_through_path.path1.en  = true;
         command.set_through_path.path1.in  = AS_THROUGH_PATH_IN_MIC;
@@ -1509,7 +1676,11 @@ err_t AudioClass::setThroughMode(ThroughInput input, ThroughI2sOut i2s_out, bool
         break;
 
       case I2sIn:
-        send_set_through();
+        if (send_set_through() != AUDIOLIB_ECODE_OK)
+          {
+            m_cmd_batch = batch;
+            return AUDIOLIB_ECODE_AUDIOCOMMAND_ERROR;
+          }
 
         command.set_through_path.path1.en  = false;
         command.set_through_path.path2.en  = true;
@@ -1519,7 +1690,11 @@ err_t AudioClass::setThroughMode(ThroughInput input, ThroughI2sOut i2s_out, bool
 
       case BothIn:
         init_mic_gain(AS_SETRECDR_STS_INPUTDEVICE_MIC,input_gain);
-        send_set_through();
+        if (send_set_through() != AUDIOLIB_ECODE_OK)
+          {
+            m_cmd_batch = batch;
+            return AUDIOLIB_ECODE_AUDIOCOMMAND_ERROR;
+          }
 
         command.set_through_path.path1.en  = true;
         command.set_through_path.path1.in  = AS_THROUGH_PATH_IN_MIC;
@@ -1529,6 +1704,7 @@ err_t AudioClass::setThroughMode(ThroughInput input, ThroughI2sOut i2s_out, bool
         break;
 
       default:
+        m_cmd_batch = batch;
         return AUDIOLIB_ECODE_PARAMETER_ERROR; /* error. tentative. */
     }
 
@@ -1541,19 +1717,7 @@ err_t AudioClass::setThroughMode(ThroughInput input, ThroughI2sOut i2s_out, bool
       command.set_through_path.path1.out = AS_THROUGH_PATH_OUT_MIXER1;
     }
 
-  AS_SendAudioCommand(&command);
-
-  AudioResult result;
-  AS_ReceiveAudioResult(&result);
-
-  if (result.header.result_code != AUDRLT_SETTHROUGHPATHCMPLT)
-    {
-      print_err("ERROR: Command(0x%x) fails. Result code(0x%x) Module id(%d) Error code(0x%lx) subcode(0x%lx)\n",
-                command.header.command_code, result.header.result_code, result.error_response_param.module_id,
-                result.error_response_param.error_code, result.error_response_param.error_sub_code);
-      print_dbg("ERROR: %s\n", error_msg[result.error_response_param.error_code]);
-      return AUDIOLIB_ECODE_AUDIOCOMMAND_ERROR;
-    }
+  send_command(&command, AUDRLT_SETTHROUGHPATHCMPLT);
 
   if (i2s_out == Mixer)
     {
@@ -1562,18 +1726,18 @@ err_t AudioClass::setThroughMode(ThroughInput input, ThroughI2sOut i2s_out, bool
       command.set_through_path.path1.out = AS_THROUGH_PATH_OUT_I2S1;
       command.set_through_path.path2.en  = false;
 
-      AS_SendAudioCommand(&command);
+      send_command(&command, AUDRLT_SETTHROUGHPATHCMPLT);
+    }
+
+  m_cmd_batch = batch;
 
-      AS_ReceiveAudioResult(&result);
+  /* Collect the results even in batch mode, not to unmute the amplifier
+   * before the paths are set.
+   */
 
-      if (result.header.result_code != AUDRLT_SETTHROUGHPATHCMPLT)
-        {
-          print_err("ERROR: Command(0x%x) fails. Result code(0x%x) Module id(%d) Error code(0x%lx) subcode(0x%lx)\n",
-                    command.header.command_code, result.header.result_code, result.error_response_param.module_id,
-                    result.error_response_param.error_code, result.error_response_param.error_sub_code);
-          print_dbg("ERROR: %s\n", error_msg[result.error_response_param.error_code]);
-          return AUDIOLIB_ECODE_AUDIOCOMMAND_ERROR;
-        }
+  if (flush_commands() != AUDIOLIB_ECODE_OK)
+    {
+      return AUDIOLIB_ECODE_AUDIOCOMMAND_ERROR;
     }
 
   if (sp_out)
@@ -1584,19 +1748,208 @@ err_t AudioClass::setThroughMode(ThroughInput input, ThroughI2sOut i2s_out, bool
   return AUDIOLIB_ECODE_OK;
 }
 
+/****************************************************************************
+ * Command API on Audio Class
+ ****************************************************************************/
+void AudioClass::beginCommandBatch(AudioCommandCb cb)
+{
+  m_cmd_batch    = true;
+  m_cmd_callback = cb;
+  m_cmd_error    = AUDIOLIB_ECODE_OK;
+}
+
+/*--------------------------------------------------------------------------*/
+err_t AudioClass::endCommandBatch(void)
+{
+  flush_commands();
+
+  err_t ret = m_cmd_error;
+
+  m_cmd_batch    = false;
+  m_cmd_callback = NULL;
+  m_cmd_error    = AUDIOLIB_ECODE_OK;
+
+  return ret;
+}
+
+/*--------------------------------------------------------------------------*/
+err_t AudioClass::send_command(AudioCommand* command, uint8_t expected)
+{
+  if (m_cmd_batch)
+    {
+      post_command(command, expected);
+      return AUDIOLIB_ECODE_OK;
+    }
+
+  return exec_command(command, expected);
+}
+
+/*--------------------------------------------------------------------------*/
+err_t AudioClass::exec_command(AudioCommand* command, uint8_t expected)
+{
+  /* Complete the posted commands first, so that a state change never
+   * overlaps them. The first error is returned.
+   */
+
+  err_t ret = flush_commands();
+
+  post_command(command, expected);
+
+  err_t rst = complete_command();
+
+  return (ret != AUDIOLIB_ECODE_OK) ? ret : rst;
+}
+
+/*--------------------------------------------------------------------------*/
+void AudioClass::post_command(AudioCommand* command, uint8_t expected)
+{
+  if (m_cmd_count >= AUDIOLIB_COMMAND_QUEUE_SIZE)
+    {
+      complete_command();
+    }
+
+  uint32_t start = m_metrics.beginCommand();
+
+  AS_SendAudioCommand(command);
+
+  int tail = (m_cmd_head + m_cmd_count) % AUDIOLIB_COMMAND_QUEUE_SIZE;
+
+  m_cmd_queue[tail].command_code = command->header.command_code;
+  m_cmd_queue[tail].expected     = expected;
+  m_cmd_queue[tail].start        = start;
+  m_cmd_count++;
+}
+
+/*--------------------------------------------------------------------------*/
+err_t AudioClass::complete_command(void)
+{
+  AudioResult result;
+  AS_ReceiveAudioResult(&result);
+
+  uint8_t command_code = m_cmd_queue[m_cmd_head].command_code;
+  uint8_t expected     = m_cmd_queue[m_cmd_head].expected;
+
+  /* For batched commands, this includes the wait in the queue. */
+
+  m_metrics.endCommand(m_cmd_queue[m_cmd_head].start);
+
+  m_cmd_head = (m_cmd_head + 1) % AUDIOLIB_COMMAND_QUEUE_SIZE;
+  m_cmd_count--;
+
+  err_t ret = AUDIOLIB_ECODE_OK;
+
+  if (result.header.result_code != expected)
+    {
+      print_err("ERROR: Command(0x%x) fails. Result code(0x%x) Module id(%d) Error code(0x%lx) subcode(0x%lx)\n",
+                command_code, result.header.result_code, result.error_response_param.module_id,
+                result.error_response_param.error_code, result.error_response_param.error_sub_code);
+      print_dbg("ERROR: %s\n", error_msg[result.error_response_param.error_code]);
+      ret = AUDIOLIB_ECODE_AUDIOCOMMAND_ERROR;
+
+      if (m_cmd_error == AUDIOLIB_ECODE_OK)
+        {
+          m_cmd_error = ret;
+        }
+    }
+
+  if (m_cmd_callback)
+    {
+      m_cmd_callback(command_code, ret);
+    }
+
+  return ret;
+}
+
+/*--------------------------------------------------------------------------*/
+err_t AudioClass::flush_commands(void)
+{
+  err_t ret = AUDIOLIB_ECODE_OK;
+
+  while (m_cmd_count > 0)
+    {
+      err_t rst = complete_command();
+      if (ret == AUDIOLIB_ECODE_OK)
+        {
+          ret = rst;
+        }
+    }
+
+  return ret;
+}
+
 /****************************************************************************
  * Private API on Audio Player
  ****************************************************************************/
 extern "C" {
 /*--------------------------------------------------------------------------*/
-void  input_device_callback(uint32_t size)
+void AudioClass::player0_input_callback(uint32_t size)
 {
-    /* do nothing */
+  AudioClass::getInstance()->notify_consumed(Player0);
 }
+
 /*--------------------------------------------------------------------------*/
-void  output_device_callback(uint32_t size)
+void AudioClass::player1_input_callback(uint32_t size)
 {
-    /* do nothing */
+  AudioClass::getInstance()->notify_consumed(Player1);
+}
+
+/*--------------------------------------------------------------------------*/
+void AudioClass::notify_consumed(PlayerId id)
+{
+  int i = (id == Player0) ? 0 : 1;
+  CMN_SimpleFifoHandle *handle = (id == Player0) ? &m_player0_simple_fifo_handle : &m_player1_simple_fifo_handle;
+
+  if (m_metrics.isEnabled())
+    {
+      uint32_t occupied = CMN_SimpleFifoGetOccupiedSize(handle);
+
+      m_metrics.sampleFifo(i, occupied);
+      if (occupied == 0)
+        {
+          m_metrics.countUnderrun(i);
+        }
+    }
+
+  /* Wake up waitFrames() only once when FIFO reaches low watermark. */
+
+  if (m_player_wm_waiting[i] &&
+      CMN_SimpleFifoGetOccupiedSize(handle) <= m_player_low_wm[i])
+    {
+      m_player_wm_waiting[i] = false;
+      sem_post(&m_player_wm_sem[i]);
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+void AudioClass::recorder_output_callback(uint32_t size)
+{
+  AudioClass *audio = AudioClass::getInstance();
+
+  /* Dropped frames are counted by the attention of FIFO overflow. */
+
+  if (audio->m_metrics.isEnabled())
+    {
+      CMN_SimpleFifoHandle *handle = &audio->m_recorder_simple_fifo_handle;
+
+      audio->m_metrics.sampleFifo(AUDIOMETRICS_FIFO_RECORDER, CMN_SimpleFifoGetOccupiedSize(handle));
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+void AudioClass::attention_callback(const ErrorAttentionParam *attparam)
+{
+  AudioClass *audio = AudioClass::getInstance();
+
+  audio->m_metrics.logAttention(attparam);
+
+  if (audio->m_attention_callback)
+    {
+      audio->m_attention_callback(attparam);
+    }
+  else
+    {
+      attentionCallback(attparam);
+    }
 }
 
 }
@@ -1626,17 +1979,8 @@ err_t AudioClass::set_output(uint8_t device, uint8_t sp_drv)
     }
   command.init_output_select_param.output_device_sel = device;
 
-  AS_SendAudioCommand(&command);
-
-  AudioResult result;
-  AS_ReceiveAudioResult(&result);
-
-  if (result.header.result_code != AUDRLT_INITOUTPUTSELECTCMPLT)
+  if (send_command(&command, AUDRLT_INITOUTPUTSELECTCMPLT) != AUDIOLIB_ECODE_OK)
     {
-      print_err("ERROR: Command(0x%x) fails. Result code(0x%x) Module id(%d) Error code(0x%lx) subcode(0x%lx)\n",
-                command.header.command_code, result.header.result_code, result.error_response_param.module_id,
-                result.error_response_param.error_code, result.error_response_param.error_sub_code);
-      print_dbg("ERROR: %s\n", error_msg[result.error_response_param.error_code]);
       return AUDIOLIB_ECODE_AUDIOCOMMAND_ERROR;
     }
 
@@ -1647,16 +1991,8 @@ err_t AudioClass::set_output(uint8_t device, uint8_t sp_drv)
   command.header.sub_code      = 0;
   command.set_sp_drv_mode.mode = sp_drv;
 
-  AS_SendAudioCommand(&command);
-
-  AS_ReceiveAudioResult(&result);
-
-  if (result.header.result_code != AUDRLT_SETSPDRVMODECMPLT)
+  if (send_command(&command, AUDRLT_SETSPDRVMODECMPLT) != AUDIOLIB_ECODE_OK)
     {
-      print_err("ERROR: Command(0x%x) fails. Result code(0x%x) Module id(%d) Error code(0x%lx) subcode(0x%lx)\n",
-                command.header.command_code, result.header.result_code, result.error_response_param.module_id,
-                result.error_response_param.error_code, result.error_response_param.error_sub_code);
-      print_dbg("ERROR: %s\n", error_msg[result.error_response_param.error_code]);
       return AUDIOLIB_ECODE_AUDIOCOMMAND_ERROR;
     }
 
@@ -1752,17 +2088,8 @@ err_t AudioClass::set_mic_map(uint8_t map[AS_MIC_CHANNEL_MAX])
 
   memcpy(command.set_mic_map_param.mic_map, map, sizeof(command.set_mic_map_param.mic_map));
 
-  AS_SendAudioCommand( &command );
-
-  AudioResult result;
-  AS_ReceiveAudioResult(&result);
-
-  if (result.header.result_code != AUDRLT_SETMICMAPCMPLT)
+  if (send_command(&command, AUDRLT_SETMICMAPCMPLT) != AUDIOLIB_ECODE_OK)
     {
-      print_err("ERROR: Command(0x%x) fails. Result code(0x%x) Module id(%d) Error code(0x%lx) subcode(0x%lx)\n",
-                command.header.command_code, result.header.result_code, result.error_response_param.module_id,
-                result.error_response_param.error_code, result.error_response_param.error_sub_code);
-      print_dbg("ERROR: %s\n", error_msg[result.error_response_param.error_code]);
       return AUDIOLIB_ECODE_AUDIOCOMMAND_ERROR;
     }
 
@@ -1790,17 +2117,8 @@ err_t AudioClass::init_mic_gain(int dev, int gain)
   command.init_mic_gain_param.mic_gain[6] = 0;
   command.init_mic_gain_param.mic_gain[7] = 0;
 
-  AS_SendAudioCommand( &command );
-
-  AudioResult result;
-  AS_ReceiveAudioResult(&result);
-
-  if (result.header.result_code != AUDRLT_INITMICGAINCMPLT)
+  if (send_command(&command, AUDRLT_INITMICGAINCMPLT) != AUDIOLIB_ECODE_OK)
     {
-      print_err("ERROR: Command(0x%x) fails. Result code(0x%x) Module id(%d) Error code(0x%lx) subcode(0x%lx)\n",
-                command.header.command_code, result.header.result_code, result.error_response_param.module_id,
-                result.error_response_param.error_code, result.error_response_param.error_sub_code);
-      print_dbg("ERROR: %s\n", error_msg[result.error_response_param.error_code]);
       return AUDIOLIB_ECODE_AUDIOCOMMAND_ERROR;
     }
 
@@ -1818,17 +2136,8 @@ err_t AudioClass::send_set_through(void)
   command.header.command_code = AUDCMD_SETTHROUGHSTATUS;
   command.header.sub_code = 0x00;
 
-  AS_SendAudioCommand(&command);
-
-  AudioResult result;
-  AS_ReceiveAudioResult(&result);
-
-  if (result.header.result_code != AUDRLT_STATUSCHANGED)
+  if (exec_command(&command, AUDRLT_STATUSCHANGED) != AUDIOLIB_ECODE_OK)
     {
-      print_err("ERROR: Command(0x%x) fails. Result code(0x%x) Module id(%d) Error code(0x%lx) subcode(0x%lx)\n",
-                command.header.command_code, result.header.result_code, result.error_response_param.module_id,
-                result.error_response_param.error_code, result.error_response_param.error_sub_code);
-      print_dbg("ERROR: %s\n", error_msg[result.error_response_param.error_code]);
       return AUDIOLIB_ECODE_AUDIOCOMMAND_ERROR;
     }
 
@@ -1840,128 +2149,20 @@ err_t AudioClass::send_set_through(void)
  ****************************************************************************/
 bool AudioClass::check_decode_dsp(uint8_t codec_type, const char *path)
 {
-  char fullpath[32] = { 0 };
-  struct stat buf;
-  int retry;
-  int ret = 0;
-
-  switch (codec_type)
-    {
-      case AS_CODECTYPE_MP3:
-        snprintf(fullpath, sizeof(fullpath), "%s/MP3DEC", path);
-        break;
-
-      case AS_CODECTYPE_AAC:
-      case AS_CODECTYPE_MEDIA:
-        snprintf(fullpath, sizeof(fullpath), "%s/AACDEC", path);
-        break;
-
-      case AS_CODECTYPE_WAV:
-      case AS_CODECTYPE_LPCM:
-        snprintf(fullpath, sizeof(fullpath), "%s/WAVDEC", path);
-        break;
-
-      case AS_CODECTYPE_OPUS:
-        snprintf(fullpath, sizeof(fullpath), "%s/OPUSDEC", path);
-        break;
-
-      default:
-        print_err("Codec type %d is invalid value.\n", codec_type);
-        return false;
-    }
-
-  if (0 == strncmp("/mnt/sd0", path, 8))
-    {
-      /* In case that SD card isn't inserted, it times out at max 2 sec */
-      for (retry = 0; retry < 20; retry++) {
-        ret = stat("/mnt/sd0", &buf);
-        if (ret == 0)
-          {
-            break;
-          }
-        usleep(100 * 1000); // 100 msec
-      }
-      if (ret)
-        {
-          print_err("SD card is not present.\n");
-          return false;
-        }
-    }
-
-  FILE *fp = fopen(fullpath, "r");
-  if (fp == NULL)
-    {
-      print_err("DSP file %s cannot open.\n", fullpath);
-      return false;
-    }
-
-  fclose(fp);
-
-  return true;
+  return DspRegistry::getInstance()->isDecoderAvailable(codec_type, path);
 }
 
 /*--------------------------------------------------------------------------*/
 bool AudioClass::check_encode_dsp(uint8_t codec_type, const char *path, uint32_t fs)
 {
-  char fullpath[32] = { 0 };
-  struct stat buf;
-  int retry;
-  int ret = 0;
-
-  switch (codec_type)
-    {
-      case AS_CODECTYPE_MP3:
-        snprintf(fullpath, sizeof(fullpath), "%s/MP3ENC", path);
-        break;
-
-      case AS_CODECTYPE_LPCM:
-      case AS_CODECTYPE_WAV:
-        if (fs == AS_SAMPLINGRATE_48000)
-          {
-            return true;
-          }
-        else
-          {
-            snprintf(fullpath, sizeof(fullpath), "%s/SRC", path);
-          }
-        break;
+  /* Sampling rate converter is not needed for 48kHz PCM. */
 
-      case AS_CODECTYPE_OPUS:
-        snprintf(fullpath, sizeof(fullpath), "%s/OPUSENC", path);
-        break;
-
-      default:
-        print_err("Codec type %d is invalid value.\n", codec_type);
-        return false;
-    }
-
-  if (0 == strncmp("/mnt/sd0", path, 8))
+  if (((codec_type == AS_CODECTYPE_LPCM) || (codec_type == AS_CODECTYPE_WAV)) &&
+      (fs == AS_SAMPLINGRATE_48000))
     {
-      /* In case that SD card isn't inserted, it times out at max 2 sec */
-      for (retry = 0; retry < 20; retry++) {
-        ret = stat("/mnt/sd0", &buf);
-        if (ret == 0)
-          {
-            break;
-          }
-        usleep(100 * 1000); // 100 msec
-      }
-      if (ret)
-        {
-          print_err("SD card is not present.\n");
-          return false;
-        }
+      return true;
     }
 
-  FILE *fp = fopen(fullpath, "r");
-  if (fp == NULL)
-    {
-      print_err("DSP file %s cannot open.\n", fullpath);
-      return false;
-    }
-
-  fclose(fp);
-
-  return true;
+  return DspRegistry::getInstance()->isEncoderAvailable(codec_type, path);
 }
 
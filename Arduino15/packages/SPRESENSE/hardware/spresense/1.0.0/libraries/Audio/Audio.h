@@ -40,6 +40,7 @@
  */
 
 #include <pins_arduino.h>
+#include <semaphore.h>
 
 class File;
 
@@ -51,6 +52,8 @@ class File;
 #include <audio/utilities/frame_samples.h>
 #include <memutils/simple_fifo/CMN_SimpleFifo.h>
 
+#include "AudioMetrics.h"
+
 #define WRITE_FIFO_FRAME_NUM  (8)
 #define WRITE_FIFO_FRAME_SIZE (1024*2*3)
 #define WRITE_BUF_SIZE   (WRITE_FIFO_FRAME_NUM * WRITE_FIFO_FRAME_SIZE)
@@ -99,6 +102,7 @@ extern "C" void  outputDeviceCallback(uint32_t);
 #define AUDIOLIB_ECODE_INSUFFICIENT_BUFFER_AREA   8  /**< */
 #define AUDIOLIB_ECODE_WAV_PARSE_ERROR     9  /**< */
 #define AUDIOLIB_ECODE_PARAMETER_ERROR    10  /**< */
+#define AUDIOLIB_ECODE_TIMEOUT            11  /**< */
 
 /*--------------------------------------------------------------------------*/
 /**
@@ -107,6 +111,22 @@ extern "C" void  outputDeviceCallback(uint32_t);
 
 typedef unsigned int err_t;
 
+/**
+ * Callback function type for completion of Audio command.
+ * Parameters are command code and error code of the result.
+ */
+
+typedef void (*AudioCommandCb)(uint8_t command_code, err_t result);
+
+/**
+ * Maximum number of Audio commands waiting for result.
+ * AudioManager returns the results to MSGQ_AUD_APP, which holds 2 messages
+ * (see MemoryUtil msgq_pool.h), so no more commands than that are sent
+ * before a result is received.
+ */
+
+#define AUDIOLIB_COMMAND_QUEUE_SIZE 2
+
 /*--------------------------------------------------------------------------*/
 
 /**
@@ -761,6 +781,90 @@ public:
       uint32_t write_size /** Size of the audio data. */
   );
 
+  /**
+   * @brief Set watermarks of Stream Data FIFO.
+   *
+   * @details This function sets the watermarks used by fillFrames() and
+   *          waitFrames(). fillFrames() fills FIFO up to high watermark,
+   *          and waitFrames() waits until FIFO is drained to low watermark.
+   *          It can be called on PlayerMode.
+   *
+   *          By default, high watermark is FIFO size and low watermark is
+   *          half of FIFO size.
+   *
+   */
+
+  err_t setPlayerWatermark(
+      PlayerId id,   /**< Select Player ID. */
+      uint32_t low,  /**< Low watermark.(byte) */
+      uint32_t high  /**< High watermark.(byte) */
+  );
+
+  /**
+   * @brief Fill Stream Data FIFO from a file up to high watermark.
+   *
+   * @details This function reads the audio file in as few and large reads
+   *          as possible, until the occupied size of FIFO reaches high
+   *          watermark. Unlike writeFrames(), the amount written depends on
+   *          the vacant size of FIFO, not on the fixed number of frames.
+   *          It can be called on PlayerMode.
+   *
+   *          Typically call waitFrames() and this function in a loop.
+   *
+   */
+
+  err_t fillFrames(
+      PlayerId id, /**< Select Player ID. */
+      File& myfile /**< Specify an instance of the File class of the audio file. */
+  );
+
+  /**
+   * @brief Wait until Stream Data FIFO is drained to low watermark.
+   *
+   * @details This function blocks until the player consumes Stream data
+   *          and the occupied size of FIFO becomes low watermark or less.
+   *          It can be called on PlayerMode.
+   *
+   *          Returns AUDIOLIB_ECODE_TIMEOUT if not drained within timeout.
+   *
+   */
+
+  err_t waitFrames(
+      PlayerId id,        /**< Select Player ID. */
+      uint32_t timeout_ms /**< Timeout.(ms) 0 means wait forever. */
+  );
+
+  /**
+   * @brief Begin batch of Audio commands.
+   *
+   * @details After this function, control functions (setVolume(),
+   *          setLRgain(), setBeep(), setRenderingClockMode() and so on)
+   *          only send the command and return without waiting for the
+   *          result. Results are received by endCommandBatch(), and the
+   *          callback is called for each command.
+   *          Mode change and player control functions complete all
+   *          posted commands before their own. setThroughMode() also
+   *          completes its own commands before it returns.
+   *          At most AUDIOLIB_COMMAND_QUEUE_SIZE commands wait for the
+   *          result. Posting more commands blocks until the oldest result
+   *          is received.
+   *
+   */
+
+  void beginCommandBatch(
+      AudioCommandCb cb = NULL /**< Callback function called on completion of each command. */
+  );
+
+  /**
+   * @brief End batch of Audio commands.
+   *
+   * @details This function waits for the results of all posted commands.
+   *          Returns AUDIOLIB_ECODE_AUDIOCOMMAND_ERROR if any of them failed.
+   *
+   */
+
+  err_t endCommandBatch(void);
+
   /** APIs for Recorder Mode */
 
   /**
@@ -769,6 +873,9 @@ public:
    * @details This function should call when file format is WAV file recording.
    *          When codec of InitRecoder is "wav", be sure to call it before StartRecoder.
    *          Do not call it if other codecs are selected.
+   *          The sizes in the header are written by closeOutputFile(). For
+   *          long recording, use WavFileWriter which updates them during
+   *          recording.
    *
    */
   err_t writeWavHeader(
@@ -823,6 +930,38 @@ public:
       uint32_t* read_size    /**< Read size.(byte) */
   );
 
+  /**
+   * @brief Peek Stream Data in FIFO without copying.
+   *
+   * @details This function returns the areas of the generated Stream data
+   *          inside the Stream FIFO, instead of copying them to a buffer.
+   *          Because FIFO is a ring buffer, the data may be divided into
+   *          two areas. When it is not divided, size2 is 0.
+   *
+   *          The areas are kept until releaseFrames() is called, so you can
+   *          process (e.g. write to a file or FFT) the data directly.
+   *          It can be called on RecorderMode.
+   *
+   */
+  err_t peekFrames(
+      const uint8_t** area1, /**< Address of the first area. */
+      uint32_t*       size1, /**< Size of the first area.(byte) */
+      const uint8_t** area2, /**< Address of the second area. */
+      uint32_t*       size2  /**< Size of the second area.(byte) */
+  );
+
+  /**
+   * @brief Release Stream Data in FIFO.
+   *
+   * @details This function releases the data returned by peekFrames()
+   *          from the head of Stream FIFO. The released area is reused
+   *          for next recorded data.
+   *
+   */
+  err_t releaseFrames(
+      uint32_t size /**< Size to release.(byte) */
+  );
+
   /**
    * @brief Set Rendering clock mode.
    *
@@ -853,6 +992,18 @@ public:
      return m_es_size;
    }
 
+  /**
+   * @brief Get runtime statistics.
+   *
+   * @details FIFO fill levels, underrun/overrun, command round trip time
+   *          and attention log are recorded after getMetrics()->enable().
+   *
+   */
+  AudioMetrics* getMetrics(void)
+    {
+      return &m_metrics;
+    }
+
 private:
 
   /**
@@ -863,6 +1014,11 @@ private:
     : m_player0_simple_fifo_buf(NULL)
     , m_player1_simple_fifo_buf(NULL)
     , m_attention_callback(NULL)
+    , m_cmd_head(0)
+    , m_cmd_count(0)
+    , m_cmd_batch(false)
+    , m_cmd_callback(NULL)
+    , m_cmd_error(AUDIOLIB_ECODE_OK)
   {}
   AudioClass(const AudioClass&);
   AudioClass& operator=(const AudioClass&);
@@ -876,6 +1032,12 @@ private:
   uint32_t *m_player0_simple_fifo_buf;
   uint32_t *m_player1_simple_fifo_buf;
 
+  uint32_t      m_player_fifo_size[2];
+  uint32_t      m_player_low_wm[2];
+  uint32_t      m_player_high_wm[2];
+  volatile bool m_player_wm_waiting[2];
+  sem_t         m_player_wm_sem[2];
+
   AsPlayerInputDeviceHdlrForRAM m_player0_input_device_handler;
   AsPlayerInputDeviceHdlrForRAM m_player1_input_device_handler;
 
@@ -886,6 +1048,21 @@ private:
 
   AudioAttentionCb m_attention_callback;
 
+  struct
+  {
+    uint8_t  command_code;
+    uint8_t  expected;
+    uint32_t start;
+  } m_cmd_queue[AUDIOLIB_COMMAND_QUEUE_SIZE];
+
+  int            m_cmd_head;
+  int            m_cmd_count;
+  bool           m_cmd_batch;
+  AudioCommandCb m_cmd_callback;
+  err_t          m_cmd_error;
+
+  AudioMetrics   m_metrics;
+
   /* Private Functions */
 
   /* Functions for initialization on begin/end */
@@ -916,6 +1093,19 @@ private:
   err_t write_fifo(int, char*, uint32_t, CMN_SimpleFifoHandle*);
   err_t write_fifo(File&, char*, uint32_t, CMN_SimpleFifoHandle*);
 
+  err_t send_command(AudioCommand* command, uint8_t expected);
+  err_t exec_command(AudioCommand* command, uint8_t expected);
+  void  post_command(AudioCommand* command, uint8_t expected);
+  err_t complete_command(void);
+  err_t flush_commands(void);
+
+  static void player0_input_callback(uint32_t size);
+  static void player1_input_callback(uint32_t size);
+  void notify_consumed(PlayerId id);
+
+  static void recorder_output_callback(uint32_t size);
+  static void attention_callback(const ErrorAttentionParam *attparam);
+
   /* Functions for initialization on recorder mode. */
   err_t set_mic_map(uint8_t map[AS_MIC_CHANNEL_MAX]);
   err_t init_mic_gain(int, int);
@@ -0,0 +1,272 @@
+/*
+ *  AudioMetrics.cpp - Runtime statistics of audio FIFOs, commands and attentions
+ *  Copyright 2018 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+//***************************************************************************
+// Included Files
+//***************************************************************************
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "AudioMetrics.h"
+
+static const char *s_fifo_name[AUDIOMETRICS_FIFO_NUM] =
+{
+  "Player0",
+  "Player1",
+  "Recorder",
+};
+
+/****************************************************************************
+ * Public API on AudioMetrics Class
+ ****************************************************************************/
+
+AudioMetrics::AudioMetrics()
+  : m_enabled(false)
+{
+  memset(m_fifo, 0, sizeof(m_fifo));
+  reset();
+}
+
+/*--------------------------------------------------------------------------*/
+void AudioMetrics::reset(void)
+{
+  noInterrupts();
+
+  for (int i = 0; i < AUDIOMETRICS_FIFO_NUM; i++)
+    {
+      uint32_t capacity = m_fifo[i].capacity;
+
+      memset(&m_fifo[i], 0, sizeof(FifoStats));
+      m_fifo[i].capacity = capacity;
+      m_fifo[i].min      = UINT32_MAX;
+    }
+
+  memset(&m_cmd, 0, sizeof(m_cmd));
+  m_log_count = 0;
+
+  interrupts();
+}
+
+/*--------------------------------------------------------------------------*/
+const AudioMetrics::FifoStats& AudioMetrics::getFifoStats(int fifo)
+{
+  if ((fifo < 0) || (fifo >= AUDIOMETRICS_FIFO_NUM))
+    {
+      fifo = AUDIOMETRICS_FIFO_PLAYER0;
+    }
+
+  return m_fifo[fifo];
+}
+
+/*--------------------------------------------------------------------------*/
+int AudioMetrics::getAttentionLog(AttentionLog *log, int num)
+{
+  if (!log || (num <= 0))
+    {
+      return 0;
+    }
+
+  /* Entries are appended from the audio tasks, so copy them at once. */
+
+  noInterrupts();
+
+  uint32_t count = m_log_count;
+  int n = (count < AUDIOMETRICS_LOG_NUM) ? (int)count : AUDIOMETRICS_LOG_NUM;
+
+  if (n > num)
+    {
+      n = num;
+    }
+
+  for (int i = 0; i < n; i++)
+    {
+      log[i] = m_log[(count - n + i) % AUDIOMETRICS_LOG_NUM];
+    }
+
+  interrupts();
+
+  return n;
+}
+
+/*--------------------------------------------------------------------------*/
+void AudioMetrics::dump(void)
+{
+  for (int i = 0; i < AUDIOMETRICS_FIFO_NUM; i++)
+    {
+      const FifoStats& f = m_fifo[i];
+
+      if (f.samples == 0)
+        {
+          continue;
+        }
+
+      printf("%s FIFO: size %ld min %ld max %ld underrun %ld overrun %ld\n  hist",
+             s_fifo_name[i], f.capacity, f.min, f.max, f.underrun, f.overrun);
+      for (int j = 0; j < AUDIOMETRICS_HIST_NUM; j++)
+        {
+          printf(" %ld", f.hist[j]);
+        }
+      printf("\n");
+    }
+
+  if (m_cmd.count > 0)
+    {
+      printf("Command: %ld times, last %ldus max %ldus avg %ldus\n",
+             m_cmd.count, m_cmd.last_us, m_cmd.max_us,
+             (uint32_t)(m_cmd.total_us / m_cmd.count));
+    }
+
+  AttentionLog log[AUDIOMETRICS_LOG_NUM];
+  int n = getAttentionLog(log, AUDIOMETRICS_LOG_NUM);
+
+  printf("Attention: %ld times\n", m_log_count);
+  for (int i = 0; i < n; i++)
+    {
+      printf("  %ldms module %d level 0x%x code 0x%lx line %ld\n",
+             log[i].time_ms, log[i].module_id, log[i].error_code,
+             log[i].sub_code, log[i].line_number);
+    }
+}
+
+/****************************************************************************
+ * Recording API on AudioMetrics Class
+ ****************************************************************************/
+
+void AudioMetrics::setCapacity(int fifo, uint32_t capacity)
+{
+  if ((fifo >= 0) && (fifo < AUDIOMETRICS_FIFO_NUM))
+    {
+      m_fifo[fifo].capacity = capacity;
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+void AudioMetrics::sampleFifo(int fifo, uint32_t occupied)
+{
+  if (!m_enabled || (fifo < 0) || (fifo >= AUDIOMETRICS_FIFO_NUM))
+    {
+      return;
+    }
+
+  FifoStats& f = m_fifo[fifo];
+
+  if (occupied < f.min)
+    {
+      f.min = occupied;
+    }
+  if (occupied > f.max)
+    {
+      f.max = occupied;
+    }
+
+  uint32_t step = 0;
+  if (f.capacity)
+    {
+      step = (uint32_t)(((uint64_t)occupied * AUDIOMETRICS_HIST_NUM) / f.capacity);
+      if (step >= AUDIOMETRICS_HIST_NUM)
+        {
+          step = AUDIOMETRICS_HIST_NUM - 1;
+        }
+    }
+
+  f.hist[step]++;
+  f.samples++;
+}
+
+/*--------------------------------------------------------------------------*/
+void AudioMetrics::countUnderrun(int fifo)
+{
+  if (m_enabled && (fifo >= 0) && (fifo < AUDIOMETRICS_FIFO_NUM))
+    {
+      m_fifo[fifo].underrun++;
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+void AudioMetrics::countOverrun(int fifo)
+{
+  if (m_enabled && (fifo >= 0) && (fifo < AUDIOMETRICS_FIFO_NUM))
+    {
+      m_fifo[fifo].overrun++;
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+uint32_t AudioMetrics::beginCommand(void)
+{
+  if (!m_enabled)
+    {
+      return 0;
+    }
+
+  /* 0 means that the command started while metrics were disabled. */
+
+  uint32_t now = micros();
+  return (now) ? now : 1;
+}
+
+/*--------------------------------------------------------------------------*/
+void AudioMetrics::endCommand(uint32_t start)
+{
+  if (!m_enabled || (start == 0))
+    {
+      return;
+    }
+
+  uint32_t elapsed = micros() - start;
+
+  m_cmd.count++;
+  m_cmd.last_us   = elapsed;
+  m_cmd.total_us += elapsed;
+  if (elapsed > m_cmd.max_us)
+    {
+      m_cmd.max_us = elapsed;
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+void AudioMetrics::logAttention(const ErrorAttentionParam *param)
+{
+  if (!m_enabled || !param)
+    {
+      return;
+    }
+
+  AttentionLog entry;
+
+  entry.time_ms     = millis();
+  entry.module_id   = param->module_id;
+  entry.error_code  = param->error_code;
+  entry.sub_code    = param->error_att_sub_code;
+  entry.line_number = param->line_number;
+
+  /* The recorder drops the frame when the FIFO has no room for it. */
+
+  if (param->error_att_sub_code == AS_ATTENTION_SUB_CODE_SIMPLE_FIFO_OVERFLOW)
+    {
+      countOverrun(AUDIOMETRICS_FIFO_RECORDER);
+    }
+
+  noInterrupts();
+  m_log[m_log_count % AUDIOMETRICS_LOG_NUM] = entry;
+  m_log_count++;
+  interrupts();
+}
@@ -0,0 +1,210 @@
+/*
+ *  AudioMetrics.h - Runtime statistics of audio FIFOs, commands and attentions
+ *  Copyright 2018 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef AudioMetrics_h
+#define AudioMetrics_h
+
+#ifdef SUBCORE
+#error "Audio library is NOT supported by SubCore."
+#endif
+
+/**
+ * @file AudioMetrics.h
+ * @author Sony Semiconductor Solutions Corporation
+ * @brief Runtime statistics of audio FIFOs, commands and attentions.
+ * @details AudioClass, MediaPlayer and MediaRecorder have an instance of
+ *          AudioMetrics. It is disabled by default, and records nothing
+ *          until enable() is called.
+ */
+
+#include <stdint.h>
+
+#include <audio/audio_high_level_api.h>
+
+/*--------------------------------------------------------------------------*/
+
+/**
+ * FIFO index
+ */
+
+#define AUDIOMETRICS_FIFO_PLAYER0   0
+#define AUDIOMETRICS_FIFO_PLAYER1   1
+#define AUDIOMETRICS_FIFO_RECORDER  2
+#define AUDIOMETRICS_FIFO_NUM       3
+
+/**
+ * AudioMetrics settings.
+ */
+
+#define AUDIOMETRICS_HIST_NUM       8   /* Steps of FIFO fill level */
+#define AUDIOMETRICS_LOG_NUM        16  /* Attention log entries */
+
+/*--------------------------------------------------------------------------*/
+
+/**
+ * @class AudioMetrics
+ * @brief Runtime statistics of audio.
+ */
+
+class AudioMetrics
+{
+public:
+
+  /**
+   * @brief Statistics of a FIFO.
+   */
+
+  typedef struct
+  {
+    uint32_t capacity;                    /**< Size of FIFO.(byte) */
+    uint32_t min;                         /**< Minimum fill level.(byte) */
+    uint32_t max;                         /**< Maximum fill level.(byte) */
+    uint32_t samples;                     /**< Number of samples. */
+    uint32_t hist[AUDIOMETRICS_HIST_NUM]; /**< Samples by fill level in capacity / AUDIOMETRICS_HIST_NUM steps. */
+    uint32_t underrun;                    /**< Times the player FIFO became empty. */
+    uint32_t overrun;                     /**< Frames dropped because the recorder FIFO was full. */
+  } FifoStats;
+
+  /**
+   * @brief Statistics of command round trip.
+   */
+
+  typedef struct
+  {
+    uint32_t count;     /**< Number of commands. */
+    uint32_t last_us;   /**< Time of the last command.(us) */
+    uint32_t max_us;    /**< Maximum time.(us) */
+    uint64_t total_us;  /**< Total time.(us) */
+  } CommandStats;
+
+  /**
+   * @brief Entry of attention log.
+   */
+
+  typedef struct
+  {
+    uint32_t time_ms;      /**< millis() at the attention. */
+    uint8_t  module_id;    /**< Module which notified the attention. */
+    uint8_t  error_code;   /**< Level of the attention. */
+    uint32_t sub_code;     /**< Attention code. */
+    uint32_t line_number;  /**< Line in the module. */
+  } AttentionLog;
+
+  AudioMetrics();
+
+  /**
+   * @brief Enable or disable recording.
+   */
+
+  void enable(
+      bool en = true /**< true to enable */
+  )
+    {
+      m_enabled = en;
+    }
+
+  /**
+   * @brief Check if recording is enabled.
+   */
+
+  bool isEnabled(void)
+    {
+      return m_enabled;
+    }
+
+  /**
+   * @brief Clear all statistics and the log.
+   *
+   * @details Capacity of each FIFO is kept.
+   *
+   */
+
+  void reset(void);
+
+  /**
+   * @brief Get statistics of a FIFO.
+   */
+
+  const FifoStats& getFifoStats(
+      int fifo /**< AUDIOMETRICS_FIFO_XXX */
+  );
+
+  /**
+   * @brief Get statistics of command round trip.
+   */
+
+  const CommandStats& getCommandStats(void)
+    {
+      return m_cmd;
+    }
+
+  /**
+   * @brief Get number of attentions since reset.
+   *
+   * @details The log keeps the last AUDIOMETRICS_LOG_NUM of them.
+   *
+   */
+
+  uint32_t getAttentionCount(void)
+    {
+      return m_log_count;
+    }
+
+  /**
+   * @brief Copy the attention log.
+   *
+   * @return Number of copied entries, oldest first.
+   */
+
+  int getAttentionLog(
+      AttentionLog *log, /**< Destination */
+      int num            /**< Number of entries of log */
+  );
+
+  /**
+   * @brief Print all statistics and the log.
+   */
+
+  void dump(void);
+
+  /**
+   * Functions for the audio classes to record
+   */
+
+  void setCapacity(int fifo, uint32_t capacity);
+  void sampleFifo(int fifo, uint32_t occupied);
+  void countUnderrun(int fifo);
+  void countOverrun(int fifo);
+  uint32_t beginCommand(void);
+  void endCommand(uint32_t start);
+  void logAttention(const ErrorAttentionParam *param);
+
+private:
+
+  AudioMetrics(const AudioMetrics&);
+  AudioMetrics& operator=(const AudioMetrics&);
+
+  volatile bool m_enabled;
+  FifoStats     m_fifo[AUDIOMETRICS_FIFO_NUM];
+  CommandStats  m_cmd;
+  AttentionLog  m_log[AUDIOMETRICS_LOG_NUM];
+  uint32_t      m_log_count;
+};
+
+#endif // AudioMetrics_h
@@ -0,0 +1,227 @@
+/*
+ *  DspRegistry.cpp - Cache of installed audio DSP images
+ *  Copyright 2018 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+//***************************************************************************
+// Included Files
+//***************************************************************************
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <audio/audio_high_level_api.h>
+
+#include "DspRegistry.h"
+
+static const char *s_dsp_name[DspRegistry::DspNum] =
+{
+  "MP3DEC",
+  "AACDEC",
+  "WAVDEC",
+  "OPUSDEC",
+  "SRC",
+  "MP3ENC",
+  "OPUSENC",
+};
+
+/****************************************************************************
+ * Public API on DspRegistry Class
+ ****************************************************************************/
+
+bool DspRegistry::scan(const char *path)
+{
+  struct stat buf;
+  int retry;
+  int ret = 0;
+
+  m_scanned = false;
+
+  if (strlen(path) >= sizeof(m_path))
+    {
+      print_err("DSP path %s is too long.\n", path);
+      return false;
+    }
+
+  if (0 == strncmp("/mnt/sd0", path, 8))
+    {
+      /* In case that SD card isn't inserted, it times out at max 2 sec */
+      for (retry = 0; retry < 20; retry++) {
+        ret = stat("/mnt/sd0", &buf);
+        if (ret == 0)
+          {
+            break;
+          }
+        usleep(100 * 1000); // 100 msec
+      }
+      if (ret)
+        {
+          print_err("SD card is not present.\n");
+          return false;
+        }
+    }
+
+  if (stat(path, &buf) != 0)
+    {
+      print_err("DSP directory %s cannot access.\n", path);
+      return false;
+    }
+
+  for (int i = 0; i < DspNum; i++)
+    {
+      m_size[i] = 0;
+
+      char fullpath[DSPREGISTRY_PATH_LEN];
+      if (snprintf(fullpath, sizeof(fullpath), "%s/%s", path, s_dsp_name[i])
+          >= (int)sizeof(fullpath))
+        {
+          continue;
+        }
+
+      /* DSP image is an ELF file, check the magic number. */
+
+      FILE *fp = fopen(fullpath, "r");
+      if (fp == NULL)
+        {
+          continue;
+        }
+
+      char magic[4];
+      if ((fread(magic, 1, sizeof(magic), fp) == sizeof(magic)) &&
+          (memcmp(magic, "\177ELF", 4) == 0) &&
+          (stat(fullpath, &buf) == 0))
+        {
+          m_size[i] = buf.st_size;
+        }
+
+      fclose(fp);
+    }
+
+  snprintf(m_path, sizeof(m_path), "%s", path);
+  m_scanned = true;
+
+  return true;
+}
+
+/*--------------------------------------------------------------------------*/
+bool DspRegistry::isAvailable(DspId id, const char *path)
+{
+  return check(id, path);
+}
+
+/*--------------------------------------------------------------------------*/
+bool DspRegistry::isDecoderAvailable(uint8_t codec_type, const char *path)
+{
+  switch (codec_type)
+    {
+      case AS_CODECTYPE_MP3:
+        return check(Mp3Dec, path);
+
+      case AS_CODECTYPE_AAC:
+      case AS_CODECTYPE_MEDIA:
+        return check(AacDec, path);
+
+      case AS_CODECTYPE_WAV:
+      case AS_CODECTYPE_LPCM:
+        return check(WavDec, path);
+
+      case AS_CODECTYPE_OPUS:
+        return check(OpusDec, path);
+
+      default:
+        print_err("Codec type %d is invalid value.\n", codec_type);
+        return false;
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+bool DspRegistry::isEncoderAvailable(uint8_t codec_type, const char *path)
+{
+  switch (codec_type)
+    {
+      case AS_CODECTYPE_MP3:
+        return check(Mp3Enc, path);
+
+      case AS_CODECTYPE_WAV:
+      case AS_CODECTYPE_LPCM:
+        return check(Src, path);
+
+      case AS_CODECTYPE_OPUS:
+        return check(OpusEnc, path);
+
+      default:
+        print_err("Codec type %d is invalid value.\n", codec_type);
+        return false;
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+uint32_t DspRegistry::getSize(DspId id)
+{
+  if (!m_scanned || (id >= DspNum))
+    {
+      return 0;
+    }
+
+  return m_size[id];
+}
+
+/*--------------------------------------------------------------------------*/
+const char *DspRegistry::getName(DspId id)
+{
+  return (id < DspNum) ? s_dsp_name[id] : "";
+}
+
+/****************************************************************************
+ * Private API on DspRegistry Class
+ ****************************************************************************/
+
+bool DspRegistry::check(DspId id, const char *path)
+{
+  bool fresh = false;
+
+  if (!m_scanned || (strncmp(m_path, path, sizeof(m_path)) != 0))
+    {
+      if (!scan(path))
+        {
+          return false;
+        }
+      fresh = true;
+    }
+
+  /* Missing image may be installed after the scan, so scan again before
+   * reporting an error. Available images are never accessed here.
+   */
+
+  if ((m_size[id] == 0) && !fresh)
+    {
+      if (!scan(path))
+        {
+          return false;
+        }
+    }
+
+  if (m_size[id] == 0)
+    {
+      print_err("DSP file %s/%s cannot open.\n", path, s_dsp_name[id]);
+      return false;
+    }
+
+  return true;
+}
@@ -0,0 +1,189 @@
+/*
+ *  DspRegistry.h - Cache of installed audio DSP images
+ *  Copyright 2018 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef DspRegistry_h
+#define DspRegistry_h
+
+#ifdef SUBCORE
+#error "Audio library is NOT supported by SubCore."
+#endif
+
+/**
+ * @file DspRegistry.h
+ * @author Sony Semiconductor Solutions Corporation
+ * @brief Cache of installed audio DSP images.
+ * @details The DSP directory is scanned once, and the result is used by
+ *          initPlayer()/initRecorder() of AudioClass, MediaPlayer and
+ *          MediaRecorder instead of accessing the file system every time.
+ */
+
+#include <stdint.h>
+#include <limits.h>
+
+/*--------------------------------------------------------------------------*/
+
+/**
+ * DspRegistry log output definition
+ */
+
+#define print_err printf
+
+/* Longer DSP paths are rejected, never truncated. */
+
+#define DSPREGISTRY_PATH_LEN  PATH_MAX
+
+/*--------------------------------------------------------------------------*/
+
+/**
+ * @class DspRegistry
+ * @brief Cache of installed audio DSP images.
+ */
+
+class DspRegistry
+{
+public:
+
+  /**
+   * @brief Get instance of DspRegistry for singleton.
+   */
+
+  static DspRegistry* getInstance()
+    {
+      static DspRegistry instance;
+      return &instance;
+    }
+
+  /**
+   * @enum DspId
+   *
+   * @brief DSP images.
+   */
+
+  typedef enum
+  {
+    Mp3Dec,   /**< MP3DEC */
+    AacDec,   /**< AACDEC */
+    WavDec,   /**< WAVDEC */
+    OpusDec,  /**< OPUSDEC */
+    Src,      /**< SRC */
+    Mp3Enc,   /**< MP3ENC */
+    OpusEnc,  /**< OPUSENC */
+    DspNum
+  } DspId;
+
+  /**
+   * @brief Scan DSP images.
+   *
+   * @details This function checks all DSP images in the directory, and
+   *          caches the result. If the directory is on SD card, it waits
+   *          for SD card up to 2 sec. Returns false if the directory
+   *          cannot be accessed, and nothing is cached in that case.
+   *
+   */
+
+  bool scan(
+      const char *path /**< DSP directory. e.g. "/mnt/sd0/BIN" */
+  );
+
+  /**
+   * @brief Check if a DSP image is available.
+   *
+   * @details The directory is scanned only when it differs from the cached
+   *          one, or after invalidate().
+   *
+   */
+
+  bool isAvailable(
+      DspId id,        /**< DSP image */
+      const char *path /**< DSP directory */
+  );
+
+  /**
+   * @brief Check if the decoder DSP for codec is available.
+   */
+
+  bool isDecoderAvailable(
+      uint8_t codec_type, /**< AS_CODECTYPE_XXX */
+      const char *path    /**< DSP directory */
+  );
+
+  /**
+   * @brief Check if the encoder DSP for codec is available.
+   *
+   * @details For WAV and LPCM, SRC is checked. The caller must skip this
+   *          check when sampling rate conversion is not needed.
+   *
+   */
+
+  bool isEncoderAvailable(
+      uint8_t codec_type, /**< AS_CODECTYPE_XXX */
+      const char *path    /**< DSP directory */
+  );
+
+  /**
+   * @brief Get size of a DSP image.
+   *
+   * @details Returns 0 if not available or not scanned.
+   *
+   */
+
+  uint32_t getSize(
+      DspId id /**< DSP image */
+  );
+
+  /**
+   * @brief Invalidate the cache.
+   *
+   * @details Call this function when DSP images are installed or updated,
+   *          or storage is remounted. The next check scans again.
+   *
+   */
+
+  void invalidate(void)
+    {
+      m_scanned = false;
+    }
+
+  /**
+   * @brief Get file name of a DSP image.
+   */
+
+  static const char *getName(
+      DspId id /**< DSP image */
+  );
+
+private:
+
+  DspRegistry()
+    : m_scanned(false)
+  {
+    m_path[0] = '\0';
+  }
+  DspRegistry(const DspRegistry&);
+  DspRegistry& operator=(const DspRegistry&);
+  ~DspRegistry() {}
+
+  bool check(DspId id, const char *path);
+
+  char     m_path[DSPREGISTRY_PATH_LEN];
+  bool     m_scanned;
+  uint32_t m_size[DspNum];  /* 0 means not available */
+};
+
+#endif // DspRegistry_h
@@ -0,0 +1,615 @@
+/*
+ *  GaplessPlayer.cpp - Gapless playlist engine on MediaPlayer
+ *  Copyright 2018 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+//***************************************************************************
+// Included Files
+//***************************************************************************
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <File.h>
+
+#include "GaplessPlayer.h"
+
+static inline uint16_t get_le16(const uint8_t *p)
+{
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t get_le32(const uint8_t *p)
+{
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+         ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static bool same_format(const GaplessPlayer::Format& a, const GaplessPlayer::Format& b)
+{
+  return (a.codec_type     == b.codec_type) &&
+         (a.sampling_rate  == b.sampling_rate) &&
+         (a.bit_length     == b.bit_length) &&
+         (a.channel_number == b.channel_number);
+}
+
+static int write_error(err_t err)
+{
+  print_err("Fail to write frames. error:%d\n", err);
+
+  return (err == MEDIAPLAYER_ECODE_SIMPLEFIFO_ERROR)
+    ? GAPLESSPLAYER_ECODE_SIMPLEFIFO_ERROR : GAPLESSPLAYER_ECODE_FILEACCESS_ERROR;
+}
+
+/****************************************************************************
+ * Public API on GaplessPlayer Class
+ ****************************************************************************/
+
+GaplessPlayer::GaplessPlayer()
+  : m_player(NULL)
+  , m_id(MediaPlayer::Player0)
+  , m_callback(NULL)
+  , m_prefetch_size(0)
+  , m_running(false)
+  , m_hold(false)
+  , m_queue_head(0)
+  , m_queue_count(0)
+  , m_cur(0)
+{
+  for (int i = 0; i < 2; i++)
+    {
+      m_track[i].path[0]  = '\0';
+      m_track[i].state    = TrackIdle;
+      m_track[i].remain   = 0;
+      m_track[i].pre_buf  = NULL;
+      m_track[i].pre_size = 0;
+      m_track[i].pre_pos  = 0;
+      memset(&m_track[i].format, 0, sizeof(Format));
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+GaplessPlayer::~GaplessPlayer()
+{
+  end();
+}
+
+/*--------------------------------------------------------------------------*/
+int GaplessPlayer::begin(MediaPlayer::PlayerId id, uint32_t prefetch_size, TrackCallback cb)
+{
+  if (m_running)
+    {
+      return GAPLESSPLAYER_ECODE_STATE_ERROR;
+    }
+
+  if (prefetch_size == 0)
+    {
+      return GAPLESSPLAYER_ECODE_STATE_ERROR;
+    }
+
+  for (int i = 0; i < 2; i++)
+    {
+      m_track[i].pre_buf = (uint8_t *)malloc(prefetch_size);
+      if (!m_track[i].pre_buf)
+        {
+          free(m_track[0].pre_buf);
+          m_track[0].pre_buf = NULL;
+          return GAPLESSPLAYER_ECODE_ALLOC_ERROR;
+        }
+    }
+
+  m_player        = MediaPlayer::getInstance();
+  m_id            = id;
+  m_callback      = cb;
+  m_prefetch_size = prefetch_size;
+  m_hold          = false;
+  m_queue_head    = 0;
+  m_queue_count   = 0;
+  m_cur           = 0;
+  m_running       = true;
+
+  return GAPLESSPLAYER_ECODE_OK;
+}
+
+/*--------------------------------------------------------------------------*/
+int GaplessPlayer::end(void)
+{
+  if (!m_running)
+    {
+      return GAPLESSPLAYER_ECODE_STATE_ERROR;
+    }
+
+  for (int i = 0; i < 2; i++)
+    {
+      close_track(&m_track[i]);
+      free(m_track[i].pre_buf);
+      m_track[i].pre_buf = NULL;
+    }
+
+  m_queue_count = 0;
+  m_running     = false;
+
+  return GAPLESSPLAYER_ECODE_OK;
+}
+
+/*--------------------------------------------------------------------------*/
+int GaplessPlayer::add(const char *path)
+{
+  if (!m_running)
+    {
+      return GAPLESSPLAYER_ECODE_STATE_ERROR;
+    }
+
+  if (m_queue_count >= GAPLESSPLAYER_QUEUE_NUM)
+    {
+      return GAPLESSPLAYER_ECODE_QUEUE_FULL;
+    }
+
+  int tail = (m_queue_head + m_queue_count) % GAPLESSPLAYER_QUEUE_NUM;
+
+  snprintf(m_queue[tail], GAPLESSPLAYER_PATH_LEN, "%s", path);
+  m_queue_count++;
+
+  return GAPLESSPLAYER_ECODE_OK;
+}
+
+/*--------------------------------------------------------------------------*/
+int GaplessPlayer::prepare(void)
+{
+  if (!m_running)
+    {
+      return GAPLESSPLAYER_ECODE_STATE_ERROR;
+    }
+
+  Track *cur = &m_track[m_cur];
+
+  close_track(cur);
+  m_hold = false;
+
+  /* Open tracks until one of them can be played. */
+
+  while (m_queue_count > 0)
+    {
+      if (open_track(cur) == GAPLESSPLAYER_ECODE_OK &&
+          prefetch_track(cur) == GAPLESSPLAYER_ECODE_OK)
+        {
+          if (m_callback)
+            {
+              m_callback(cur->path);
+            }
+          return GAPLESSPLAYER_ECODE_OK;
+        }
+    }
+
+  return GAPLESSPLAYER_ECODE_FILEEND;
+}
+
+/*--------------------------------------------------------------------------*/
+int GaplessPlayer::feed(void)
+{
+  if (!m_running)
+    {
+      return GAPLESSPLAYER_ECODE_STATE_ERROR;
+    }
+
+  if (m_hold)
+    {
+      return GAPLESSPLAYER_ECODE_FORMAT_CHANGE;
+    }
+
+  Track *cur = &m_track[m_cur];
+
+  if (cur->state == TrackIdle)
+    {
+      return GAPLESSPLAYER_ECODE_FILEEND;
+    }
+
+  for (int i = 0; i < GAPLESSPLAYER_FEED_NUM; i++)
+    {
+      if ((cur->remain == 0) && (cur->pre_pos == cur->pre_size))
+        {
+          /* End of track. Usually the next track is already prefetched,
+           * otherwise prepare it here.
+           */
+
+          Track *next = &m_track[1 - m_cur];
+
+          while (next->state != TrackPrefetched)
+            {
+              if ((next->state == TrackIdle) && (m_queue_count == 0))
+                {
+                  close_track(cur);
+                  return GAPLESSPLAYER_ECODE_FILEEND;
+                }
+              step_next();
+            }
+
+          bool same = same_format(cur->format, next->format);
+
+          close_track(cur);
+          m_cur = 1 - m_cur;
+          cur   = next;
+
+          if (m_callback)
+            {
+              m_callback(cur->path);
+            }
+
+          if (!same)
+            {
+              m_hold = true;
+              return GAPLESSPLAYER_ECODE_FORMAT_CHANGE;
+            }
+
+          continue;
+        }
+
+      if (m_player->getVacantSize(m_id) < MEDIAPLAYER_BUF_FRAME_SIZE)
+        {
+          break;
+        }
+
+      if (cur->pre_pos < cur->pre_size)
+        {
+          uint32_t size = cur->pre_size - cur->pre_pos;
+          if (size > MEDIAPLAYER_BUF_FRAME_SIZE)
+            {
+              size = MEDIAPLAYER_BUF_FRAME_SIZE;
+            }
+
+          err_t err = m_player->writeFrames(m_id, cur->pre_buf + cur->pre_pos, size);
+          if (err != MEDIAPLAYER_ECODE_OK)
+            {
+              return write_error(err);
+            }
+          cur->pre_pos += size;
+        }
+      else
+        {
+          uint32_t size = (cur->remain < MEDIAPLAYER_BUF_FRAME_SIZE)
+            ? cur->remain : MEDIAPLAYER_BUF_FRAME_SIZE;
+
+          int ret = cur->file.read(m_buf, size);
+          if (ret < 0)
+            {
+              print_err("Fail to read %s.\n", cur->path);
+              return GAPLESSPLAYER_ECODE_FILEACCESS_ERROR;
+            }
+
+          if (ret == 0)
+            {
+              /* The file is shorter than its header says. */
+
+              print_err("Unexpected end of %s.\n", cur->path);
+              cur->remain = 0;
+              continue;
+            }
+
+          err_t err = m_player->writeFrames(m_id, m_buf, ret);
+          if (err != MEDIAPLAYER_ECODE_OK)
+            {
+              return write_error(err);
+            }
+          cur->remain -= ret;
+        }
+    }
+
+  /* Prepare the next track a step at a time, so that opening file and
+   * parsing header are not done at once on the track boundary.
+   */
+
+  Track *next = &m_track[1 - m_cur];
+
+  if ((next->state != TrackPrefetched) &&
+      ((next->state != TrackIdle) || (m_queue_count > 0)))
+    {
+      step_next();
+    }
+
+  return GAPLESSPLAYER_ECODE_OK;
+}
+
+/*--------------------------------------------------------------------------*/
+int GaplessPlayer::resume(void)
+{
+  if (!m_running)
+    {
+      return GAPLESSPLAYER_ECODE_STATE_ERROR;
+    }
+
+  m_hold = false;
+
+  return GAPLESSPLAYER_ECODE_OK;
+}
+
+/*--------------------------------------------------------------------------*/
+int GaplessPlayer::skip(void)
+{
+  if (!m_running)
+    {
+      return GAPLESSPLAYER_ECODE_STATE_ERROR;
+    }
+
+  Track *cur = &m_track[m_cur];
+
+  cur->remain  = 0;
+  cur->pre_pos = cur->pre_size;
+
+  return GAPLESSPLAYER_ECODE_OK;
+}
+
+/****************************************************************************
+ * Private API on GaplessPlayer Class
+ ****************************************************************************/
+
+int GaplessPlayer::open_track(Track* track)
+{
+  snprintf(track->path, GAPLESSPLAYER_PATH_LEN, "%s", m_queue[m_queue_head]);
+  m_queue_head = (m_queue_head + 1) % GAPLESSPLAYER_QUEUE_NUM;
+  m_queue_count--;
+
+  track->file = File(track->path);
+  if (!track->file)
+    {
+      print_err("File %s cannot open.\n", track->path);
+      return GAPLESSPLAYER_ECODE_FILEACCESS_ERROR;
+    }
+
+  uint8_t magic[4];
+
+  if (track->file.read(magic, sizeof(magic)) != sizeof(magic))
+    {
+      track->file.close();
+      return GAPLESSPLAYER_ECODE_FORMAT_ERROR;
+    }
+  track->file.seek(0);
+
+  int ret = (memcmp(magic, "RIFF", 4) == 0) ? parse_wav(track) : parse_mp3(track);
+
+  if (ret != GAPLESSPLAYER_ECODE_OK)
+    {
+      print_err("Format of %s is not supported.\n", track->path);
+      track->file.close();
+      return ret;
+    }
+
+  track->pre_size = 0;
+  track->pre_pos  = 0;
+  track->state    = TrackOpened;
+
+  return GAPLESSPLAYER_ECODE_OK;
+}
+
+/*--------------------------------------------------------------------------*/
+int GaplessPlayer::prefetch_track(Track* track)
+{
+  uint32_t size = (track->remain < m_prefetch_size) ? track->remain : m_prefetch_size;
+
+  int ret = track->file.read(track->pre_buf, size);
+  if (ret < 0)
+    {
+      print_err("Fail to read %s.\n", track->path);
+      close_track(track);
+      return GAPLESSPLAYER_ECODE_FILEACCESS_ERROR;
+    }
+
+  track->pre_size = ret;
+  track->pre_pos  = 0;
+  track->remain  -= ret;
+  track->state    = TrackPrefetched;
+
+  return GAPLESSPLAYER_ECODE_OK;
+}
+
+/*--------------------------------------------------------------------------*/
+int GaplessPlayer::step_next(void)
+{
+  Track *next = &m_track[1 - m_cur];
+
+  if (next->state == TrackIdle)
+    {
+      if (m_queue_count == 0)
+        {
+          return GAPLESSPLAYER_ECODE_FILEEND;
+        }
+      return open_track(next);
+    }
+
+  if (next->state == TrackOpened)
+    {
+      return prefetch_track(next);
+    }
+
+  return GAPLESSPLAYER_ECODE_OK;
+}
+
+/*--------------------------------------------------------------------------*/
+void GaplessPlayer::close_track(Track* track)
+{
+  if (track->state != TrackIdle)
+    {
+      track->file.close();
+    }
+
+  track->state    = TrackIdle;
+  track->remain   = 0;
+  track->pre_size = 0;
+  track->pre_pos  = 0;
+}
+
+/*--------------------------------------------------------------------------*/
+int GaplessPlayer::parse_wav(Track* track)
+{
+  File& file = track->file;
+  uint8_t hdr[16];
+  uint16_t block = 0;
+  bool has_fmt = false;
+
+  if ((file.read(hdr, 12) != 12) || (memcmp(&hdr[8], "WAVE", 4) != 0))
+    {
+      return GAPLESSPLAYER_ECODE_FORMAT_ERROR;
+    }
+
+  for (;;)
+    {
+      if (file.read(hdr, 8) != 8)
+        {
+          return GAPLESSPLAYER_ECODE_FORMAT_ERROR;
+        }
+
+      uint32_t size = get_le32(&hdr[4]);
+      uint32_t next = file.position() + size + (size & 1);
+
+      if (memcmp(hdr, "fmt ", 4) == 0)
+        {
+          if ((size < 16) || (file.read(hdr, 16) != 16))
+            {
+              return GAPLESSPLAYER_ECODE_FORMAT_ERROR;
+            }
+
+          track->format.codec_type     = AS_CODECTYPE_WAV;
+          track->format.channel_number = get_le16(&hdr[2]);
+          track->format.sampling_rate  = get_le32(&hdr[4]);
+          track->format.bit_length     = get_le16(&hdr[14]);
+          block = get_le16(&hdr[12]);
+
+          if ((block == 0) ||
+              ((track->format.bit_length != AS_BITLENGTH_16) &&
+               (track->format.bit_length != AS_BITLENGTH_24)))
+            {
+              return GAPLESSPLAYER_ECODE_FORMAT_ERROR;
+            }
+
+          has_fmt = true;
+        }
+      else if (memcmp(hdr, "data", 4) == 0)
+        {
+          if (!has_fmt)
+            {
+              return GAPLESSPLAYER_ECODE_FORMAT_ERROR;
+            }
+
+          /* Feed whole samples only, so that the next track starts at
+           * a sample boundary.
+           */
+
+          uint32_t avail = file.size() - file.position();
+
+          track->remain = (size < avail) ? size : avail;
+          track->remain -= track->remain % block;
+
+          return GAPLESSPLAYER_ECODE_OK;
+        }
+
+      if (!file.seek(next))
+        {
+          return GAPLESSPLAYER_ECODE_FORMAT_ERROR;
+        }
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+int GaplessPlayer::parse_mp3(Track* track)
+{
+  static const uint32_t rate_table[3] = { 44100, 48000, 32000 };
+
+  File& file = track->file;
+  uint8_t hdr[10];
+  uint32_t offset = 0;
+
+  if (file.read(hdr, sizeof(hdr)) != sizeof(hdr))
+    {
+      return GAPLESSPLAYER_ECODE_FORMAT_ERROR;
+    }
+
+  /* Skip ID3v2 tag, it must not be passed to the decoder in the middle
+   * of the stream.
+   */
+
+  if (memcmp(hdr, "ID3", 3) == 0)
+    {
+      offset = 10 + (((uint32_t)(hdr[6] & 0x7f) << 21) |
+                     ((uint32_t)(hdr[7] & 0x7f) << 14) |
+                     ((uint32_t)(hdr[8] & 0x7f) << 7) |
+                     (uint32_t)(hdr[9] & 0x7f));
+      if (hdr[5] & 0x10)
+        {
+          offset += 10;
+        }
+    }
+
+  /* Find the first frame header. */
+
+  file.seek(offset);
+
+  int len = file.read(m_buf, 512);
+  int i;
+
+  for (i = 0; i + 3 < len; i++)
+    {
+      if ((m_buf[i] == 0xff) && ((m_buf[i + 1] & 0xe0) == 0xe0) &&
+          (((m_buf[i + 1] >> 3) & 3) != 1) &&
+          (((m_buf[i + 2] >> 2) & 3) != 3))
+        {
+          break;
+        }
+    }
+
+  if (i + 3 >= len)
+    {
+      return GAPLESSPLAYER_ECODE_FORMAT_ERROR;
+    }
+
+  uint8_t version = (m_buf[i + 1] >> 3) & 3;
+  uint32_t rate   = rate_table[(m_buf[i + 2] >> 2) & 3];
+
+  if (version == 2)
+    {
+      rate /= 2;  /* MPEG-2 */
+    }
+  else if (version == 0)
+    {
+      rate /= 4;  /* MPEG-2.5 */
+    }
+
+  track->format.codec_type     = AS_CODECTYPE_MP3;
+  track->format.sampling_rate  = rate;
+  track->format.bit_length     = AS_BITLENGTH_16;
+  track->format.channel_number = (((m_buf[i + 3] >> 6) & 3) == 3)
+                                 ? AS_CHANNEL_MONO : AS_CHANNEL_STEREO;
+
+  offset += i;
+
+  /* Exclude ID3v1 tag at the end of file. */
+
+  uint32_t end = file.size();
+
+  if (end >= offset + 128)
+    {
+      file.seek(end - 128);
+      if ((file.read(hdr, 3) == 3) && (memcmp(hdr, "TAG", 3) == 0))
+        {
+          end -= 128;
+        }
+    }
+
+  file.seek(offset);
+  track->remain = end - offset;
+
+  return GAPLESSPLAYER_ECODE_OK;
+}
@@ -0,0 +1,253 @@
+/*
+ *  GaplessPlayer.h - Gapless playlist engine on MediaPlayer
+ *  Copyright 2018 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef GaplessPlayer_h
+#define GaplessPlayer_h
+
+#ifdef SUBCORE
+#error "Audio library is NOT supported by SubCore."
+#endif
+
+/**
+ * @file GaplessPlayer.h
+ * @author Sony Semiconductor Solutions Corporation
+ * @brief Gapless playlist engine on MediaPlayer.
+ * @details The next track is opened, its header is parsed and its first
+ *          frames are read into a staging buffer while the current track
+ *          is still playing. When the tracks have the same format, the
+ *          audio data of the next track follows the current one in the
+ *          FIFO of MediaPlayer, so the player is not restarted.
+ */
+
+#include <File.h>
+
+#include "MediaPlayer.h"
+
+/*--------------------------------------------------------------------------*/
+
+/**
+ * GaplessPlayer Error Code Definitions.
+ */
+
+#define GAPLESSPLAYER_ECODE_OK               0
+#define GAPLESSPLAYER_ECODE_STATE_ERROR      1
+#define GAPLESSPLAYER_ECODE_FILEACCESS_ERROR 2
+#define GAPLESSPLAYER_ECODE_FORMAT_ERROR     3
+#define GAPLESSPLAYER_ECODE_QUEUE_FULL       4
+#define GAPLESSPLAYER_ECODE_ALLOC_ERROR      5
+#define GAPLESSPLAYER_ECODE_FORMAT_CHANGE    6
+#define GAPLESSPLAYER_ECODE_FILEEND          7
+#define GAPLESSPLAYER_ECODE_SIMPLEFIFO_ERROR 8
+
+/**
+ * GaplessPlayer default settings.
+ */
+
+#define GAPLESSPLAYER_QUEUE_NUM      8
+#define GAPLESSPLAYER_PATH_LEN       64
+#define GAPLESSPLAYER_PREFETCH_SIZE  (MEDIAPLAYER_BUF_FRAME_SIZE * 2)
+#define GAPLESSPLAYER_FEED_NUM       5
+
+/*--------------------------------------------------------------------------*/
+
+/**
+ * @class GaplessPlayer
+ * @brief Gapless playlist engine.
+ */
+
+class GaplessPlayer
+{
+public:
+
+  /**
+   * @brief Format of track.
+   */
+
+  typedef struct
+  {
+    uint8_t  codec_type;     /**< AS_CODECTYPE_MP3 or AS_CODECTYPE_WAV */
+    uint32_t sampling_rate;  /**< Sampling rate.(Hz) */
+    uint8_t  bit_length;     /**< AS_BITLENGTH_16 or AS_BITLENGTH_24 */
+    uint8_t  channel_number; /**< AS_CHANNEL_MONO or AS_CHANNEL_STEREO */
+  } Format;
+
+  /**
+   * @brief Callback function type called when feeding of a track starts.
+   */
+
+  typedef void (*TrackCallback)(const char *path);
+
+  GaplessPlayer();
+  ~GaplessPlayer();
+
+  /**
+   * @brief Start the playlist engine.
+   *
+   * @details This function allocates the staging buffer for prefetch.
+   *          MediaPlayer must be activated for the player id by the caller.
+   *
+   */
+
+  int begin(
+      MediaPlayer::PlayerId id,                        /**< Player ID to feed. */
+      uint32_t prefetch_size = GAPLESSPLAYER_PREFETCH_SIZE, /**< Size of staging buffer.(byte) */
+      TrackCallback cb = NULL                          /**< Called when feeding of a track starts. */
+  );
+
+  /**
+   * @brief Stop the playlist engine.
+   *
+   * @details This function closes all files and clears the queue.
+   *
+   */
+
+  int end(void);
+
+  /**
+   * @brief Add a track to the queue.
+   *
+   * @details MP3 and WAV files are supported. Path without "/mnt/" is
+   *          treated as a file on SD card, same as File class.
+   *
+   */
+
+  int add(
+      const char *path /**< Path of audio file. */
+  );
+
+  /**
+   * @brief Prepare the first track.
+   *
+   * @details This function opens the first track in the queue and prefetches
+   *          its frames. After that, format() returns its format, so
+   *          initialize and start MediaPlayer with it, and call feed().
+   *
+   */
+
+  int prepare(void);
+
+  /**
+   * @brief Supply audio data to MediaPlayer.
+   *
+   * @details Call this function periodically instead of writeFrames().
+   *          At the end of a track, the next track is fed immediately if
+   *          it has the same format.
+   *          Otherwise GAPLESSPLAYER_ECODE_FORMAT_CHANGE is returned and
+   *          feeding is held. Then stop the player with AS_STOPPLAYER_ESEND,
+   *          initialize it with format(), call resume() and start it.
+   *          GAPLESSPLAYER_ECODE_FILEEND is returned when all tracks are fed.
+   *          A read error of the track or a write error of MediaPlayer
+   *          returns GAPLESSPLAYER_ECODE_FILEACCESS_ERROR or
+   *          GAPLESSPLAYER_ECODE_SIMPLEFIFO_ERROR.
+   *
+   */
+
+  int feed(void);
+
+  /**
+   * @brief Resume feeding after format change.
+   */
+
+  int resume(void);
+
+  /**
+   * @brief Skip the rest of the current track.
+   *
+   * @details Data already in the FIFO of MediaPlayer is not discarded.
+   *
+   */
+
+  int skip(void);
+
+  /**
+   * @brief Get format of the track being fed.
+   */
+
+  const Format& format(void)
+    {
+      return m_track[m_cur].format;
+    }
+
+  /**
+   * @brief Get path of the track being fed.
+   */
+
+  const char *path(void)
+    {
+      return m_track[m_cur].path;
+    }
+
+  /**
+   * @brief Get number of tracks waiting in the queue.
+   */
+
+  int getQueued(void)
+    {
+      return m_queue_count;
+    }
+
+private:
+
+  GaplessPlayer(const GaplessPlayer&);
+  GaplessPlayer& operator=(const GaplessPlayer&);
+
+  enum
+  {
+    TrackIdle,       /* No track */
+    TrackOpened,     /* Header is parsed */
+    TrackPrefetched, /* First frames are in staging buffer */
+  };
+
+  struct Track
+  {
+    char     path[GAPLESSPLAYER_PATH_LEN];
+    File     file;
+    Format   format;
+    int      state;
+    uint32_t remain;   /* Audio data left in file */
+    uint8_t* pre_buf;  /* Staging buffer */
+    uint32_t pre_size; /* Size of prefetched data */
+    uint32_t pre_pos;  /* Read position of prefetched data */
+  };
+
+  int open_track(Track* track);
+  int prefetch_track(Track* track);
+  int step_next(void);
+  void close_track(Track* track);
+  int parse_wav(Track* track);
+  int parse_mp3(Track* track);
+
+  MediaPlayer*          m_player;
+  MediaPlayer::PlayerId m_id;
+  TrackCallback         m_callback;
+  uint32_t              m_prefetch_size;
+  bool                  m_running;
+  bool                  m_hold;
+
+  char     m_queue[GAPLESSPLAYER_QUEUE_NUM][GAPLESSPLAYER_PATH_LEN];
+  int      m_queue_head;
+  int      m_queue_count;
+
+  Track    m_track[2];
+  int      m_cur;      /* Index of track being fed, the other is next one */
+
+  uint8_t  m_buf[MEDIAPLAYER_BUF_FRAME_SIZE];
+};
+
+#endif // GaplessPlayer_h
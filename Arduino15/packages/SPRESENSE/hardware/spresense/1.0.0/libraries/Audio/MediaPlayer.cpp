@@ -28,15 +28,11 @@
 
 #include "MediaPlayer.h"
 #include "MemoryUtil.h"
+#include "DspRegistry.h"
 
 
 #include <File.h>
 
-void  input_device_callback(uint32_t size)
-{
-    /* do nothing */
-}
-
 extern "C" {
 
 static void attentionCallback(const ErrorAttentionParam *attparam)
@@ -77,13 +73,17 @@ err_t MediaPlayer::create(PlayerId id, AudioAttentionCb attcb)
 
   bool result;
 
+  /* Attentions are logged and then passed to attcb. */
+
   if (id == Player0)
     {
-      result = AS_CreatePlayerMulti(AS_PLAYER_ID_0, &player_create_param, (attcb) ? attcb : attentionCallback);
+      m_attention_callback[0] = attcb;
+      result = AS_CreatePlayerMulti(AS_PLAYER_ID_0, &player_create_param, player0_attention_callback);
     }
   else
     {
-      result = AS_CreatePlayerMulti(AS_PLAYER_ID_1, &player_create_param, (attcb) ? attcb : attentionCallback);
+      m_attention_callback[1] = attcb;
+      result = AS_CreatePlayerMulti(AS_PLAYER_ID_1, &player_create_param, player1_attention_callback);
     }
 
   if (!result)
@@ -153,16 +153,19 @@ err_t MediaPlayer::activate(PlayerId id, uint8_t output_device, MediaPlayerCallb
       m_player0_simple_fifo_handle = handle;
       m_player0_simple_fifo_buf    = p_buffer;
       m_player0_input_device_handler.simple_fifo_handler = &m_player0_simple_fifo_handle; 
-      m_player0_input_device_handler.callback_function   = input_device_callback; 
+      m_player0_input_device_handler.callback_function   = player0_input_callback;
     }
   else
     {
       m_player1_simple_fifo_handle = handle;
       m_player1_simple_fifo_buf    = p_buffer;
       m_player1_input_device_handler.simple_fifo_handler = &m_player1_simple_fifo_handle; 
-      m_player1_input_device_handler.callback_function   = input_device_callback; 
+      m_player1_input_device_handler.callback_function   = player1_input_callback;
     }
 
+  m_metrics.setCapacity((id == Player0) ? AUDIOMETRICS_FIFO_PLAYER0 : AUDIOMETRICS_FIFO_PLAYER1,
+                        player_bufsize);
+
   /* Activate */
 
   AsPlayerInputDeviceHdlrForRAM *p_input_dev_handler =
@@ -470,66 +473,90 @@ err_t MediaPlayer::write_fifo(uint8_t *data, uint32_t size, CMN_SimpleFifoHandle
 }
 
 /*--------------------------------------------------------------------------*/
-bool MediaPlayer::check_decode_dsp(uint8_t codec_type, const char *path)
+uint32_t MediaPlayer::getVacantSize(PlayerId id)
 {
-  char fullpath[32] = { 0 };
-  struct stat buf;
-  int retry;
-  int ret = 0;
+  uint32_t *p_fifo = (id == Player0)
+    ? m_player0_simple_fifo_buf : m_player1_simple_fifo_buf;
 
-  switch (codec_type)
+  if (!p_fifo)
     {
-      case AS_CODECTYPE_MP3:
-        snprintf(fullpath, sizeof(fullpath), "%s/MP3DEC", path);
-        break;
+      return 0;
+    }
 
-      case AS_CODECTYPE_AAC:
-      case AS_CODECTYPE_MEDIA:
-        snprintf(fullpath, sizeof(fullpath), "%s/AACDEC", path);
-        break;
+  CMN_SimpleFifoHandle *handle =
+    (id == Player0) ?
+      &m_player0_simple_fifo_handle : &m_player1_simple_fifo_handle;
 
-      case AS_CODECTYPE_WAV:
-      case AS_CODECTYPE_LPCM:
-        snprintf(fullpath, sizeof(fullpath), "%s/WAVDEC", path);
-        break;
+  return CMN_SimpleFifoGetVacantSize(handle);
+}
 
-      case AS_CODECTYPE_OPUS:
-        snprintf(fullpath, sizeof(fullpath), "%s/OPUSDEC", path);
-        break;
+/*--------------------------------------------------------------------------*/
+bool MediaPlayer::check_decode_dsp(uint8_t codec_type, const char *path)
+{
+  return DspRegistry::getInstance()->isDecoderAvailable(codec_type, path);
+}
 
-      default:
-        print_err("Codec type %d is invalid value.\n", codec_type);
-        return false;
-    }
 
-  if (0 == strncmp("/mnt/sd0", path, 8))
+
+/*--------------------------------------------------------------------------*/
+void MediaPlayer::player0_input_callback(uint32_t size)
+{
+  MediaPlayer::getInstance()->notify_consumed(Player0);
+}
+
+/*--------------------------------------------------------------------------*/
+void MediaPlayer::player1_input_callback(uint32_t size)
+{
+  MediaPlayer::getInstance()->notify_consumed(Player1);
+}
+
+/*--------------------------------------------------------------------------*/
+void MediaPlayer::notify_consumed(PlayerId id)
+{
+  if (!m_metrics.isEnabled())
     {
-      /* In case that SD card isn't inserted, it times out at max 2 sec */
-      for (retry = 0; retry < 20; retry++) {
-        ret = stat("/mnt/sd0", &buf);
-        if (ret == 0)
-          {
-            break;
-          }
-        usleep(100 * 1000); // 100 msec
-      }
-      if (ret)
-        {
-          print_err("SD card is not present.\n");
-          return false;
-        }
+      return;
     }
 
-  FILE *fp = fopen(fullpath, "r");
-  if (fp == NULL)
+  int fifo = (id == Player0) ? AUDIOMETRICS_FIFO_PLAYER0 : AUDIOMETRICS_FIFO_PLAYER1;
+  CMN_SimpleFifoHandle *handle =
+    (id == Player0) ?
+      &m_player0_simple_fifo_handle : &m_player1_simple_fifo_handle;
+
+  uint32_t occupied = CMN_SimpleFifoGetOccupiedSize(handle);
+
+  m_metrics.sampleFifo(fifo, occupied);
+  if (occupied == 0)
     {
-      print_err("DSP file %s cannot open.\n", fullpath);
-      return false;
+      m_metrics.countUnderrun(fifo);
     }
+}
 
-  fclose(fp);
+/*--------------------------------------------------------------------------*/
+void MediaPlayer::player0_attention_callback(const ErrorAttentionParam *attparam)
+{
+  MediaPlayer::getInstance()->notify_attention(Player0, attparam);
+}
 
-  return true;
+/*--------------------------------------------------------------------------*/
+void MediaPlayer::player1_attention_callback(const ErrorAttentionParam *attparam)
+{
+  MediaPlayer::getInstance()->notify_attention(Player1, attparam);
 }
 
+/*--------------------------------------------------------------------------*/
+void MediaPlayer::notify_attention(PlayerId id, const ErrorAttentionParam *attparam)
+{
+  AudioAttentionCb attcb = m_attention_callback[(id == Player0) ? 0 : 1];
+
+  m_metrics.logAttention(attparam);
 
+  if (attcb)
+    {
+      attcb(attparam);
+    }
+  else
+    {
+      attentionCallback(attparam);
+    }
+}
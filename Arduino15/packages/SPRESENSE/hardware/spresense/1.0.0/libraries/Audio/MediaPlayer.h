@@ -38,6 +38,8 @@ class File;
 #include <audio/utilities/wav_containerformat_parser.h>
 #include <memutils/simple_fifo/CMN_SimpleFifo.h>
 
+#include "AudioMetrics.h"
+
 /*--------------------------------------------------------------------------*/
 
 /**
@@ -378,6 +380,32 @@ public:
       uint32_t size  /**< Size of audio data */
   );
 
+  /**
+   * @brief Get vacant size of FIFO
+   *
+   * @details This function returns the size of audio data which can be
+   *          supplied by writeFrames() without FIFO full.
+   *          Returns 0 if the player is not activated.
+   *
+   */
+
+  uint32_t getVacantSize(
+      PlayerId id /**< Select Player ID. */
+  );
+
+  /**
+   * @brief Get runtime statistics.
+   *
+   * @details FIFO fill levels, underrun and attention log of both players
+   *          are recorded after getMetrics()->enable().
+   *
+   */
+
+  AudioMetrics* getMetrics(void)
+    {
+      return &m_metrics;
+    }
+
 private:
 
   /**
@@ -387,7 +415,10 @@ private:
   MediaPlayer()
     : m_player0_simple_fifo_buf(NULL)
     , m_player1_simple_fifo_buf(NULL)
-  {}
+  {
+    m_attention_callback[0] = NULL;
+    m_attention_callback[1] = NULL;
+  }
   MediaPlayer(const MediaPlayer&);
   MediaPlayer& operator=(const MediaPlayer&);
   ~MediaPlayer() {}
@@ -405,6 +436,17 @@ private:
   char m_es_player0_buf[MEDIAPLAYER_BUF_FRAME_SIZE];
   char m_es_player1_buf[MEDIAPLAYER_BUF_FRAME_SIZE];
 
+  AudioAttentionCb m_attention_callback[2];
+  AudioMetrics     m_metrics;
+
+  static void player0_input_callback(uint32_t size);
+  static void player1_input_callback(uint32_t size);
+  void notify_consumed(PlayerId id);
+
+  static void player0_attention_callback(const ErrorAttentionParam *attparam);
+  static void player1_attention_callback(const ErrorAttentionParam *attparam);
+  void notify_attention(PlayerId id, const ErrorAttentionParam *attparam);
+
   err_t write_fifo(File& myFile, char *p_es_buf, CMN_SimpleFifoHandle *handle);
   err_t write_fifo(uint8_t *data, uint32_t size, CMN_SimpleFifoHandle *handle);
 
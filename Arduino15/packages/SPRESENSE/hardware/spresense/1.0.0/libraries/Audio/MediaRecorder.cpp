@@ -28,16 +28,11 @@
 
 #include "MediaRecorder.h"
 #include "MemoryUtil.h"
+#include "DspRegistry.h"
 
 
 #include <File.h>
 
-/*--------------------------------------------------------------------------*/
-void  output_device_callback(uint32_t size)
-{
-    /* do nothing */
-}
-
 extern "C" {
 
 static void attentionCallback(const ErrorAttentionParam *attparam)
@@ -94,7 +89,9 @@ err_t MediaRecorder::begin(AudioAttentionCb attcb, bool use_frontend)
   recorder_create_param.pool_id.output   = S0_OUTPUT_BUF_POOL;
   recorder_create_param.pool_id.dsp      = S0_ENC_APU_CMD_POOL;
 
-  result = AS_CreateMediaRecorder(&recorder_create_param, (attcb) ? attcb : attentionCallback);
+  m_attention_callback = attcb;
+
+  result = AS_CreateMediaRecorder(&recorder_create_param, attention_callback);
   if (!result)
     {
       print_err("Error: AS_CreateMediaRecorder() failure!\n");
@@ -186,6 +183,8 @@ err_t MediaRecorder::activate(AsSetRecorderStsInputDevice input_device,
 
   CMN_SimpleFifoClear(&m_recorder_simple_fifo_handle);
 
+  m_metrics.setCapacity(AUDIOMETRICS_FIFO_RECORDER, recorder_bufsize);
+
   bool result;
 
   if (m_p_fed_ins)
@@ -205,7 +204,7 @@ err_t MediaRecorder::activate(AsSetRecorderStsInputDevice input_device,
   AsActivateRecorder recorder_act;
 
   m_output_device_handler.simple_fifo_handler = (void*)(&m_recorder_simple_fifo_handle);
-  m_output_device_handler.callback_function   = output_device_callback;
+  m_output_device_handler.callback_function   = recorder_output_callback;
 
   recorder_act.param.input_device          = input_device;
   recorder_act.param.output_device         = AS_SETRECDR_STS_OUTPUTDEVICE_RAM;
@@ -213,6 +212,8 @@ err_t MediaRecorder::activate(AsSetRecorderStsInputDevice input_device,
   recorder_act.param.output_device_handler = &m_output_device_handler;
   recorder_act.cb                          = NULL;
 
+  uint32_t cmd_start = m_metrics.beginCommand();
+
   result = AS_ActivateMediaRecorder(&recorder_act);
   if (!result)
     {
@@ -228,6 +229,8 @@ err_t MediaRecorder::activate(AsSetRecorderStsInputDevice input_device,
       return MEDIARECORDER_ECODE_COMMAND_ERROR;
     }
 
+  m_metrics.endCommand(cmd_start);
+
   if (reply_info.result != AS_ECODE_OK)
     {
       m_mr_callback(AsRecorderEventAct, reply_info.result, 0);
@@ -334,6 +337,8 @@ err_t MediaRecorder::init(uint8_t codec_type,
         break;
     }
 
+  uint32_t cmd_start = m_metrics.beginCommand();
+
   result = AS_InitMediaRecorder(&init_param);
   if (!result)
     {
@@ -349,6 +354,8 @@ err_t MediaRecorder::init(uint8_t codec_type,
       return MEDIARECORDER_ECODE_COMMAND_ERROR;
     }
 
+  m_metrics.endCommand(cmd_start);
+
   m_mr_callback(AsRecorderEventInit, reply_info.result, 0);
 
   return MEDIARECORDER_ECODE_OK;
@@ -422,6 +429,8 @@ err_t MediaRecorder::start(void)
 
   /* Start MediaRecorder */
 
+  uint32_t cmd_start = m_metrics.beginCommand();
+
   result = AS_StartMediaRecorder();
   if (!result)
     {
@@ -437,6 +446,8 @@ err_t MediaRecorder::start(void)
       return MEDIARECORDER_ECODE_COMMAND_ERROR;
     }
 
+  m_metrics.endCommand(cmd_start);
+
   m_mr_callback(AsRecorderEventStart, reply_info.result, 0);
 
   return MEDIARECORDER_ECODE_OK;
@@ -461,6 +472,8 @@ err_t MediaRecorder::stop(void)
 
   /* Stop MediaRecorder */
 
+  uint32_t cmd_start = m_metrics.beginCommand();
+
   result = AS_StopMediaRecorder();
   if (!result)
     {
@@ -476,6 +489,8 @@ err_t MediaRecorder::stop(void)
       return MEDIARECORDER_ECODE_COMMAND_ERROR;
     }
 
+  m_metrics.endCommand(cmd_start);
+
   m_mr_callback(AsRecorderEventStop, reply_info.result, 0);
 
   return MEDIARECORDER_ECODE_OK;
@@ -500,6 +515,8 @@ err_t MediaRecorder::deactivate(void)
 
   /* Deactivate MediaRecorder */
 
+  uint32_t cmd_start = m_metrics.beginCommand();
+
   result = AS_DeactivateMediaRecorder();
   if (!result)
     {
@@ -515,6 +532,8 @@ err_t MediaRecorder::deactivate(void)
       return MEDIARECORDER_ECODE_COMMAND_ERROR;
     }
 
+  m_metrics.endCommand(cmd_start);
+
   if (reply_info.result != AS_ECODE_OK)
     {
       m_mr_callback(AsRecorderEventDeact, reply_info.result, 0);
@@ -601,6 +620,80 @@ err_t MediaRecorder::readFrames(uint8_t* p_buffer, uint32_t buffer_size, uint32_
   return rst;
 }
 
+/*--------------------------------------------------------------------------*/
+err_t MediaRecorder::peekFrames(const uint8_t** area1, uint32_t* size1, const uint8_t** area2, uint32_t* size2)
+{
+  if (!area1 || !size1 || !area2 || !size2)
+    {
+      print_err("ERROR: Area not specified.\n");
+      return MEDIARECORDER_ECODE_BUFFER_AREA_ERROR;
+    }
+
+  *area1 = NULL;
+  *size1 = 0;
+  *area2 = NULL;
+  *size2 = 0;
+
+  if (m_recorder_simple_fifo_buf == NULL)
+    {
+      print_err("ERROR: FIFO area is not allcated.\n");
+      return MEDIARECORDER_ECODE_BUFFER_AREA_ERROR;
+    }
+
+  size_t data_size = CMN_SimpleFifoGetOccupiedSize(&m_recorder_simple_fifo_handle);
+  if (data_size == 0)
+    {
+      return MEDIARECORDER_ECODE_OK;
+    }
+
+  CMN_SimpleFifoPeekHandle peek_handle;
+  if (CMN_SimpleFifoPeek(&m_recorder_simple_fifo_handle, &peek_handle, data_size) == 0)
+    {
+      print_err("ERROR: Fail to peek data in simple FIFO.\n");
+      return MEDIARECORDER_ECODE_BUFFER_POLL_ERROR;
+    }
+
+  *area1 = (const uint8_t*)peek_handle.m_pChunk1;
+  *size1 = (uint32_t)peek_handle.m_sz1;
+  *area2 = (const uint8_t*)peek_handle.m_pChunk2;
+  *size2 = (uint32_t)peek_handle.m_sz2;
+
+  return MEDIARECORDER_ECODE_OK;
+}
+
+/*--------------------------------------------------------------------------*/
+err_t MediaRecorder::releaseFrames(uint32_t size)
+{
+  if (m_recorder_simple_fifo_buf == NULL)
+    {
+      print_err("ERROR: FIFO area is not allcated.\n");
+      return MEDIARECORDER_ECODE_BUFFER_AREA_ERROR;
+    }
+
+  if (size == 0)
+    {
+      return MEDIARECORDER_ECODE_OK;
+    }
+
+  if (size > CMN_SimpleFifoGetOccupiedSize(&m_recorder_simple_fifo_handle))
+    {
+      print_err("ERROR: Release size exceeds recorded data.\n");
+      return MEDIARECORDER_ECODE_BUFFER_SIZE_ERROR;
+    }
+
+  /* Poll without destination buffer only moves read pointer of FIFO. */
+
+  if (CMN_SimpleFifoPoll(&m_recorder_simple_fifo_handle, NULL, size) == 0)
+    {
+      print_err("ERROR: Fail to release data in simple FIFO.\n");
+      return MEDIARECORDER_ECODE_BUFFER_POLL_ERROR;
+    }
+
+  m_es_size += size;
+
+  return MEDIARECORDER_ECODE_OK;
+}
+
 /*--------------------------------------------------------------------------*/
 err_t MediaRecorder::writeWavHeader(File& myfile)
 {
@@ -624,66 +717,21 @@ err_t MediaRecorder::writeWavHeader(File& myfile)
 /*--------------------------------------------------------------------------*/
 bool MediaRecorder::check_encode_dsp(uint8_t codec_type, const char *path, uint32_t sampling_rate)
 {
-  char fullpath[32] = { 0 };
   cxd56_audio_clkmode_t clk = CXD56_AUDIO_CLKMODE_NORMAL;
-  struct stat buf;
-  int retry;
-  int ret = 0;
-  
-  switch (codec_type)
-    {
-      case AS_CODECTYPE_MP3:
-        snprintf(fullpath, sizeof(fullpath), "%s/MP3ENC", path);
-        break;
-
-      case AS_CODECTYPE_WAV:
-      case AS_CODECTYPE_LPCM:
-        clk = cxd56_audio_get_clkmode();
-        if (!((clk == CXD56_AUDIO_CLKMODE_NORMAL && sampling_rate != AS_SAMPLINGRATE_48000)
-           || (clk == CXD56_AUDIO_CLKMODE_HIRES && sampling_rate != AS_SAMPLINGRATE_192000)))
-          {
-            return true;
-          }
-        snprintf(fullpath, sizeof(fullpath), "%s/SRC", path);
-        break;
 
-      case AS_CODECTYPE_OPUS:
-        snprintf(fullpath, sizeof(fullpath), "%s/OPUSENC", path);
-        break;
+  /* Sampling rate converter is not needed for the native rate. */
 
-      default:
-        print_err("Codec type %d is invalid value.\n", codec_type);
-        return false;
-    }
-
-  if (0 == strncmp("/mnt/sd0", path, 8))
-    {
-      /* In case that SD card isn't inserted, it times out at max 2 sec */
-      for (retry = 0; retry < 20; retry++) {
-        ret = stat("/mnt/sd0", &buf);
-        if (ret == 0)
-          {
-            break;
-          }
-        usleep(100 * 1000); // 100 msec
-      }
-      if (ret)
+  if ((codec_type == AS_CODECTYPE_WAV) || (codec_type == AS_CODECTYPE_LPCM))
+    {
+      clk = cxd56_audio_get_clkmode();
+      if (!((clk == CXD56_AUDIO_CLKMODE_NORMAL && sampling_rate != AS_SAMPLINGRATE_48000)
+         || (clk == CXD56_AUDIO_CLKMODE_HIRES && sampling_rate != AS_SAMPLINGRATE_192000)))
         {
-          print_err("SD card is not present.\n");
-          return false;
+          return true;
         }
     }
 
-  FILE *fp = fopen(fullpath, "r");
-  if (fp == NULL)
-    {
-      print_err("DSP file %s cannot open.\n", fullpath);
-      return false;
-    }
-
-  fclose(fp);
-
-  return true;
+  return DspRegistry::getInstance()->isEncoderAvailable(codec_type, path);
 }
 
 /*--------------------------------------------------------------------------*/
@@ -698,5 +746,40 @@ bool MediaRecorder::setCapturingClkMode(uint8_t clk_mode)
   return false;
 }
 
+/****************************************************************************
+ * Private API on MediaRecorder Class
+ ****************************************************************************/
+
+void MediaRecorder::recorder_output_callback(uint32_t size)
+{
+  MediaRecorder *ins = MediaRecorder::getInstance();
+
+  if (!ins->m_metrics.isEnabled())
+    {
+      return;
+    }
+
+  /* Dropped frames are counted by the attention of FIFO overflow. */
+
+  CMN_SimpleFifoHandle *handle = &ins->m_recorder_simple_fifo_handle;
+
+  ins->m_metrics.sampleFifo(AUDIOMETRICS_FIFO_RECORDER,
+                            CMN_SimpleFifoGetOccupiedSize(handle));
+}
+
+/*--------------------------------------------------------------------------*/
+void MediaRecorder::attention_callback(const ErrorAttentionParam *attparam)
+{
+  MediaRecorder *ins = MediaRecorder::getInstance();
 
+  ins->m_metrics.logAttention(attparam);
 
+  if (ins->m_attention_callback)
+    {
+      ins->m_attention_callback(attparam);
+    }
+  else
+    {
+      attentionCallback(attparam);
+    }
+}
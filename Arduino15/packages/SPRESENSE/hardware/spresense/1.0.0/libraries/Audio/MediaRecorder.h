@@ -40,6 +40,7 @@ class File;
 #include <memutils/simple_fifo/CMN_SimpleFifo.h>
 
 #include "FrontEnd.h"
+#include "AudioMetrics.h"
 
 /*--------------------------------------------------------------------------*/
 
@@ -309,6 +310,34 @@ public:
       uint32_t* read_size
   );
 
+  /**
+   * @brief Peek recorded audio data without copying
+   *
+   * @details This function returns the areas of encoded audio data inside
+   *          the internal FIFO, instead of copying them to a buffer.
+   *          Because FIFO is a ring buffer, the data may be divided into
+   *          two areas. When it is not divided, size2 is 0.
+   *          After processing the data, call releaseFrames() to release them.
+   *
+   */
+
+  err_t peekFrames(
+      const uint8_t** area1,
+      uint32_t* size1,
+      const uint8_t** area2,
+      uint32_t* size2
+  );
+
+  /**
+   * @brief Release recorded audio data
+   *
+   * @details This function releases the data returned by peekFrames() from
+   *          the head of the internal FIFO.
+   *
+   */
+
+  err_t releaseFrames(uint32_t size);
+
   /**
    * @brief Write WAV header to file
    *
@@ -331,6 +360,19 @@ public:
       uint8_t clk_mode /**< Set clock mode. MEDIARECORDER_CAPCLK_NORMAL, MEDIARECORDER_CAPCLK_HIRESO */
   );
 
+  /**
+   * @brief Get runtime statistics.
+   *
+   * @details FIFO fill level, overrun, command round trip time and attention
+   *          log are recorded after getMetrics()->enable().
+   *
+   */
+
+  AudioMetrics* getMetrics(void)
+    {
+      return &m_metrics;
+    }
+
 private:
 
   /**
@@ -341,6 +383,7 @@ private:
     : m_recorder_simple_fifo_buf(NULL)
     , m_mr_callback(NULL)
     , m_p_fed_ins(NULL)
+    , m_attention_callback(NULL)
   {}
   MediaRecorder(const MediaRecorder&);
   MediaRecorder& operator=(const MediaRecorder&);
@@ -361,6 +404,12 @@ private:
 
   FrontEnd *m_p_fed_ins;
 
+  AudioAttentionCb m_attention_callback;
+  AudioMetrics     m_metrics;
+
+  static void recorder_output_callback(uint32_t size);
+  static void attention_callback(const ErrorAttentionParam *attparam);
+
   bool check_encode_dsp(uint8_t codec_type, const char *path, uint32_t sampling_rate);
 
   /**
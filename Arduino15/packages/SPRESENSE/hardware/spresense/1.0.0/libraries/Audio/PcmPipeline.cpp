@@ -0,0 +1,388 @@
+/*
+ *  PcmPipeline.cpp - Low latency PCM processing from FrontEnd to OutputMixer
+ *  Copyright 2018 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+//***************************************************************************
+// Included Files
+//***************************************************************************
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <cmsis/arm_math.h>
+
+#include "PcmPipeline.h"
+
+/****************************************************************************
+ * Public API on PcmPipeline Class
+ ****************************************************************************/
+
+err_t PcmPipeline::begin(AudioAttentionCb attcb)
+{
+  if (FrontEnd::getInstance()->begin(attcb) != FRONTEND_ECODE_OK)
+    {
+      return PCMPIPELINE_ECODE_COMMAND_ERROR;
+    }
+
+  OutputMixer *mixer = OutputMixer::getInstance();
+
+  if (mixer->begin() != OUTPUTMIXER_ECODE_OK)
+    {
+      return PCMPIPELINE_ECODE_COMMAND_ERROR;
+    }
+
+  if (((attcb) ? mixer->create(attcb) : mixer->create()) != OUTPUTMIXER_ECODE_OK)
+    {
+      return PCMPIPELINE_ECODE_COMMAND_ERROR;
+    }
+
+  return PCMPIPELINE_ECODE_OK;
+}
+
+/*--------------------------------------------------------------------------*/
+err_t PcmPipeline::end(void)
+{
+  FrontEnd::getInstance()->end();
+  OutputMixer::getInstance()->end();
+
+  return PCMPIPELINE_ECODE_OK;
+}
+
+/*--------------------------------------------------------------------------*/
+err_t PcmPipeline::activate(AsOutputMixerHandle handle, uint8_t output_device)
+{
+  FrontEnd *frontend = FrontEnd::getInstance();
+
+  m_handle = handle;
+
+  /* Capture and rendering must run on the same clock to pass the frame
+   * as is.
+   */
+
+  frontend->setCapturingClkMode(FRONTEND_CAPCLK_NORMAL);
+  OutputMixer::getInstance()->setRenderingClkMode(OUTPUTMIXER_RNDCLK_NORMAL);
+
+  /* Activate FrontEnd without callback, so that each API returns after
+   * the completion.
+   */
+
+  if (frontend->activate(NULL) != FRONTEND_ECODE_OK)
+    {
+      return PCMPIPELINE_ECODE_COMMAND_ERROR;
+    }
+
+  if (OutputMixer::getInstance()->activate(handle,
+                                           output_device,
+                                           outputmixer_done_callback) != OUTPUTMIXER_ECODE_OK)
+    {
+      return PCMPIPELINE_ECODE_COMMAND_ERROR;
+    }
+
+  usleep(100 * 1000); /* waiting for Mic startup */
+
+  return PCMPIPELINE_ECODE_OK;
+}
+
+/*--------------------------------------------------------------------------*/
+err_t PcmPipeline::init(uint32_t samples_per_frame)
+{
+  if (samples_per_frame == 0)
+    {
+      return PCMPIPELINE_ECODE_PARAM_ERROR;
+    }
+
+  AsDataDest dst;
+  dst.cb = frontend_pcm_callback;
+
+  if (FrontEnd::getInstance()->init(AS_CHANNEL_STEREO,
+                                    AS_BITLENGTH_16,
+                                    samples_per_frame,
+                                    AsDataPathCallback,
+                                    dst) != FRONTEND_ECODE_OK)
+    {
+      return PCMPIPELINE_ECODE_COMMAND_ERROR;
+    }
+
+  return PCMPIPELINE_ECODE_OK;
+}
+
+/*--------------------------------------------------------------------------*/
+int PcmPipeline::addStage(PcmStageFunc func, void *arg)
+{
+  if (!func || (m_stage_num >= PCMPIPELINE_STAGE_NUM))
+    {
+      return -1;
+    }
+
+  /* Fill the entry before counting it, so that the callback never sees
+   * a half-written stage.
+   */
+
+  int num = m_stage_num;
+
+  m_stage[num].func   = func;
+  m_stage[num].arg    = arg;
+  m_stage[num].bypass = false;
+
+  m_stage_num = num + 1;
+
+  return num;
+}
+
+/*--------------------------------------------------------------------------*/
+err_t PcmPipeline::setBypass(int stage, bool bypass)
+{
+  if ((stage < 0) || (stage >= m_stage_num))
+    {
+      return PCMPIPELINE_ECODE_PARAM_ERROR;
+    }
+
+  m_stage[stage].bypass = bypass;
+
+  return PCMPIPELINE_ECODE_OK;
+}
+
+/*--------------------------------------------------------------------------*/
+void PcmPipeline::clearStages(void)
+{
+  m_stage_num = 0;
+}
+
+/*--------------------------------------------------------------------------*/
+err_t PcmPipeline::start(void)
+{
+  m_frames  = 0;
+  m_invalid = 0;
+  m_is_end  = false;
+
+  if (FrontEnd::getInstance()->start() != FRONTEND_ECODE_OK)
+    {
+      return PCMPIPELINE_ECODE_COMMAND_ERROR;
+    }
+
+  return PCMPIPELINE_ECODE_OK;
+}
+
+/*--------------------------------------------------------------------------*/
+err_t PcmPipeline::stop(void)
+{
+  if (FrontEnd::getInstance()->stop() != FRONTEND_ECODE_OK)
+    {
+      return PCMPIPELINE_ECODE_COMMAND_ERROR;
+    }
+
+  return PCMPIPELINE_ECODE_OK;
+}
+
+/*--------------------------------------------------------------------------*/
+err_t PcmPipeline::deactivate(void)
+{
+  err_t ret = PCMPIPELINE_ECODE_OK;
+
+  if (FrontEnd::getInstance()->deactivate() != FRONTEND_ECODE_OK)
+    {
+      ret = PCMPIPELINE_ECODE_COMMAND_ERROR;
+    }
+
+  if (OutputMixer::getInstance()->deactivate(m_handle) != OUTPUTMIXER_ECODE_OK)
+    {
+      ret = PCMPIPELINE_ECODE_COMMAND_ERROR;
+    }
+
+  return ret;
+}
+
+/*--------------------------------------------------------------------------*/
+err_t PcmPipeline::setVolume(int volume)
+{
+  /* Input volumes of both players are 0dB, and the master controls. */
+
+  if (OutputMixer::getInstance()->setVolume(volume, 0, 0) != OUTPUTMIXER_ECODE_OK)
+    {
+      return PCMPIPELINE_ECODE_COMMAND_ERROR;
+    }
+
+  return PCMPIPELINE_ECODE_OK;
+}
+
+/****************************************************************************
+ * Built-in stages on PcmPipeline Class
+ ****************************************************************************/
+
+void PcmPipeline::gainStage(int16_t *pcm, uint32_t frames, void *arg)
+{
+  int32_t gain = ((PcmGain *)arg)->gain;
+
+  for (uint32_t i = 0; i < frames * 2; i++)
+    {
+      pcm[i] = __SSAT((pcm[i] * gain) >> 12, 16);
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+void PcmPipeline::biquadStage(int16_t *pcm, uint32_t frames, void *arg)
+{
+  PcmBiquad *bq = (PcmBiquad *)arg;
+  const int16_t *c = bq->coef;
+
+  for (int ch = 0; ch < 2; ch++)
+    {
+      int16_t x1 = bq->x1[ch];
+      int16_t x2 = bq->x2[ch];
+      int16_t y1 = bq->y1[ch];
+      int16_t y2 = bq->y2[ch];
+      int16_t *p = &pcm[ch];
+
+      for (uint32_t i = 0; i < frames; i++, p += 2)
+        {
+          int16_t x = *p;
+          int64_t acc = (int64_t)c[0] * x + (int64_t)c[1] * x1 + (int64_t)c[2] * x2
+                      - (int64_t)c[3] * y1 - (int64_t)c[4] * y2;
+          int16_t y = __SSAT((int32_t)(acc >> 14), 16);
+
+          x2 = x1;
+          x1 = x;
+          y2 = y1;
+          y1 = y;
+          *p = y;
+        }
+
+      bq->x1[ch] = x1;
+      bq->x2[ch] = x2;
+      bq->y1[ch] = y1;
+      bq->y2[ch] = y2;
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+void PcmPipeline::firStage(int16_t *pcm, uint32_t frames, void *arg)
+{
+  PcmFir *fir = (PcmFir *)arg;
+  uint16_t taps = (fir->taps > PCMPIPELINE_FIR_TAP_MAX) ? PCMPIPELINE_FIR_TAP_MAX : fir->taps;
+
+  if (taps == 0)
+    {
+      return;
+    }
+
+  /* delay[ch] is a ring of the latest samples, and pos is the oldest. */
+
+  uint16_t pos = fir->pos;
+
+  for (uint32_t i = 0; i < frames; i++)
+    {
+      for (int ch = 0; ch < 2; ch++)
+        {
+          int16_t *d = fir->delay[ch];
+          int64_t acc = 0;
+          uint16_t k = pos;
+
+          d[pos] = pcm[i * 2 + ch];
+
+          for (int t = 0; t < taps; t++)
+            {
+              acc += (int32_t)fir->coef[t] * d[k];
+              k = (k == 0) ? taps - 1 : k - 1;
+            }
+
+          pcm[i * 2 + ch] = __SSAT((int32_t)(acc >> 15), 16);
+        }
+
+      pos = (pos + 1 == taps) ? 0 : pos + 1;
+    }
+
+  fir->pos = pos;
+}
+
+/****************************************************************************
+ * Private API on PcmPipeline Class
+ ****************************************************************************/
+
+void PcmPipeline::process(AsPcmDataParam& pcm)
+{
+  if (!pcm.is_valid)
+    {
+      m_invalid++;
+    }
+  else if (pcm.size > 0)
+    {
+      /* Process in place on the captured segment. */
+
+      int16_t *ptr = (int16_t *)pcm.mh.getPa();
+      uint32_t frames = pcm.size / 4;
+      int num = m_stage_num;
+
+      for (int i = 0; i < num; i++)
+        {
+          if (!m_stage[i].bypass)
+            {
+              m_stage[i].func(ptr, frames, m_stage[i].arg);
+            }
+        }
+    }
+
+  /* Pass the same memory handle to OutputMixer. It keeps the segment
+   * until rendered, and releases it to the capture pool.
+   */
+
+  pcm.identifier = m_handle;
+  pcm.callback   = 0;
+
+  if (!pcm.is_valid || (pcm.size == 0))
+    {
+      if (!pcm.is_end)
+        {
+          return;
+        }
+      pcm.size = 0;
+    }
+
+  if (OutputMixer::getInstance()->sendData(m_handle,
+                                           outmixer_send_callback,
+                                           pcm) != OUTPUTMIXER_ECODE_OK)
+    {
+      print_err("OutputMixer send error\n");
+      return;
+    }
+
+  m_frames++;
+}
+
+/*--------------------------------------------------------------------------*/
+void PcmPipeline::frontend_pcm_callback(AsPcmDataParam pcm)
+{
+  getInstance()->process(pcm);
+}
+
+/*--------------------------------------------------------------------------*/
+void PcmPipeline::outmixer_send_callback(int32_t identifier, bool is_end)
+{
+  if (is_end)
+    {
+      getInstance()->m_is_end = true;
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+void PcmPipeline::outputmixer_done_callback(MsgQueId requester_dtq,
+                                            MsgType reply_of,
+                                            AsOutputMixDoneParam *done_param)
+{
+  return;
+}
@@ -0,0 +1,301 @@
+/*
+ *  PcmPipeline.h - Low latency PCM processing from FrontEnd to OutputMixer
+ *  Copyright 2018 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef PcmPipeline_h
+#define PcmPipeline_h
+
+#ifdef SUBCORE
+#error "Audio library is NOT supported by SubCore."
+#endif
+
+/**
+ * @file PcmPipeline.h
+ * @author Sony Semiconductor Solutions Corporation
+ * @brief Low latency PCM processing from FrontEnd to OutputMixer.
+ * @details Captured frames are processed by a chain of stages in the
+ *          capture callback, and sent to OutputMixer in the same memory
+ *          handle. Nothing is copied between capture, stages and rendering.
+ */
+
+#include <stdint.h>
+
+#include "FrontEnd.h"
+#include "OutputMixer.h"
+
+/*--------------------------------------------------------------------------*/
+
+/**
+ * PcmPipeline Error Code Definitions.
+ */
+
+#define PCMPIPELINE_ECODE_OK            0
+#define PCMPIPELINE_ECODE_COMMAND_ERROR 1
+#define PCMPIPELINE_ECODE_STATE_ERROR   2
+#define PCMPIPELINE_ECODE_PARAM_ERROR   3
+
+/**
+ * PcmPipeline settings.
+ */
+
+#define PCMPIPELINE_STAGE_NUM           8
+#define PCMPIPELINE_FIR_TAP_MAX         32
+#define PCMPIPELINE_FRAME_SAMPLE_DEFAULT 240  /* 5ms at 48kHz */
+
+/*--------------------------------------------------------------------------*/
+
+/**
+ * Stage function. pcm is 16bit interleaved stereo, processed in place.
+ */
+
+typedef void (*PcmStageFunc)(int16_t *pcm, uint32_t frames, void *arg);
+
+/**
+ * Parameter of PcmPipeline::gainStage. gain is q12 (4096 is 0dB).
+ */
+
+typedef struct
+{
+  int16_t gain;
+} PcmGain;
+
+/**
+ * Parameter of PcmPipeline::biquadStage.
+ * coef is {b0, b1, b2, a1, a2} in q14, and a0 is normalized to 1.
+ */
+
+typedef struct
+{
+  int16_t coef[5];
+  int16_t x1[2];
+  int16_t x2[2];
+  int16_t y1[2];
+  int16_t y2[2];
+} PcmBiquad;
+
+/**
+ * Parameter of PcmPipeline::firStage. coef is q15.
+ */
+
+typedef struct
+{
+  const int16_t *coef;
+  uint16_t       taps;   /* Up to PCMPIPELINE_FIR_TAP_MAX */
+  uint16_t       pos;
+  int16_t        delay[2][PCMPIPELINE_FIR_TAP_MAX];
+} PcmFir;
+
+/*--------------------------------------------------------------------------*/
+
+/**
+ * @class PcmPipeline
+ * @brief Low latency PCM processing from FrontEnd to OutputMixer.
+ */
+
+class PcmPipeline
+{
+public:
+
+  /**
+   * @brief Get instance of PcmPipeline for singleton.
+   */
+
+  static PcmPipeline* getInstance()
+    {
+      static PcmPipeline instance;
+      return &instance;
+    }
+
+  /**
+   * @brief Initialize the PcmPipeline.
+   *
+   * @details This function begins FrontEnd and OutputMixer, and creates
+   *          the objects of them.
+   *
+   */
+
+  err_t begin(
+      AudioAttentionCb attcb = NULL /**< Attention callback of both objects */
+  );
+
+  /**
+   * @brief Finalize the PcmPipeline.
+   */
+
+  err_t end(void);
+
+  /**
+   * @brief Activate the PcmPipeline.
+   *
+   * @details This function activates FrontEnd and OutputMixer at normal
+   *          clock, and waits for the mic to start up.
+   *
+   */
+
+  err_t activate(
+      AsOutputMixerHandle handle = OutputMixer0, /**< OutputMixer0 or OutputMixer1 */
+      uint8_t output_device = HPOutputDevice     /**< HPOutputDevice or I2SOutputDevice */
+  );
+
+  /**
+   * @brief Initialize the PcmPipeline.
+   *
+   * @details Frames are 16bit stereo, so that the captured frame can be
+   *          rendered as is. Latency from mic to speaker is about two frames
+   *          plus the processing time, so smaller frames give lower latency
+   *          with more load. Capture buffer pool must have enough segments
+   *          for the frames queued in OutputMixer.
+   *
+   */
+
+  err_t init(
+      uint32_t samples_per_frame = PCMPIPELINE_FRAME_SAMPLE_DEFAULT /**< Number of samples per frame */
+  );
+
+  /**
+   * @brief Add a stage to the end of the chain.
+   *
+   * @details Stages are called in the capture callback, in order of adding.
+   *          They can be added while running.
+   *
+   * @return Stage number, or -1 if no more stage can be added.
+   */
+
+  int addStage(
+      PcmStageFunc func, /**< Stage function */
+      void *arg          /**< Argument of func */
+  );
+
+  /**
+   * @brief Bypass a stage.
+   */
+
+  err_t setBypass(
+      int stage,  /**< Stage number */
+      bool bypass /**< true to bypass */
+  );
+
+  /**
+   * @brief Remove all stages.
+   */
+
+  void clearStages(void);
+
+  /**
+   * @brief Start capturing and rendering.
+   */
+
+  err_t start(void);
+
+  /**
+   * @brief Stop capturing.
+   *
+   * @details Frames already sent to OutputMixer are played out.
+   *
+   */
+
+  err_t stop(void);
+
+  /**
+   * @brief Deactivate the PcmPipeline.
+   */
+
+  err_t deactivate(void);
+
+  /**
+   * @brief Set rendering volume.
+   */
+
+  err_t setVolume(
+      int volume /**< -1020(-102db) - 120(12db) */
+  );
+
+  /**
+   * @brief Get number of frames sent to OutputMixer.
+   */
+
+  uint32_t getFrames(void)
+    {
+      return m_frames;
+    }
+
+  /**
+   * @brief Get number of invalid frames from FrontEnd.
+   */
+
+  uint32_t getInvalidFrames(void)
+    {
+      return m_invalid;
+    }
+
+  /**
+   * @brief Check if the end of capture has been rendered.
+   */
+
+  bool isEnd(void)
+    {
+      return m_is_end;
+    }
+
+  /**
+   * Built-in stages
+   */
+
+  static void gainStage(int16_t *pcm, uint32_t frames, void *arg);
+  static void biquadStage(int16_t *pcm, uint32_t frames, void *arg);
+  static void firStage(int16_t *pcm, uint32_t frames, void *arg);
+
+private:
+
+  /**
+   * To avoid create multiple instance
+   */
+
+  PcmPipeline()
+    : m_handle(OutputMixer0)
+    , m_stage_num(0)
+    , m_frames(0)
+    , m_invalid(0)
+    , m_is_end(false)
+  {}
+  PcmPipeline(const PcmPipeline&);
+  PcmPipeline& operator=(const PcmPipeline&);
+  ~PcmPipeline() {}
+
+  struct Stage
+  {
+    PcmStageFunc  func;
+    void         *arg;
+    volatile bool bypass;
+  };
+
+  static void frontend_pcm_callback(AsPcmDataParam pcm);
+  static void outmixer_send_callback(int32_t identifier, bool is_end);
+  static void outputmixer_done_callback(MsgQueId requester_dtq, MsgType reply_of, AsOutputMixDoneParam *done_param);
+
+  void process(AsPcmDataParam& pcm);
+
+  AsOutputMixerHandle m_handle;
+  Stage               m_stage[PCMPIPELINE_STAGE_NUM];
+  volatile int        m_stage_num;
+  volatile uint32_t   m_frames;
+  volatile uint32_t   m_invalid;
+  volatile bool       m_is_end;
+};
+
+#endif // PcmPipeline_h
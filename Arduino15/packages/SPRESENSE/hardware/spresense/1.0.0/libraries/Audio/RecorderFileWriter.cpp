@@ -0,0 +1,294 @@
+/*
+ *  RecorderFileWriter.cpp - Write-behind file writer for audio recording
+ *  Copyright 2018 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+//***************************************************************************
+// Included Files
+//***************************************************************************
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <File.h>
+
+#include "RecorderFileWriter.h"
+
+/****************************************************************************
+ * Public API on RecorderFileWriter Class
+ ****************************************************************************/
+
+RecorderFileWriter::RecorderFileWriter()
+  : m_file(NULL)
+  , m_block_size(0)
+  , m_block_num(0)
+  , m_limit(0)
+  , m_fill(0)
+  , m_write(0)
+  , m_pending(0)
+  , m_running(false)
+{
+  for (int i = 0; i < RECORDERFILEWRITER_MAX_BLOCK; i++)
+    {
+      m_block[i] = NULL;
+      m_used[i]  = 0;
+    }
+  memset(&m_stats, 0, sizeof(m_stats));
+}
+
+/*--------------------------------------------------------------------------*/
+RecorderFileWriter::~RecorderFileWriter()
+{
+  end();
+}
+
+/*--------------------------------------------------------------------------*/
+int RecorderFileWriter::begin(File& file, uint32_t block_size, int block_num, size_t stack_size)
+{
+  struct sched_param param;
+  pthread_attr_t tattr;
+
+  if (m_running)
+    {
+      return RECORDERFILEWRITER_ECODE_STATE_ERROR;
+    }
+
+  if ((block_num < 2) || (block_num > RECORDERFILEWRITER_MAX_BLOCK) || (block_size == 0))
+    {
+      return RECORDERFILEWRITER_ECODE_STATE_ERROR;
+    }
+
+  for (int i = 0; i < block_num; i++)
+    {
+      m_block[i] = (uint8_t *)malloc(block_size);
+      m_used[i]  = 0;
+      if (!m_block[i])
+        {
+          for (int j = 0; j < i; j++)
+            {
+              free(m_block[j]);
+              m_block[j] = NULL;
+            }
+          return RECORDERFILEWRITER_ECODE_ALLOC_ERROR;
+        }
+    }
+
+  m_file       = &file;
+  m_block_size = block_size;
+  m_block_num  = block_num;
+  m_fill       = 0;
+  m_write      = 0;
+  m_pending    = 0;
+  memset(&m_stats, 0, sizeof(m_stats));
+
+  /* Shorten the first block to align following writes to block size. */
+
+  m_limit = block_size - (file.position() % block_size);
+
+  pthread_mutex_init(&m_lock, NULL);
+  sem_init(&m_full_sem, 0, 0);
+
+  pthread_attr_init(&tattr);
+  pthread_attr_setstacksize(&tattr, stack_size);
+  param.sched_priority = RECORDERFILEWRITER_PRIO;
+  pthread_attr_setschedparam(&tattr, &param);
+
+  m_running = true;
+  if (pthread_create(&m_tid, &tattr,
+                     (pthread_startroutine_t)RecorderFileWriter::writer_thread,
+                     (void *)this))
+    {
+      m_running = false;
+      sem_destroy(&m_full_sem);
+      pthread_mutex_destroy(&m_lock);
+      for (int i = 0; i < block_num; i++)
+        {
+          free(m_block[i]);
+          m_block[i] = NULL;
+        }
+      return RECORDERFILEWRITER_ECODE_THREAD_ERROR;
+    }
+  pthread_setname_np(m_tid, "rec_writer");
+
+  return RECORDERFILEWRITER_ECODE_OK;
+}
+
+/*--------------------------------------------------------------------------*/
+int RecorderFileWriter::end(void)
+{
+  if (!m_running)
+    {
+      return RECORDERFILEWRITER_ECODE_STATE_ERROR;
+    }
+
+  /* Pass the block being filled, and let the thread write all blocks.
+   * When all blocks are pending, m_fill is the block being written by the
+   * thread, and the rest of data has been already passed.
+   */
+
+  pthread_mutex_lock(&m_lock);
+  bool partial = (m_pending < m_block_num) && (m_used[m_fill] > 0);
+  pthread_mutex_unlock(&m_lock);
+
+  if (partial)
+    {
+      submit();
+    }
+
+  pthread_mutex_lock(&m_lock);
+  m_running = false;
+  pthread_mutex_unlock(&m_lock);
+  sem_post(&m_full_sem);
+  pthread_join(m_tid, NULL);
+
+  sem_destroy(&m_full_sem);
+  pthread_mutex_destroy(&m_lock);
+
+  for (int i = 0; i < m_block_num; i++)
+    {
+      free(m_block[i]);
+      m_block[i] = NULL;
+      m_used[i]  = 0;
+    }
+
+  m_file = NULL;
+
+  return (m_stats.errors) ? RECORDERFILEWRITER_ECODE_FILEACCESS_ERROR
+                          : RECORDERFILEWRITER_ECODE_OK;
+}
+
+/*--------------------------------------------------------------------------*/
+int RecorderFileWriter::write(const uint8_t* data, uint32_t size, uint32_t* stored)
+{
+  *stored = 0;
+
+  if (!m_running)
+    {
+      return RECORDERFILEWRITER_ECODE_STATE_ERROR;
+    }
+
+  while (size > 0)
+    {
+      /* All blocks are waiting for write. Leave the rest to the caller. */
+
+      if (getPending() >= m_block_num)
+        {
+          pthread_mutex_lock(&m_lock);
+          m_stats.stalls++;
+          pthread_mutex_unlock(&m_lock);
+          return RECORDERFILEWRITER_ECODE_BUFFER_FULL;
+        }
+
+      uint32_t room = m_limit - m_used[m_fill];
+      uint32_t copy = (size < room) ? size : room;
+
+      memcpy(m_block[m_fill] + m_used[m_fill], data, copy);
+      m_used[m_fill] += copy;
+      data    += copy;
+      size    -= copy;
+      *stored += copy;
+
+      if (m_used[m_fill] == m_limit)
+        {
+          submit();
+        }
+    }
+
+  return RECORDERFILEWRITER_ECODE_OK;
+}
+
+/*--------------------------------------------------------------------------*/
+int RecorderFileWriter::getPending(void)
+{
+  pthread_mutex_lock(&m_lock);
+  int pending = m_pending;
+  pthread_mutex_unlock(&m_lock);
+
+  return pending;
+}
+
+/****************************************************************************
+ * Private API on RecorderFileWriter Class
+ ****************************************************************************/
+
+void RecorderFileWriter::submit(void)
+{
+  pthread_mutex_lock(&m_lock);
+  m_pending++;
+  if (m_stats.max_pending < (uint32_t)m_pending)
+    {
+      m_stats.max_pending = m_pending;
+    }
+  pthread_mutex_unlock(&m_lock);
+
+  sem_post(&m_full_sem);
+
+  m_fill  = (m_fill + 1) % m_block_num;
+  m_limit = m_block_size;
+}
+
+/*--------------------------------------------------------------------------*/
+void *RecorderFileWriter::writer_thread(void *arg)
+{
+  RecorderFileWriter *self = (RecorderFileWriter *)arg;
+
+  for (;;)
+    {
+      while (sem_wait(&self->m_full_sem) < 0 && errno == EINTR);
+
+      pthread_mutex_lock(&self->m_lock);
+      if (self->m_pending == 0)
+        {
+          bool running = self->m_running;
+          pthread_mutex_unlock(&self->m_lock);
+          if (!running)
+            {
+              break;
+            }
+          continue;
+        }
+      pthread_mutex_unlock(&self->m_lock);
+
+      /* The block is owned by this thread until m_pending is decremented. */
+
+      int idx = self->m_write;
+      uint32_t start = millis();
+      size_t ret = self->m_file->write(self->m_block[idx], self->m_used[idx]);
+      uint32_t latency = millis() - start;
+
+      pthread_mutex_lock(&self->m_lock);
+      if (ret != self->m_used[idx])
+        {
+          self->m_stats.errors++;
+        }
+      self->m_stats.written += ret;
+      self->m_stats.blocks++;
+      if (self->m_stats.max_latency < latency)
+        {
+          self->m_stats.max_latency = latency;
+        }
+      self->m_used[idx] = 0;
+      self->m_write = (idx + 1) % self->m_block_num;
+      self->m_pending--;
+      pthread_mutex_unlock(&self->m_lock);
+    }
+
+  return NULL;
+}
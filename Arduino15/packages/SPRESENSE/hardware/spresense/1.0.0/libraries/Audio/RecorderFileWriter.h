@@ -0,0 +1,228 @@
+/*
+ *  RecorderFileWriter.h - Write-behind file writer for audio recording
+ *  Copyright 2018 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef RecorderFileWriter_h
+#define RecorderFileWriter_h
+
+#ifdef SUBCORE
+#error "Audio library is NOT supported by SubCore."
+#endif
+
+/**
+ * @file RecorderFileWriter.h
+ * @author Sony Semiconductor Solutions Corporation
+ * @brief Write-behind file writer for audio recording.
+ * @details Recorded data is gathered into large blocks and written to
+ *          the file from a dedicated low priority thread, so that the
+ *          recorder FIFO keeps being drained while SD card write stalls.
+ */
+
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdint.h>
+#include <stddef.h>
+
+class File;
+
+/*--------------------------------------------------------------------------*/
+
+/**
+ * RecorderFileWriter Error Code Definitions.
+ */
+
+#define RECORDERFILEWRITER_ECODE_OK              0
+#define RECORDERFILEWRITER_ECODE_STATE_ERROR     1
+#define RECORDERFILEWRITER_ECODE_ALLOC_ERROR     2
+#define RECORDERFILEWRITER_ECODE_THREAD_ERROR    3
+#define RECORDERFILEWRITER_ECODE_FILEACCESS_ERROR 4
+#define RECORDERFILEWRITER_ECODE_BUFFER_FULL     5
+#define RECORDERFILEWRITER_ECODE_RECORDER_ERROR  6
+
+/**
+ * RecorderFileWriter default settings.
+ */
+
+#define RECORDERFILEWRITER_BLOCK_SIZE   (32 * 1024)
+#define RECORDERFILEWRITER_BLOCK_NUM    3
+#define RECORDERFILEWRITER_MAX_BLOCK    8
+/** Stack of the writer thread. File::write() runs the FAT driver on it. */
+#define RECORDERFILEWRITER_STACK_SIZE   4096
+#define RECORDERFILEWRITER_PRIO         90
+
+/*--------------------------------------------------------------------------*/
+
+/**
+ * @class RecorderFileWriter
+ * @brief Write-behind file writer.
+ */
+
+class RecorderFileWriter
+{
+public:
+
+  /**
+   * @brief Statistics of write-behind.
+   */
+
+  typedef struct
+  {
+    uint64_t written;      /**< Total size written to file.(byte) */
+    uint32_t blocks;       /**< Number of blocks written to file. */
+    uint32_t max_latency;  /**< Maximum time of one block write.(ms) */
+    uint32_t max_pending;  /**< Maximum number of blocks waiting for write. */
+    uint32_t stalls;       /**< Times that all blocks were in use. */
+    uint32_t errors;       /**< Number of failed writes. */
+  } Stats;
+
+  RecorderFileWriter();
+  ~RecorderFileWriter();
+
+  /**
+   * @brief Start write-behind.
+   *
+   * @details This function allocates blocks and creates the writer thread.
+   *          Data is written at the current position of the file. The first
+   *          block is shortened so that following writes are aligned to
+   *          block_size in the file.
+   *          The file must not be accessed by others until end() is called.
+   *
+   */
+
+  int begin(
+      File& file,                                        /**< Output file. */
+      uint32_t block_size = RECORDERFILEWRITER_BLOCK_SIZE, /**< Size of one write.(byte) */
+      int block_num = RECORDERFILEWRITER_BLOCK_NUM,      /**< Number of blocks. 2 to RECORDERFILEWRITER_MAX_BLOCK. */
+      size_t stack_size = RECORDERFILEWRITER_STACK_SIZE  /**< Stack size of the writer thread.(byte) */
+  );
+
+  /**
+   * @brief Stop write-behind.
+   *
+   * @details This function writes remaining data, stops the writer thread
+   *          and frees blocks. After that, the file can be accessed, e.g.
+   *          for writing WAV header.
+   *
+   */
+
+  int end(void);
+
+  /**
+   * @brief Store data.
+   *
+   * @details This function copies data into blocks. Filled blocks are passed
+   *          to the writer thread. When all blocks are waiting for write,
+   *          only stored size is returned in stored, and the caller should
+   *          keep the rest and retry later.
+   *
+   */
+
+  int write(
+      const uint8_t* data, /**< Data to write. */
+      uint32_t size,       /**< Size of data.(byte) */
+      uint32_t* stored     /**< Size of stored data.(byte) */
+  );
+
+  /**
+   * @brief Move recorded data from a recorder.
+   *
+   * @details This function moves recorded data from the FIFO of recorder
+   *          (AudioClass or MediaRecorder) into blocks by peekFrames() and
+   *          releaseFrames(). Data which cannot be stored is left in the
+   *          FIFO, so it is not lost.
+   *          Call this function periodically during recording instead of
+   *          readFrames().
+   *
+   */
+
+  template <typename T> int fetch(T& recorder);
+
+  /**
+   * @brief Get statistics.
+   */
+
+  const Stats& getStats(void)
+    {
+      return m_stats;
+    }
+
+  /**
+   * @brief Get number of blocks waiting for write.
+   */
+
+  int getPending(void);
+
+private:
+
+  RecorderFileWriter(const RecorderFileWriter&);
+  RecorderFileWriter& operator=(const RecorderFileWriter&);
+
+  static void *writer_thread(void *arg);
+  void submit(void);
+
+  File*           m_file;
+  uint8_t*        m_block[RECORDERFILEWRITER_MAX_BLOCK];
+  uint32_t        m_used[RECORDERFILEWRITER_MAX_BLOCK];
+  uint32_t        m_block_size;
+  int             m_block_num;
+  uint32_t        m_limit;        /* Fill limit of current block */
+  int             m_fill;         /* Block index filled by caller */
+  int             m_write;        /* Block index written by thread */
+  int             m_pending;      /* Blocks waiting for write */
+  bool            m_running;
+
+  pthread_t       m_tid;
+  pthread_mutex_t m_lock;
+  sem_t           m_full_sem;
+
+  Stats           m_stats;
+};
+
+/*--------------------------------------------------------------------------*/
+
+template <typename T> int RecorderFileWriter::fetch(T& recorder)
+{
+  const uint8_t *area[2];
+  uint32_t size[2];
+  uint32_t stored;
+  int ret = RECORDERFILEWRITER_ECODE_OK;
+
+  if (!m_running)
+    {
+      return RECORDERFILEWRITER_ECODE_STATE_ERROR;
+    }
+
+  if (recorder.peekFrames(&area[0], &size[0], &area[1], &size[1]) != 0)
+    {
+      return RECORDERFILEWRITER_ECODE_RECORDER_ERROR;
+    }
+
+  for (int i = 0; i < 2 && size[i] > 0; i++)
+    {
+      ret = write(area[i], size[i], &stored);
+      recorder.releaseFrames(stored);
+      if (ret != RECORDERFILEWRITER_ECODE_OK)
+        {
+          break;
+        }
+    }
+
+  return ret;
+}
+
+#endif // RecorderFileWriter_h
@@ -0,0 +1,523 @@
+/*
+ *  SoundMixer.cpp - Software mixer of PCM clips for OutputMixer
+ *  Copyright 2018 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+//***************************************************************************
+// Included Files
+//***************************************************************************
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <cmsis/arm_math.h>
+#include <File.h>
+
+#include "SoundMixer.h"
+
+static inline uint16_t get_le16(const uint8_t *p)
+{
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t get_le32(const uint8_t *p)
+{
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+         ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/****************************************************************************
+ * Public API on SoundMixer Class
+ ****************************************************************************/
+
+SoundMixer::SoundMixer()
+  : m_pool(NULL)
+  , m_pool_size(0)
+  , m_pool_used(0)
+  , m_rate(0)
+  , m_running(false)
+  , m_clip_num(0)
+{
+  memset(m_clip, 0, sizeof(m_clip));
+  memset(m_voice, 0, sizeof(m_voice));
+}
+
+/*--------------------------------------------------------------------------*/
+SoundMixer::~SoundMixer()
+{
+  end();
+}
+
+/*--------------------------------------------------------------------------*/
+int SoundMixer::begin(uint32_t pool_size, uint32_t sampling_rate, uint8_t bit_length, uint8_t channel_number)
+{
+  if (m_running)
+    {
+      return SOUNDMIXER_ECODE_STATE_ERROR;
+    }
+
+  /* mix() works on 16bit stereo only, and the rate is used to convert
+   * the clips.
+   */
+
+  if ((sampling_rate == 0) ||
+      (bit_length != AS_BITLENGTH_16) || (channel_number != AS_CHANNEL_STEREO))
+    {
+      print_err("Output format is not supported.\n");
+      return SOUNDMIXER_ECODE_FORMAT_ERROR;
+    }
+
+  m_pool = (uint8_t *)malloc(pool_size);
+  if (!m_pool)
+    {
+      print_err("Clip pool allocate error.\n");
+      return SOUNDMIXER_ECODE_ALLOC_ERROR;
+    }
+
+  m_pool_size = pool_size;
+  m_pool_used = 0;
+  m_rate      = sampling_rate;
+  m_clip_num  = 0;
+  memset(m_voice, 0, sizeof(m_voice));
+
+  pthread_mutex_init(&m_lock, NULL);
+  m_running = true;
+
+  return SOUNDMIXER_ECODE_OK;
+}
+
+/*--------------------------------------------------------------------------*/
+int SoundMixer::end(void)
+{
+  if (!m_running)
+    {
+      return SOUNDMIXER_ECODE_STATE_ERROR;
+    }
+
+  pthread_mutex_lock(&m_lock);
+  m_running = false;
+  memset(m_voice, 0, sizeof(m_voice));
+  pthread_mutex_unlock(&m_lock);
+
+  pthread_mutex_destroy(&m_lock);
+
+  free(m_pool);
+  m_pool      = NULL;
+  m_pool_size = 0;
+  m_clip_num  = 0;
+
+  return SOUNDMIXER_ECODE_OK;
+}
+
+/*--------------------------------------------------------------------------*/
+int SoundMixer::loadClip(const int16_t *pcm, uint32_t frames, uint8_t channels, uint32_t sampling_rate)
+{
+  if (!m_running || !pcm || !frames || !sampling_rate ||
+      (channels < 1) || (channels > 2) || (m_clip_num >= SOUNDMIXER_CLIP_NUM))
+    {
+      return -1;
+    }
+
+  uint32_t out_frames = (uint32_t)(((uint64_t)frames * m_rate) / sampling_rate);
+  uint32_t *out = alloc_clip(out_frames);
+
+  if (!out)
+    {
+      print_err("Clip pool is full.\n");
+      return -1;
+    }
+
+  /* Convert to stereo at the output rate by linear interpolation.
+   * Position is in q16, and fraction in q15 for interpolation.
+   */
+
+  uint32_t step = (uint32_t)(((uint64_t)sampling_rate << 16) / m_rate);
+  uint32_t pos  = 0;
+
+  for (uint32_t i = 0; i < out_frames; i++, pos += step)
+    {
+      uint32_t idx  = pos >> 16;
+      uint32_t nxt  = (idx + 1 < frames) ? idx + 1 : idx;
+      int32_t  frac = (pos & 0xffff) >> 1;
+      int32_t  smp[2];
+
+      for (int ch = 0; ch < channels; ch++)
+        {
+          int32_t a = pcm[idx * channels + ch];
+          int32_t b = pcm[nxt * channels + ch];
+          smp[ch] = a + (((b - a) * frac) >> 15);
+        }
+      if (channels == 1)
+        {
+          smp[1] = smp[0];
+        }
+
+      out[i] = (uint16_t)smp[0] | ((uint32_t)(uint16_t)smp[1] << 16);
+    }
+
+  m_clip[m_clip_num].data   = out;
+  m_clip[m_clip_num].frames = out_frames;
+
+  return m_clip_num++;
+}
+
+/*--------------------------------------------------------------------------*/
+int SoundMixer::loadClip(File& file)
+{
+  uint8_t hdr[16];
+  uint16_t channels = 0;
+  uint32_t rate = 0;
+  bool has_fmt = false;
+
+  if (!m_running)
+    {
+      return -1;
+    }
+
+  file.seek(0);
+  if ((file.read(hdr, 12) != 12) ||
+      (memcmp(hdr, "RIFF", 4) != 0) || (memcmp(&hdr[8], "WAVE", 4) != 0))
+    {
+      print_err("Not WAV file.\n");
+      return -1;
+    }
+
+  for (;;)
+    {
+      if (file.read(hdr, 8) != 8)
+        {
+          print_err("No data chunk.\n");
+          return -1;
+        }
+
+      uint32_t size = get_le32(&hdr[4]);
+      uint32_t next = file.position() + size + (size & 1);
+
+      if (memcmp(hdr, "fmt ", 4) == 0)
+        {
+          if ((size < 16) || (file.read(hdr, 16) != 16) ||
+              (get_le16(&hdr[14]) != 16))
+            {
+              print_err("Only 16bit PCM is supported.\n");
+              return -1;
+            }
+          channels = get_le16(&hdr[2]);
+          rate     = get_le32(&hdr[4]);
+          has_fmt  = true;
+        }
+      else if (memcmp(hdr, "data", 4) == 0)
+        {
+          if (!has_fmt || (channels < 1) || (channels > 2) || (rate == 0))
+            {
+              print_err("WAV format is not supported.\n");
+              return -1;
+            }
+
+          /* Read the source into the end of the free area, and convert it
+           * to the head of the free area. They do not overlap while both
+           * fit in the pool.
+           */
+
+          uint32_t frames = size / (channels * 2);
+          uint32_t src_size = frames * channels * 2;
+          uint32_t out_size = (uint32_t)(((uint64_t)frames * m_rate) / rate) * 4;
+
+          if (m_pool_used + out_size + src_size + 4 > m_pool_size)
+            {
+              print_err("Clip pool is full.\n");
+              return -1;
+            }
+
+          int16_t *src = (int16_t *)(m_pool + ((m_pool_size - src_size) & ~3));
+
+          if (file.read(src, src_size) != (int)src_size)
+            {
+              print_err("Fail to read WAV file.\n");
+              return -1;
+            }
+
+          return loadClip(src, frames, channels, rate);
+        }
+
+      if (!file.seek(next))
+        {
+          return -1;
+        }
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+void SoundMixer::clearClips(void)
+{
+  if (!m_running)
+    {
+      return;
+    }
+
+  pthread_mutex_lock(&m_lock);
+  memset(m_voice, 0, sizeof(m_voice));
+  m_clip_num  = 0;
+  m_pool_used = 0;
+  pthread_mutex_unlock(&m_lock);
+}
+
+/*--------------------------------------------------------------------------*/
+int SoundMixer::play(int clip, int16_t gain, bool loop)
+{
+  if (!m_running || (clip < 0) || (clip >= m_clip_num) || (gain < 0))
+    {
+      return -1;
+    }
+
+  int ret = -1;
+
+  pthread_mutex_lock(&m_lock);
+  for (int i = 0; i < SOUNDMIXER_VOICE_NUM; i++)
+    {
+      Voice *v = &m_voice[i];
+
+      if (!v->clip)
+        {
+          v->pos      = 0;
+          v->loop     = loop;
+          v->stopping = false;
+          v->gain     = (int32_t)gain << 8;
+          v->target   = v->gain;
+          v->step     = 0;
+          v->ramp     = 0;
+          v->clip     = &m_clip[clip];
+          ret = i;
+          break;
+        }
+    }
+  pthread_mutex_unlock(&m_lock);
+
+  return ret;
+}
+
+/*--------------------------------------------------------------------------*/
+int SoundMixer::setGain(int voice, int16_t gain, uint32_t ramp)
+{
+  if (!m_running || (voice < 0) || (voice >= SOUNDMIXER_VOICE_NUM) || (gain < 0))
+    {
+      return SOUNDMIXER_ECODE_STATE_ERROR;
+    }
+
+  Voice *v = &m_voice[voice];
+
+  pthread_mutex_lock(&m_lock);
+  v->target = (int32_t)gain << 8;
+  if (ramp == 0)
+    {
+      v->gain = v->target;
+      v->ramp = 0;
+    }
+  else
+    {
+      v->step = (v->target - v->gain) / (int32_t)ramp;
+      v->ramp = ramp;
+    }
+  pthread_mutex_unlock(&m_lock);
+
+  return SOUNDMIXER_ECODE_OK;
+}
+
+/*--------------------------------------------------------------------------*/
+int SoundMixer::stop(int voice, uint32_t ramp)
+{
+  if (!m_running || (voice < 0) || (voice >= SOUNDMIXER_VOICE_NUM))
+    {
+      return SOUNDMIXER_ECODE_STATE_ERROR;
+    }
+
+  Voice *v = &m_voice[voice];
+
+  pthread_mutex_lock(&m_lock);
+  if (ramp == 0)
+    {
+      v->clip = NULL;
+    }
+  else if (v->clip)
+    {
+      v->stopping = true;
+      v->target   = 0;
+      v->step     = -v->gain / (int32_t)ramp;
+      v->ramp     = ramp;
+    }
+  pthread_mutex_unlock(&m_lock);
+
+  return SOUNDMIXER_ECODE_OK;
+}
+
+/*--------------------------------------------------------------------------*/
+bool SoundMixer::isPlaying(int voice)
+{
+  if (!m_running || (voice < 0) || (voice >= SOUNDMIXER_VOICE_NUM))
+    {
+      return false;
+    }
+
+  return m_voice[voice].clip != NULL;
+}
+
+/*--------------------------------------------------------------------------*/
+int SoundMixer::mix(AsPcmDataParam& pcm)
+{
+  if (!m_running)
+    {
+      return SOUNDMIXER_ECODE_STATE_ERROR;
+    }
+
+  if (pcm.bit_length != AS_BITLENGTH_16)
+    {
+      return SOUNDMIXER_ECODE_FORMAT_ERROR;
+    }
+
+  if (!pcm.is_valid || (pcm.size == 0))
+    {
+      return SOUNDMIXER_ECODE_OK;
+    }
+
+  uint32_t *out = (uint32_t *)pcm.mh.getPa();
+  uint32_t frames = pcm.size / 4;
+
+  pthread_mutex_lock(&m_lock);
+  for (int i = 0; i < SOUNDMIXER_VOICE_NUM; i++)
+    {
+      if (m_voice[i].clip)
+        {
+          mix_voice(&m_voice[i], out, frames);
+        }
+    }
+  pthread_mutex_unlock(&m_lock);
+
+  return SOUNDMIXER_ECODE_OK;
+}
+
+/*--------------------------------------------------------------------------*/
+err_t SoundMixer::sendData(AsOutputMixerHandle handle,
+                           PcmProcDoneCallback pcmdone_cb,
+                           AsPcmDataParam pcm)
+{
+  mix(pcm);
+
+  return OutputMixer::getInstance()->sendData(handle, pcmdone_cb, pcm);
+}
+
+/****************************************************************************
+ * Private API on SoundMixer Class
+ ****************************************************************************/
+
+uint32_t *SoundMixer::alloc_clip(uint32_t frames)
+{
+  uint32_t size = frames * 4;
+
+  if (m_pool_used + size > m_pool_size)
+    {
+      return NULL;
+    }
+
+  uint32_t *p = (uint32_t *)(m_pool + m_pool_used);
+  m_pool_used += size;
+
+  return p;
+}
+
+/*--------------------------------------------------------------------------*/
+void SoundMixer::mix_voice(Voice *v, uint32_t *out, uint32_t frames)
+{
+  const Clip *c = v->clip;
+  uint32_t i = 0;
+
+  /* A frame is a pair of q15 samples in a word, so that both channels are
+   * scaled by SMULW and added by QADD16 with saturation at once.
+   */
+
+  while (i < frames)
+    {
+      if (v->pos >= c->frames)
+        {
+          if (!v->loop)
+            {
+              v->clip = NULL;
+              return;
+            }
+          v->pos = 0;
+        }
+
+      uint32_t n = frames - i;
+      if (n > c->frames - v->pos)
+        {
+          n = c->frames - v->pos;
+        }
+      if (v->ramp && (n > v->ramp))
+        {
+          n = v->ramp;
+        }
+
+      const uint32_t *src = &c->data[v->pos];
+      uint32_t *dst = &out[i];
+
+      if (v->ramp)
+        {
+          int32_t gain = v->gain;
+
+          for (uint32_t k = 0; k < n; k++)
+            {
+              int32_t g = (gain >> 8) << 1;
+              int32_t l = __SMULWB(g, src[k]);
+              int32_t r = __SMULWT(g, src[k]);
+              dst[k] = __QADD16(dst[k], __PKHBT(l, r, 16));
+              gain += v->step;
+            }
+
+          v->gain  = gain;
+          v->ramp -= n;
+          if (v->ramp == 0)
+            {
+              v->gain = v->target;
+              if (v->stopping)
+                {
+                  v->clip = NULL;
+                  return;
+                }
+            }
+        }
+      else if (v->gain == ((int32_t)SOUNDMIXER_GAIN_MAX << 8))
+        {
+          for (uint32_t k = 0; k < n; k++)
+            {
+              dst[k] = __QADD16(dst[k], src[k]);
+            }
+        }
+      else
+        {
+          int32_t g = (v->gain >> 8) << 1;
+
+          for (uint32_t k = 0; k < n; k++)
+            {
+              int32_t l = __SMULWB(g, src[k]);
+              int32_t r = __SMULWT(g, src[k]);
+              dst[k] = __QADD16(dst[k], __PKHBT(l, r, 16));
+            }
+        }
+
+      i      += n;
+      v->pos += n;
+    }
+}
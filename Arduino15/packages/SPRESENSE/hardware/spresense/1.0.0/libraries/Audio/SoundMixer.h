@@ -0,0 +1,249 @@
+/*
+ *  SoundMixer.h - Software mixer of PCM clips for OutputMixer
+ *  Copyright 2018 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef SoundMixer_h
+#define SoundMixer_h
+
+#ifdef SUBCORE
+#error "Audio library is NOT supported by SubCore."
+#endif
+
+/**
+ * @file SoundMixer.h
+ * @author Sony Semiconductor Solutions Corporation
+ * @brief Software mixer of PCM clips for OutputMixer.
+ * @details Short PCM clips (beeps, prompts) are loaded into a memory pool
+ *          in advance, and mixed into the PCM frames of a player just before
+ *          OutputMixer::sendData(). Any number of clips up to
+ *          SOUNDMIXER_VOICE_NUM can be played at the same time, on top of
+ *          the two players of OutputMixer.
+ */
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include "OutputMixer.h"
+
+class File;
+
+/*--------------------------------------------------------------------------*/
+
+/**
+ * SoundMixer Error Code Definitions.
+ */
+
+#define SOUNDMIXER_ECODE_OK           0
+#define SOUNDMIXER_ECODE_STATE_ERROR  1
+#define SOUNDMIXER_ECODE_ALLOC_ERROR  2
+#define SOUNDMIXER_ECODE_FORMAT_ERROR 3
+
+/**
+ * SoundMixer settings.
+ */
+
+#define SOUNDMIXER_VOICE_NUM   8
+#define SOUNDMIXER_CLIP_NUM    16
+#define SOUNDMIXER_GAIN_MAX    0x7fff  /* q15 1.0 */
+
+/*--------------------------------------------------------------------------*/
+
+/**
+ * @class SoundMixer
+ * @brief Software mixer of PCM clips.
+ */
+
+class SoundMixer
+{
+public:
+
+  SoundMixer();
+  ~SoundMixer();
+
+  /**
+   * @brief Start the mixer.
+   *
+   * @details This function allocates the clip pool. Clips are converted to
+   *          16bit stereo at the sampling rate of the output on loading.
+   *          The output must be 16bit stereo, other formats return
+   *          SOUNDMIXER_ECODE_FORMAT_ERROR.
+   *
+   */
+
+  int begin(
+      uint32_t pool_size,                         /**< Size of clip pool.(byte) */
+      uint32_t sampling_rate = 48000,             /**< Sampling rate of the output.(Hz) */
+      uint8_t  bit_length = AS_BITLENGTH_16,      /**< Bit length of the output. */
+      uint8_t  channel_number = AS_CHANNEL_STEREO /**< Channel number of the output. */
+  );
+
+  /**
+   * @brief Stop the mixer and free the clip pool.
+   */
+
+  int end(void);
+
+  /**
+   * @brief Load a clip from memory.
+   *
+   * @details 16bit PCM in mono or interleaved stereo is accepted. The data
+   *          is converted and copied into the pool, so the source can be
+   *          freed after this function.
+   *
+   * @return Clip number, or -1 on error.
+   */
+
+  int loadClip(
+      const int16_t *pcm,     /**< PCM data */
+      uint32_t frames,        /**< Number of frames */
+      uint8_t channels,       /**< 1 or 2 */
+      uint32_t sampling_rate  /**< Sampling rate of the data.(Hz) */
+  );
+
+  /**
+   * @brief Load a clip from a WAV file.
+   *
+   * @details 16bit PCM WAV file is accepted.
+   *
+   * @return Clip number, or -1 on error.
+   */
+
+  int loadClip(
+      File& file /**< WAV file */
+  );
+
+  /**
+   * @brief Remove all clips.
+   *
+   * @details All voices are stopped immediately.
+   *
+   */
+
+  void clearClips(void);
+
+  /**
+   * @brief Start playing a clip.
+   *
+   * @return Voice number, or -1 if no voice is free.
+   */
+
+  int play(
+      int clip,                            /**< Clip number */
+      int16_t gain = SOUNDMIXER_GAIN_MAX,  /**< Gain in q15. 0 to SOUNDMIXER_GAIN_MAX */
+      bool loop = false                    /**< Repeat the clip until stop() */
+  );
+
+  /**
+   * @brief Change gain of a voice.
+   *
+   * @details Gain changes linearly in ramp frames to avoid clicks.
+   *
+   */
+
+  int setGain(
+      int voice,          /**< Voice number */
+      int16_t gain,       /**< Gain in q15. 0 to SOUNDMIXER_GAIN_MAX */
+      uint32_t ramp = 0   /**< Ramp length.(frame) */
+  );
+
+  /**
+   * @brief Stop a voice.
+   *
+   * @details The voice fades out in ramp frames, and then is freed.
+   *
+   */
+
+  int stop(
+      int voice,          /**< Voice number */
+      uint32_t ramp = 0   /**< Ramp length.(frame) */
+  );
+
+  /**
+   * @brief Check if a voice is playing.
+   */
+
+  bool isPlaying(
+      int voice /**< Voice number */
+  );
+
+  /**
+   * @brief Mix playing voices into PCM frame.
+   *
+   * @details Voices are added to the frame in place with saturation.
+   *          The frame must be 16bit stereo.
+   *
+   */
+
+  int mix(
+      AsPcmDataParam& pcm /**< PCM frame from player or FrontEnd */
+  );
+
+  /**
+   * @brief Mix playing voices and send to OutputMixer.
+   *
+   * @details This function can replace OutputMixer::sendData() in decode
+   *          callback of the player.
+   *
+   */
+
+  err_t sendData(
+      AsOutputMixerHandle handle,     /**< Select output mixer handle. OutputMixer0 or OutputMixer1 */
+      PcmProcDoneCallback pcmdone_cb, /**< Callback function which will be called when send complete */
+      AsPcmDataParam pcm              /**< PCM data parameters */
+  );
+
+private:
+
+  SoundMixer(const SoundMixer&);
+  SoundMixer& operator=(const SoundMixer&);
+
+  struct Clip
+  {
+    uint32_t *data;    /* Stereo frames, L in lower half */
+    uint32_t frames;
+  };
+
+  struct Voice
+  {
+    const Clip *clip;  /* NULL if free */
+    uint32_t pos;
+    bool     loop;
+    bool     stopping; /* Freed when gain reaches 0 */
+    int32_t  gain;     /* q23 */
+    int32_t  target;   /* q23 */
+    int32_t  step;     /* q23 per frame */
+    uint32_t ramp;     /* Frames left in ramp */
+  };
+
+  uint32_t *alloc_clip(uint32_t frames);
+  void mix_voice(Voice *v, uint32_t *out, uint32_t frames);
+
+  uint8_t        *m_pool;
+  uint32_t        m_pool_size;
+  uint32_t        m_pool_used;
+  uint32_t        m_rate;
+  bool            m_running;
+
+  Clip            m_clip[SOUNDMIXER_CLIP_NUM];
+  int             m_clip_num;
+  Voice           m_voice[SOUNDMIXER_VOICE_NUM];
+
+  pthread_mutex_t m_lock;   /* Between control API and mix() */
+};
+
+#endif // SoundMixer_h
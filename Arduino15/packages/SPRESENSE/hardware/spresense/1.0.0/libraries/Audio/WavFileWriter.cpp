@@ -0,0 +1,326 @@
+/*
+ *  WavFileWriter.cpp - Streaming WAV/RF64 file writer for audio recording
+ *  Copyright 2018 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+//***************************************************************************
+// Included Files
+//***************************************************************************
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <File.h>
+
+#include "WavFileWriter.h"
+
+#define RIFF_SIZE_MAX  0xffffffffULL
+
+static inline void put_le16(uint8_t *p, uint16_t v)
+{
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void put_le32(uint8_t *p, uint32_t v)
+{
+  put_le16(p, (uint16_t)v);
+  put_le16(p + 2, (uint16_t)(v >> 16));
+}
+
+static inline void put_le64(uint8_t *p, uint64_t v)
+{
+  put_le32(p, (uint32_t)v);
+  put_le32(p + 4, (uint32_t)(v >> 32));
+}
+
+/****************************************************************************
+ * Public API on WavFileWriter Class
+ ****************************************************************************/
+
+WavFileWriter::WavFileWriter()
+  : m_file(NULL)
+  , m_buf(NULL)
+  , m_buf_size(0)
+  , m_used(0)
+  , m_start(0)
+  , m_written(0)
+  , m_updated(0)
+  , m_interval(0)
+  , m_rate(0)
+  , m_block(0)
+  , m_bit(0)
+  , m_channel(0)
+  , m_rf64(false)
+  , m_running(false)
+{
+}
+
+/*--------------------------------------------------------------------------*/
+WavFileWriter::~WavFileWriter()
+{
+  end();
+}
+
+/*--------------------------------------------------------------------------*/
+int WavFileWriter::begin(File& file,
+                         uint32_t sampling_rate,
+                         uint8_t bit_length,
+                         uint8_t channel_number,
+                         uint32_t update_interval,
+                         uint32_t buf_size)
+{
+  if (m_running)
+    {
+      return WAVFILEWRITER_ECODE_STATE_ERROR;
+    }
+
+  if ((buf_size == 0) || (channel_number == 0) || (bit_length == 0))
+    {
+      return WAVFILEWRITER_ECODE_STATE_ERROR;
+    }
+
+  m_buf = (uint8_t *)malloc(buf_size);
+  if (!m_buf)
+    {
+      print_err("Write buffer allocate error.\n");
+      return WAVFILEWRITER_ECODE_ALLOC_ERROR;
+    }
+
+  m_file     = &file;
+  m_buf_size = buf_size;
+  m_used     = 0;
+  m_start    = file.position();
+  m_written  = 0;
+  m_updated  = 0;
+  m_interval = update_interval;
+  m_rate     = sampling_rate;
+  m_bit      = bit_length;
+  m_channel  = channel_number;
+  m_block    = channel_number * (bit_length / 8);
+  m_rf64     = false;
+
+  uint8_t hdr[WAVFILEWRITER_HEADER_SIZE];
+  make_header(hdr);
+
+  if (file.write(hdr, sizeof(hdr)) != sizeof(hdr))
+    {
+      print_err("WAV header write error.\n");
+      free(m_buf);
+      m_buf = NULL;
+      return WAVFILEWRITER_ECODE_FILEACCESS_ERROR;
+    }
+
+  m_running = true;
+
+  return WAVFILEWRITER_ECODE_OK;
+}
+
+/*--------------------------------------------------------------------------*/
+int WavFileWriter::end(void)
+{
+  if (!m_running)
+    {
+      return WAVFILEWRITER_ECODE_STATE_ERROR;
+    }
+
+  int ret = flush_buffer();
+
+  /* Chunk must be padded to even size. The pad is not in the data size. */
+
+  if ((ret == WAVFILEWRITER_ECODE_OK) && (m_written & 1))
+    {
+      uint8_t pad = 0;
+      m_file->write(&pad, 1);
+    }
+
+  if (ret == WAVFILEWRITER_ECODE_OK)
+    {
+      ret = write_header();
+    }
+
+  m_file->flush();
+
+  free(m_buf);
+  m_buf     = NULL;
+  m_running = false;
+
+  return ret;
+}
+
+/*--------------------------------------------------------------------------*/
+int WavFileWriter::write(const uint8_t* data, uint32_t size)
+{
+  if (!m_running)
+    {
+      return WAVFILEWRITER_ECODE_STATE_ERROR;
+    }
+
+  while (size > 0)
+    {
+      uint32_t n = m_buf_size - m_used;
+      if (n > size)
+        {
+          n = size;
+        }
+
+      memcpy(&m_buf[m_used], data, n);
+      m_used += n;
+      data   += n;
+      size   -= n;
+
+      if (m_used == m_buf_size)
+        {
+          int ret = flush_buffer();
+          if (ret != WAVFILEWRITER_ECODE_OK)
+            {
+              return ret;
+            }
+        }
+    }
+
+  if (m_interval && (m_written - m_updated >= m_interval))
+    {
+      return update();
+    }
+
+  return WAVFILEWRITER_ECODE_OK;
+}
+
+/*--------------------------------------------------------------------------*/
+int WavFileWriter::update(void)
+{
+  if (!m_running)
+    {
+      return WAVFILEWRITER_ECODE_STATE_ERROR;
+    }
+
+  /* File position is 32bit. Beyond that, the header cannot be rewritten
+   * because the end of file cannot be sought back, and it is written
+   * only at end().
+   */
+
+  uint64_t end_pos = m_start + WAVFILEWRITER_HEADER_SIZE + m_written;
+
+  if (end_pos > RIFF_SIZE_MAX)
+    {
+      return WAVFILEWRITER_ECODE_OK;
+    }
+
+  int ret = write_header();
+  if (ret != WAVFILEWRITER_ECODE_OK)
+    {
+      return ret;
+    }
+
+  if (!m_file->seek((uint32_t)end_pos))
+    {
+      return WAVFILEWRITER_ECODE_FILEACCESS_ERROR;
+    }
+
+  /* Commit the file size in the directory entry together. */
+
+  m_file->flush();
+
+  m_updated = m_written;
+
+  return WAVFILEWRITER_ECODE_OK;
+}
+
+/****************************************************************************
+ * Private API on WavFileWriter Class
+ ****************************************************************************/
+
+int WavFileWriter::flush_buffer(void)
+{
+  if (m_used == 0)
+    {
+      return WAVFILEWRITER_ECODE_OK;
+    }
+
+  if (m_file->write(m_buf, m_used) != m_used)
+    {
+      print_err("WAV data write error.\n");
+      return WAVFILEWRITER_ECODE_FILEACCESS_ERROR;
+    }
+
+  m_written += m_used;
+  m_used = 0;
+
+  return WAVFILEWRITER_ECODE_OK;
+}
+
+/*--------------------------------------------------------------------------*/
+int WavFileWriter::write_header(void)
+{
+  uint8_t hdr[WAVFILEWRITER_HEADER_SIZE];
+
+  make_header(hdr);
+
+  if (!m_file->seek(m_start) ||
+      (m_file->write(hdr, sizeof(hdr)) != sizeof(hdr)))
+    {
+      print_err("WAV header write error.\n");
+      return WAVFILEWRITER_ECODE_FILEACCESS_ERROR;
+    }
+
+  return WAVFILEWRITER_ECODE_OK;
+}
+
+/*--------------------------------------------------------------------------*/
+void WavFileWriter::make_header(uint8_t *hdr)
+{
+  uint64_t riff_size = m_written + (m_written & 1) + WAVFILEWRITER_HEADER_SIZE - 8;
+
+  m_rf64 = (riff_size > RIFF_SIZE_MAX);
+
+  /* RIFF/RF64 */
+
+  memcpy(&hdr[0], (m_rf64) ? "RF64" : "RIFF", 4);
+  put_le32(&hdr[4], (m_rf64) ? 0xffffffff : (uint32_t)riff_size);
+  memcpy(&hdr[8], "WAVE", 4);
+
+  /* JUNK chunk reserves the place of ds64 chunk. */
+
+  memcpy(&hdr[12], (m_rf64) ? "ds64" : "JUNK", 4);
+  put_le32(&hdr[16], 28);
+  memset(&hdr[20], 0, 28);
+  if (m_rf64)
+    {
+      put_le64(&hdr[20], riff_size);
+      put_le64(&hdr[28], m_written);
+      put_le64(&hdr[36], m_written / m_block);
+    }
+
+  /* fmt */
+
+  memcpy(&hdr[48], "fmt ", 4);
+  put_le32(&hdr[52], 16);
+  put_le16(&hdr[56], 1); /* PCM */
+  put_le16(&hdr[58], m_channel);
+  put_le32(&hdr[60], m_rate);
+  put_le32(&hdr[64], m_rate * m_block);
+  put_le16(&hdr[68], m_block);
+  put_le16(&hdr[70], m_bit);
+
+  /* data */
+
+  memcpy(&hdr[72], "data", 4);
+  put_le32(&hdr[76], (m_rf64) ? 0xffffffff : (uint32_t)m_written);
+}
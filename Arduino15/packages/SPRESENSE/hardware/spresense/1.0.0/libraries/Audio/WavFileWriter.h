@@ -0,0 +1,219 @@
+/*
+ *  WavFileWriter.h - Streaming WAV/RF64 file writer for audio recording
+ *  Copyright 2018 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef WavFileWriter_h
+#define WavFileWriter_h
+
+#ifdef SUBCORE
+#error "Audio library is NOT supported by SubCore."
+#endif
+
+/**
+ * @file WavFileWriter.h
+ * @author Sony Semiconductor Solutions Corporation
+ * @brief Streaming WAV/RF64 file writer for audio recording.
+ * @details The WAV header is rewritten with the current sizes at every
+ *          update interval during recording, so the file can be played
+ *          even if recording is interrupted by power loss. The header has
+ *          a reserved chunk which is turned into ds64 chunk of RF64 when
+ *          the data exceeds the 32bit size of WAV.
+ */
+
+#include <stdint.h>
+
+class File;
+
+/**
+ * WavFileWriter log output definition
+ */
+
+#define print_err printf
+
+/*--------------------------------------------------------------------------*/
+
+/**
+ * WavFileWriter Error Code Definitions.
+ */
+
+#define WAVFILEWRITER_ECODE_OK               0
+#define WAVFILEWRITER_ECODE_STATE_ERROR      1
+#define WAVFILEWRITER_ECODE_ALLOC_ERROR      2
+#define WAVFILEWRITER_ECODE_FILEACCESS_ERROR 3
+#define WAVFILEWRITER_ECODE_RECORDER_ERROR   4
+
+/**
+ * WavFileWriter default settings.
+ */
+
+#define WAVFILEWRITER_HEADER_SIZE      80
+#define WAVFILEWRITER_BUF_SIZE         (8 * 1024)
+#define WAVFILEWRITER_UPDATE_INTERVAL  (256 * 1024)
+
+/*--------------------------------------------------------------------------*/
+
+/**
+ * @class WavFileWriter
+ * @brief Streaming WAV/RF64 file writer.
+ */
+
+class WavFileWriter
+{
+public:
+
+  WavFileWriter();
+  ~WavFileWriter();
+
+  /**
+   * @brief Start writing.
+   *
+   * @details This function writes the header at the beginning of the file,
+   *          and allocates the write buffer.
+   *          The file must not be accessed by others until end() is called.
+   *
+   */
+
+  int begin(
+      File& file,              /**< Output file. */
+      uint32_t sampling_rate,  /**< Sampling rate.(Hz) */
+      uint8_t bit_length,      /**< AS_BITLENGTH_16 or AS_BITLENGTH_24 */
+      uint8_t channel_number,  /**< Number of channels */
+      uint32_t update_interval = WAVFILEWRITER_UPDATE_INTERVAL, /**< Header update interval.(byte of data) 0 for no update. */
+      uint32_t buf_size = WAVFILEWRITER_BUF_SIZE                /**< Size of write buffer.(byte) */
+  );
+
+  /**
+   * @brief Finish writing.
+   *
+   * @details This function writes the remaining data and the final header,
+   *          and frees the write buffer. The file is not closed.
+   *
+   */
+
+  int end(void);
+
+  /**
+   * @brief Write data.
+   *
+   * @details Data is buffered, and written to the file by buf_size.
+   *
+   */
+
+  int write(
+      const uint8_t* data, /**< Data to write. */
+      uint32_t size        /**< Size of data.(byte) */
+  );
+
+  /**
+   * @brief Move recorded data from a recorder.
+   *
+   * @details This function moves recorded data from the FIFO of recorder
+   *          (AudioClass or MediaRecorder) by peekFrames() and
+   *          releaseFrames(). Call this function periodically during
+   *          recording instead of readFrames().
+   *
+   */
+
+  template <typename T> int fetch(T& recorder);
+
+  /**
+   * @brief Update the header now.
+   *
+   * @details The header is rewritten with the size of data already written
+   *          to the file, and the file is synchronized. Buffered data is not
+   *          included.
+   *
+   */
+
+  int update(void);
+
+  /**
+   * @brief Get size of data written.(byte)
+   */
+
+  uint64_t getDataSize(void)
+    {
+      return m_written + m_used;
+    }
+
+  /**
+   * @brief Check if the file is RF64.
+   */
+
+  bool isRf64(void)
+    {
+      return m_rf64;
+    }
+
+private:
+
+  WavFileWriter(const WavFileWriter&);
+  WavFileWriter& operator=(const WavFileWriter&);
+
+  int flush_buffer(void);
+  int write_header(void);
+  void make_header(uint8_t *hdr);
+
+  File*    m_file;
+  uint8_t* m_buf;
+  uint32_t m_buf_size;
+  uint32_t m_used;
+  uint32_t m_start;          /* File position of the header */
+  uint64_t m_written;        /* Data size in the file */
+  uint64_t m_updated;        /* Data size at the last update */
+  uint32_t m_interval;
+  uint32_t m_rate;
+  uint16_t m_block;
+  uint8_t  m_bit;
+  uint8_t  m_channel;
+  bool     m_rf64;
+  bool     m_running;
+};
+
+/*--------------------------------------------------------------------------*/
+
+template <typename T> int WavFileWriter::fetch(T& recorder)
+{
+  const uint8_t *area[2];
+  uint32_t size[2];
+  int ret = WAVFILEWRITER_ECODE_OK;
+
+  if (!m_running)
+    {
+      return WAVFILEWRITER_ECODE_STATE_ERROR;
+    }
+
+  if (recorder.peekFrames(&area[0], &size[0], &area[1], &size[1]) != 0)
+    {
+      return WAVFILEWRITER_ECODE_RECORDER_ERROR;
+    }
+
+  for (int i = 0; i < 2 && size[i] > 0; i++)
+    {
+      ret = write(area[i], size[i]);
+      if (ret != WAVFILEWRITER_ECODE_OK)
+        {
+          break;
+        }
+      recorder.releaseFrames(size[i]);
+    }
+
+  return ret;
+}
+
+#endif // WavFileWriter_h
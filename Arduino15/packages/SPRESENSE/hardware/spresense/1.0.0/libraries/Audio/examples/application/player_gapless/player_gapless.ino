@@ -0,0 +1,233 @@
+/*
+ *  player_gapless.ino - Gapless playback of several files example application
+ *  Copyright 2018 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,  MA 02110-1301  USA
+ */
+
+#include <SDHCI.h>
+#include <MediaPlayer.h>
+#include <OutputMixer.h>
+#include <GaplessPlayer.h>
+#include <MemoryUtil.h>
+
+SDClass theSD;
+
+MediaPlayer *thePlayer;
+OutputMixer *theMixer;
+GaplessPlayer thePlaylist;
+
+bool ErrEnd = false;
+volatile bool Stopped = false;
+
+/**
+ * @brief Audio attention callback
+ */
+
+static void attention_cb(const ErrorAttentionParam *atprm)
+{
+  puts("Attention!");
+
+  if (atprm->error_code >= AS_ATTENTION_CODE_WARNING)
+    {
+      ErrEnd = true;
+   }
+}
+
+/**
+ * @brief Mixer done callback procedure
+ */
+static void outputmixer_done_callback(MsgQueId requester_dtq,
+                                      MsgType reply_of,
+                                      AsOutputMixDoneParam *done_param)
+{
+  return;
+}
+
+/**
+ * @brief Mixer data send callback procedure
+ */
+static void outmixer_send_callback(int32_t identifier, bool is_end)
+{
+  AsRequestNextParam next;
+
+  next.type = (!is_end) ? AsNextNormalRequest : AsNextStopResRequest;
+
+  AS_RequestNextPlayerProcess(AS_PLAYER_ID_0, &next);
+
+  return;
+}
+
+/**
+ * @brief Player done callback procedure
+ *
+ * Stop event is used to restart the player on format change.
+ */
+static bool mediaplayer_done_callback(AsPlayerEvent event, uint32_t result, uint32_t sub_result)
+{
+  if (event == AsPlayerEventStop)
+    {
+      Stopped = true;
+    }
+
+  return true;
+}
+
+/**
+ * @brief Player decode callback procedure
+ */
+void mediaplayer_decode_callback(AsPcmDataParam pcm_param)
+{
+  theMixer->sendData(OutputMixer0,
+                     outmixer_send_callback,
+                     pcm_param);
+}
+
+/**
+ * @brief Track change callback procedure
+ *
+ * Called when the playlist starts to supply a new track. The track will be
+ * heard after the data already in FIFO.
+ */
+static void track_callback(const char *path)
+{
+  printf("Next: %s\n", path);
+}
+
+/**
+ * @brief Initialize and start the player with the format of current track
+ */
+static void start_player()
+{
+  const GaplessPlayer::Format& fmt = thePlaylist.format();
+
+  thePlayer->init(MediaPlayer::Player0, fmt.codec_type, "/mnt/sd0/BIN",
+                  fmt.sampling_rate, fmt.bit_length, fmt.channel_number);
+
+  thePlaylist.resume();
+  thePlaylist.feed();
+
+  thePlayer->start(MediaPlayer::Player0, mediaplayer_decode_callback);
+}
+
+/**
+ * @brief Setup Player, Mixer and playlist
+ *
+ * Tracks in the same format are played without gap.
+ */
+void setup()
+{
+  /* Initialize memory pools and message libs */
+
+  initMemoryPools();
+  createStaticPools(MEM_LAYOUT_PLAYER);
+
+  thePlayer = MediaPlayer::getInstance();
+  theMixer  = OutputMixer::getInstance();
+
+  theMixer->setRenderingClkMode(OUTPUTMIXER_RNDCLK_NORMAL);
+
+  thePlayer->begin();
+  theMixer->begin();
+
+  thePlayer->create(MediaPlayer::Player0, attention_cb);
+  theMixer->create(attention_cb);
+
+  thePlayer->activate(MediaPlayer::Player0, mediaplayer_done_callback);
+  theMixer->activate(OutputMixer0, HPOutputDevice, outputmixer_done_callback);
+
+  usleep(100 * 1000);
+
+  /* Initialize SD */
+  while (!theSD.begin())
+    {
+      /* wait until SD card is mounted. */
+      Serial.println("Insert SD card.");
+    }
+
+  /* Queue tracks. Files are opened and prefetched during playback. */
+
+  thePlaylist.begin(MediaPlayer::Player0, GAPLESSPLAYER_PREFETCH_SIZE, track_callback);
+  thePlaylist.add("AUDIO/Track1.mp3");
+  thePlaylist.add("AUDIO/Track2.mp3");
+  thePlaylist.add("AUDIO/Track3.mp3");
+
+  if (thePlaylist.prepare() != GAPLESSPLAYER_ECODE_OK)
+    {
+      printf("No track to play\n");
+      exit(1);
+    }
+
+  theMixer->setVolume(-160, 0, 0);
+
+  start_player();
+}
+
+/**
+ * @brief Supply audio data until all tracks end
+ */
+void loop()
+{
+  int err = thePlaylist.feed();
+
+  switch (err)
+    {
+      case GAPLESSPLAYER_ECODE_OK:
+        break;
+
+      case GAPLESSPLAYER_ECODE_FORMAT_CHANGE:
+        /* Play out the previous track, and then restart the player
+         * with the new format.
+         */
+
+        if (!Stopped)
+          {
+            thePlayer->stop(MediaPlayer::Player0, AS_STOPPLAYER_ESEND);
+            while (!Stopped)
+              {
+                usleep(10 * 1000);
+              }
+          }
+        Stopped = false;
+        start_player();
+        break;
+
+      case GAPLESSPLAYER_ECODE_FILEEND:
+        printf("All tracks are supplied\n");
+        goto stop_player;
+
+      default:
+        printf("Playlist error code: %d\n", err);
+        goto stop_player;
+    }
+
+  if (ErrEnd)
+    {
+      printf("Error End\n");
+      goto stop_player;
+    }
+
+  usleep(40000);
+
+  return;
+
+stop_player:
+  thePlayer->stop(MediaPlayer::Player0, AS_STOPPLAYER_ESEND);
+  thePlaylist.end();
+  usleep(1000 * 1000);
+  thePlayer->deactivate(MediaPlayer::Player0);
+  thePlayer->end();
+  exit(1);
+}
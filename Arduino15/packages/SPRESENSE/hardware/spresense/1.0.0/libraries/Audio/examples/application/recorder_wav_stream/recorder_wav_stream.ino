@@ -0,0 +1,166 @@
+/*
+ *  recorder_wav_stream.ino - Long recording to WAV file with header update
+ *  Copyright 2018 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,  MA 02110-1301  USA
+ */
+
+#include <SDHCI.h>
+#include <Audio.h>
+#include <WavFileWriter.h>
+
+#include <arch/board/board.h>
+
+#define RECORD_FILE_NAME "Stream.wav"
+
+SDClass theSD;
+AudioClass *theAudio;
+WavFileWriter theWriter;
+
+File myFile;
+
+bool ErrEnd = false;
+
+/**
+ * @brief Audio attention callback
+ *
+ * When audio internal error occurs, this function will be called back.
+ */
+
+static void audio_attention_cb(const ErrorAttentionParam *atprm)
+{
+  puts("Attention!");
+
+  if (atprm->error_code >= AS_ATTENTION_CODE_WARNING)
+    {
+      ErrEnd = true;
+   }
+}
+
+static const uint32_t recoding_sampling_rate = 48000;
+static const uint8_t  recoding_cannel_number = 4;
+static const uint8_t  recoding_bit_length = 16;
+
+/* Bytes per second */
+
+static const uint32_t recoding_byte_per_second = recoding_sampling_rate *
+                                                 recoding_cannel_number *
+                                                 recoding_bit_length / 8;
+
+/**
+ * @brief Setup recording of wav stream to file
+ *
+ * The header of the file is updated every second, so the recorded data is
+ * kept even if the power is turned off during recording.
+ */
+
+void setup()
+{
+  /* Initialize SD */
+  while (!theSD.begin())
+    {
+      /* wait until SD card is mounted. */
+      Serial.println("Insert SD card.");
+    }
+
+  theAudio = AudioClass::getInstance();
+
+  theAudio->begin(audio_attention_cb);
+
+  puts("initialization Audio Library");
+
+  /* Select input device as microphone */
+  theAudio->setRecorderMode(AS_SETRECDR_STS_INPUTDEVICE_MIC);
+
+  theAudio->initRecorder(AS_CODECTYPE_WAV,
+                         "/mnt/sd0/BIN",
+                         recoding_sampling_rate,
+                         recoding_bit_length,
+                         recoding_cannel_number);
+  puts("Init Recorder!");
+
+  /* Open file for data write on SD card */
+
+  if (theSD.exists(RECORD_FILE_NAME))
+    {
+      printf("Remove existing file [%s].\n", RECORD_FILE_NAME);
+      theSD.remove(RECORD_FILE_NAME);
+    }
+
+  myFile = theSD.open(RECORD_FILE_NAME, FILE_WRITE);
+  if (!myFile)
+    {
+      printf("File open error\n");
+      exit(1);
+    }
+
+  printf("Open! [%s]\n", RECORD_FILE_NAME);
+
+  theWriter.begin(myFile,
+                  recoding_sampling_rate,
+                  recoding_bit_length,
+                  recoding_cannel_number,
+                  recoding_byte_per_second);
+
+  theAudio->startRecorder();
+  puts("Recording Start! Enter 's' to stop.");
+}
+
+void loop()
+{
+  int err;
+
+  if ((Serial.available() > 0) && (Serial.read() == 's'))
+    {
+      theAudio->stopRecorder();
+      sleep(1);
+      theWriter.fetch(*theAudio);
+      goto exitRecording;
+    }
+
+  /* Move recorded data to the file */
+
+  err = theWriter.fetch(*theAudio);
+
+  if (err != WAVFILEWRITER_ECODE_OK)
+    {
+      printf("Write error! =%d\n", err);
+      theAudio->stopRecorder();
+      goto exitRecording;
+    }
+
+  if (ErrEnd)
+    {
+      printf("Error End\n");
+      theAudio->stopRecorder();
+      goto exitRecording;
+    }
+
+  return;
+
+exitRecording:
+
+  theWriter.end();
+  myFile.close();
+
+  printf("Recorded %llu bytes%s\n", theWriter.getDataSize(),
+         (theWriter.isRf64()) ? " as RF64" : "");
+
+  theAudio->setReadyMode();
+  theAudio->end();
+
+  puts("End Recording");
+  exit(1);
+}
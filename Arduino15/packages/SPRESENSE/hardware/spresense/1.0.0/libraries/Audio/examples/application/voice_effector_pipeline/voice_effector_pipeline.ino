@@ -0,0 +1,128 @@
+/*
+ *  voice_effector_pipeline.ino - Low latency effector application with PcmPipeline
+ *  Copyright 2018 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,  MA 02110-1301  USA
+ */
+
+#include <PcmPipeline.h>
+#include <MemoryUtil.h>
+#include <arch/board/board.h>
+
+PcmPipeline *thePipeline;
+
+/* 96 samples is 2ms at 48kHz. */
+
+static const uint32_t frame_sample = 96;
+
+/* Low pass filter at 1kHz (Q=0.707), coefficients in q14. */
+
+static PcmBiquad lpf = { { 64, 128, 64, -29743, 13615 } };
+
+/* Gain of +6dB in q12. */
+
+static PcmGain gain = { 8192 };
+
+static int lpf_stage;
+
+bool ErrEnd = false;
+
+/**
+ * @brief Audio attention callback
+ *
+ * When audio internal error occurs, this function will be called back.
+ */
+
+static void attention_cb(const ErrorAttentionParam *param)
+{
+  puts("Attention!");
+
+  if (param->error_code >= AS_ATTENTION_CODE_WARNING) {
+    ErrEnd = true;
+  }
+}
+
+/**
+ * @brief Setup the pipeline
+ *
+ * Captured frames pass through the filter and the gain, and are rendered
+ * without any copy.
+ */
+void setup()
+{
+  /* Initialize serial */
+  Serial.begin(115200);
+  while (!Serial);
+
+  /* Initialize memory pools and message libs */
+  initMemoryPools();
+  createStaticPools(MEM_LAYOUT_RECORDINGPLAYER);
+
+  thePipeline = PcmPipeline::getInstance();
+
+  thePipeline->begin(attention_cb);
+  thePipeline->activate(OutputMixer0, HPOutputDevice);
+  thePipeline->init(frame_sample);
+
+  lpf_stage = thePipeline->addStage(PcmPipeline::biquadStage, &lpf);
+  thePipeline->addStage(PcmPipeline::gainStage, &gain);
+
+  thePipeline->setVolume(0);
+
+  /* Unmute */
+  board_external_amp_mute_control(false);
+
+  thePipeline->start();
+
+  puts("Enter 'f' to toggle the filter.");
+}
+
+/**
+ * @brief audio loop
+ *
+ * Nothing to do for the audio data here.
+ */
+void loop()
+{
+  static bool bypass = false;
+
+  if (ErrEnd) {
+    puts("Error End");
+    goto exitPipeline;
+  }
+
+  if (Serial.available() > 0) {
+    if (Serial.read() == 'f') {
+      bypass = !bypass;
+      thePipeline->setBypass(lpf_stage, bypass);
+      printf("Filter %s\n", (bypass) ? "off" : "on");
+    }
+  }
+
+  usleep(100 * 1000);
+
+  return;
+
+exitPipeline:
+  thePipeline->stop();
+  board_external_amp_mute_control(true);
+  thePipeline->deactivate();
+  thePipeline->end();
+
+  printf("Rendered %d frames, %d invalid frames.\n",
+         thePipeline->getFrames(), thePipeline->getInvalidFrames());
+  puts("Exit.");
+  exit(1);
+}
@@ -0,0 +1,323 @@
+/*
+ *  DNNModelSet.cpp - Spresense Arduino DNN runtime library
+ *  Copyright 2018 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/**
+ * @file DNNModelSet.cpp
+ * @author Sony Semiconductor Solutions Corporation
+ * @brief Spresense Arduino DNN runtime library
+ *
+ * @details Several network models on one DNN runtime.
+ */
+
+#include <Arduino.h>
+#include <sdk/config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <pthread.h>
+#include <semaphore.h>
+
+#include <dnnrt/runtime.h>
+
+#include <DNNRT.h>
+#include <DNNModelSet.h>
+#include <File.h>
+
+DNNModelSet::DNNModelSet() :
+  _nr_models(0),
+  _cpu_num(0),
+  _running(false),
+  _qhead(0),
+  _qcount(0)
+{
+  for (int i = 0; i < DNN_MODELSET_MAX; i++)
+    {
+      _models[i]._shared = true;
+      _pending[i] = false;
+      _result[i] = 0;
+    }
+}
+
+int
+DNNModelSet::begin(unsigned char cpu_num, size_t stack_size)
+{
+  int ret;
+  dnn_config_t config;
+  struct sched_param param;
+  pthread_attr_t tattr;
+
+  if ((cpu_num < 1) || (cpu_num > 5))
+    {
+      return -EINVAL;
+    }
+
+  // DNN runtime is initialized once and shared by all models.
+
+  config.cpu_num = cpu_num;
+
+  ret = dnn_initialize(&config);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  pthread_mutex_init(&_lock, NULL);
+  pthread_mutex_init(&_run_lock, NULL);
+  sem_init(&_req_sem, 0, 0);
+  for (int i = 0; i < DNN_MODELSET_MAX; i++)
+    {
+      sem_init(&_done_sem[i], 0, 0);
+      _pending[i] = false;
+    }
+  _qhead = 0;
+  _qcount = 0;
+
+  pthread_attr_init(&tattr);
+  pthread_attr_setstacksize(&tattr, stack_size);
+  param.sched_priority = DNN_MODELSET_PRIO;
+  pthread_attr_setschedparam(&tattr, &param);
+
+  _running = true;
+  if (pthread_create(&_tid, &tattr,
+                     (pthread_startroutine_t)DNNModelSet::worker,
+                     (void *)this))
+    {
+      _running = false;
+      dnn_finalize();
+      return -4;
+    }
+  pthread_setname_np(_tid, "dnn_forward");
+
+  _cpu_num = cpu_num;
+  _nr_models = 0;
+
+  return 0;
+}
+
+int
+DNNModelSet::end()
+{
+  if (!_running)
+    {
+      return 0;
+    }
+
+  // Worker thread finishes queued requests, and then exits.
+
+  pthread_mutex_lock(&_lock);
+  _running = false;
+  pthread_mutex_unlock(&_lock);
+  sem_post(&_req_sem);
+  pthread_join(_tid, NULL);
+
+  for (int i = 0; i < _nr_models; i++)
+    {
+      _models[i].end();
+    }
+  _nr_models = 0;
+
+  sem_destroy(&_req_sem);
+  for (int i = 0; i < DNN_MODELSET_MAX; i++)
+    {
+      sem_destroy(&_done_sem[i]);
+    }
+  pthread_mutex_destroy(&_lock);
+  pthread_mutex_destroy(&_run_lock);
+
+  dnn_finalize();
+
+  return 0;
+}
+
+int
+DNNModelSet::prepare()
+{
+  if (!_running)
+    {
+      return -EPERM;
+    }
+  if (_nr_models >= DNN_MODELSET_MAX)
+    {
+      return -ENOSPC;
+    }
+  return 0;
+}
+
+int
+DNNModelSet::added(int ret)
+{
+  if (ret < 0)
+    {
+      return ret;
+    }
+  return _nr_models++;
+}
+
+int
+DNNModelSet::add(File &nnbfile)
+{
+  int ret = prepare();
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  return added(_models[_nr_models].begin(nnbfile, _cpu_num));
+}
+
+int
+DNNModelSet::add(const void *nnb)
+{
+  int ret = prepare();
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  return added(_models[_nr_models].begin(nnb, _cpu_num));
+}
+
+int
+DNNModelSet::add(DNNModelCache &cache)
+{
+  int ret = prepare();
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  return added(_models[_nr_models].begin(cache, _cpu_num));
+}
+
+int
+DNNModelSet::forward(unsigned int index)
+{
+  if (index >= (unsigned int)_nr_models)
+    {
+      return -EINVAL;
+    }
+  pthread_mutex_lock(&_lock);
+  bool pending = _pending[index];
+  pthread_mutex_unlock(&_lock);
+  if (pending)
+    {
+      return -EBUSY;
+    }
+
+  // Serialize with the worker thread, DNN runtime executes one network at
+  // a time.
+
+  pthread_mutex_lock(&_run_lock);
+  int ret = _models[index].forward();
+  pthread_mutex_unlock(&_run_lock);
+
+  return ret;
+}
+
+int
+DNNModelSet::forwardAsync(unsigned int index)
+{
+  if (index >= (unsigned int)_nr_models)
+    {
+      return -EINVAL;
+    }
+
+  pthread_mutex_lock(&_lock);
+  if (_pending[index])
+    {
+      pthread_mutex_unlock(&_lock);
+      return -EBUSY;
+    }
+  _pending[index] = true;
+  _queue[(_qhead + _qcount) % DNN_MODELSET_MAX] = index;
+  _qcount++;
+  pthread_mutex_unlock(&_lock);
+
+  sem_post(&_req_sem);
+
+  return 0;
+}
+
+int
+DNNModelSet::wait(unsigned int index)
+{
+  if (index >= (unsigned int)_nr_models)
+    {
+      return -EINVAL;
+    }
+  pthread_mutex_lock(&_lock);
+  bool pending = _pending[index];
+  pthread_mutex_unlock(&_lock);
+  if (!pending)
+    {
+      return _result[index];
+    }
+
+  while (sem_wait(&_done_sem[index]) < 0)
+    {
+      if (errno != EINTR)
+        {
+          return -errno;
+        }
+    }
+
+  pthread_mutex_lock(&_lock);
+  _pending[index] = false;
+  pthread_mutex_unlock(&_lock);
+
+  return _result[index];
+}
+
+void *
+DNNModelSet::worker(void *arg)
+{
+  DNNModelSet *set = (DNNModelSet *)arg;
+  int index;
+
+  for (;;)
+    {
+      sem_wait(&set->_req_sem);
+
+      pthread_mutex_lock(&set->_lock);
+      if (set->_qcount == 0)
+        {
+          bool running = set->_running;
+          pthread_mutex_unlock(&set->_lock);
+          if (!running)
+            {
+              break;
+            }
+          continue;
+        }
+
+      index = set->_queue[set->_qhead];
+      set->_qhead = (set->_qhead + 1) % DNN_MODELSET_MAX;
+      set->_qcount--;
+      pthread_mutex_unlock(&set->_lock);
+
+      pthread_mutex_lock(&set->_run_lock);
+      set->_result[index] = set->_models[index].forward();
+      pthread_mutex_unlock(&set->_run_lock);
+
+      sem_post(&set->_done_sem[index]);
+    }
+
+  return NULL;
+}
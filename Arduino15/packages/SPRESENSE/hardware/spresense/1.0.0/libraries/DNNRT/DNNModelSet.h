@@ -0,0 +1,198 @@
+/*
+ *  DNNModelSet.h - Spresense Arduino DNN runtime library
+ *  Copyright 2018 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef DnnModelSet_h
+#define DnnModelSet_h
+
+#ifdef SUBCORE
+#error "DNNRT library is NOT supported by SubCore."
+#endif
+
+/**
+ * @file DNNModelSet.h
+ * @author Sony Semiconductor Solutions Corporation
+ * @brief Spresense Arduino DNN runtime library
+ *
+ * @details DNNModelSet keeps several network models resident on one DNN
+ *          runtime, so that cascaded models (e.g. detector and classifier)
+ *          can be executed without finalizing the runtime between them.
+ */
+
+/**
+ * @ingroup dnnrt
+ * @{
+ */
+
+#include <Arduino.h>
+#include <pthread.h>
+#include <semaphore.h>
+
+#include <DNNRT.h>
+
+/** Maximum number of models in DNNModelSet */
+#define DNN_MODELSET_MAX      4
+
+/** Default stack size of the thread for forwardAsync()
+ *
+ * forward() runs the layers of the network on this stack, so it is the same
+ * size as the stack of the sketch. Use the stack_size argument of begin()
+ * to change it.
+ */
+#define DNN_MODELSET_STACK_SIZE  8192
+
+/** Priority of the thread for forwardAsync() */
+#define DNN_MODELSET_PRIO     100
+
+class DNNModelSet {
+
+public:
+  DNNModelSet();
+  ~DNNModelSet() {};
+
+  /**
+   * Initialize DNN runtime shared by all models
+   *
+   * @param cpu_num the number of CPUs to be used by DNN runtime (default 1)
+   * @param stack_size stack size of the thread for forwardAsync()
+   * @return 0 on success, otherwise error.
+   * @retval -22(-EINVAL) invalid argument of cpu_num
+   * @retval -16(-EBUSY) dnnrt-mp included in bootloader isn't installed,
+   *                     or no memory space to load it.
+   * @retval -4 failed to create the thread for forwardAsync()
+   */
+  int begin(unsigned char cpu_num = 1,
+            size_t stack_size = DNN_MODELSET_STACK_SIZE);
+
+  /**
+   * Finalize all models and DNN runtime
+   *
+   * Pending forwardAsync() requests are completed before finalizing.
+   *
+   * @return 0 on success, otherwise error.
+   */
+  int end();
+
+  /**
+   * Add network model from .nnb file
+   *
+   * @param nnbfile nnb network model binary file
+   * @return Index of added model, otherwise error.
+   * @retval -28(-ENOSPC) too many models
+   * @note Other errors are the same as DNNRT::begin().
+   */
+  int add(File &nnbfile);
+
+  /**
+   * Add network model in memory
+   *
+   * @param nnb Pointer to nnb network model binary, executed in place.
+   * @return Index of added model, otherwise error.
+   */
+  int add(const void *nnb);
+
+  /**
+   * Add network model from cache
+   *
+   * @param cache Validated network model cache
+   * @return Index of added model, otherwise error.
+   */
+  int add(DNNModelCache &cache);
+
+  /**
+   * Get number of models
+   *
+   * @return Number of models added to this set
+   */
+  int numOfModels() {
+    return _nr_models;
+  }
+
+  /**
+   * Get model at index
+   *
+   * Returned object is used for setting input and getting output data, same
+   * as DNNRT. Do not call DNNRT::begin() and DNNRT::end() for it.
+   *
+   * @param [in] index Index of model
+   * @return Model object
+   */
+  DNNRT& model(unsigned int index) {
+    return _models[index];
+  }
+
+  DNNRT& operator[](unsigned int index) {
+    return _models[index];
+  }
+
+  /**
+   * Execute forward propagation of the model at index
+   *
+   * @param [in] index Index of model
+   * @return 0 on success, otherwise error.
+   */
+  int forward(unsigned int index);
+
+  /**
+   * Request forward propagation of the model at index
+   *
+   * The forward propagation is executed on a dedicated thread, so that the
+   * caller can prepare the next input data (e.g. capture and normalize next
+   * frame) while the network is running. Requests are executed in order.
+   * Input and output data of the model must not be accessed until wait()
+   * returns.
+   *
+   * @param [in] index Index of model
+   * @return 0 on success, otherwise error.
+   * @retval -16(-EBUSY) previous request for the model is not completed
+   */
+  int forwardAsync(unsigned int index);
+
+  /**
+   * Wait for completion of forwardAsync()
+   *
+   * @param [in] index Index of model
+   * @return Result of forward propagation. 0 on success, otherwise error.
+   */
+  int wait(unsigned int index);
+
+private:
+  static void *worker(void *arg);
+  int prepare();
+  int added(int ret);
+
+  DNNRT         _models[DNN_MODELSET_MAX];
+  int           _nr_models;
+  unsigned char _cpu_num;
+  bool          _running;
+
+  pthread_t       _tid;
+  pthread_mutex_t _lock;                        // Protects request queue
+  pthread_mutex_t _run_lock;                    // Protects DNN runtime
+  sem_t           _req_sem;                     // Posted per request
+  sem_t           _done_sem[DNN_MODELSET_MAX];  // Posted per completion
+  bool            _pending[DNN_MODELSET_MAX];   // Request is not completed
+  int             _result[DNN_MODELSET_MAX];    // Result of forward()
+  int             _queue[DNN_MODELSET_MAX];     // Requested model index
+  int             _qhead;
+  int             _qcount;
+};
+
+/** @} dnnrt */
+
+#endif
@@ -31,7 +31,9 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <errno.h>
+#include <malloc.h>
 
 #include <dnnrt/runtime.h>
 
@@ -39,63 +41,168 @@
 #include <DNNRT.h>
 #include <File.h>
 
+#define DNN_CACHE_MAGIC 0x434e4e44 // "DNNC"
+
+static uint32_t crc_table[256];
+static bool crc_table_ready = false;
+
+/*
+ * Calculate CRC32 (IEEE 802.3)
+ */
+static uint32_t dnn_crc32(const uint8_t *buf, size_t len)
+{
+  if (!crc_table_ready)
+    {
+      for (uint32_t i = 0; i < 256; i++)
+        {
+          uint32_t c = i;
+          for (int j = 0; j < 8; j++)
+            {
+              c = (c & 1) ? (0xEDB88320 ^ (c >> 1)) : (c >> 1);
+            }
+          crc_table[i] = c;
+        }
+      crc_table_ready = true;
+    }
+
+  uint32_t c = 0xFFFFFFFF;
+  for (size_t i = 0; i < len; i++)
+    {
+      c = crc_table[(c ^ buf[i]) & 0xFF] ^ (c >> 8);
+    }
+  return c ^ 0xFFFFFFFF;
+}
+
 int
 DNNRT::begin(File& nnbfile, unsigned char cpu_num)
 {
   int ret;
   size_t size;
-  dnn_config_t config;
-
-  // Specify the number of CPUs to be used by DNN runtime
+  nn_network_t *network;
 
   if ((cpu_num < 1) || (cpu_num > 5))
     {
       return -EINVAL;
     }
 
-  config.cpu_num = cpu_num;
-
-  ret = dnn_initialize(&config);
-  if (ret < 0)
-    {
-      return ret;
-    }
-
   // Read whole data from network file
 
   size = nnbfile.size();
-  _network = (nn_network_t *)malloc(size);
-  if (!_network)
+  network = (nn_network_t *)malloc(size);
+  if (!network)
     {
       return -1;
     }
 
-  ret = nnbfile.read(_network, size);
+  ret = nnbfile.read(network, size);
   if (ret < 0)
     {
-      free(_network);
-      _network = NULL;
+      free(network);
       return -1;
     }
 
+  return setup(network, true, cpu_num);
+}
+
+int
+DNNRT::begin(const void *nnb, unsigned char cpu_num)
+{
+  if (!nnb)
+    {
+      return -EINVAL;
+    }
+
+  // DNN runtime never modifies network data, so it can be used in place.
+
+  return setup((nn_network_t *)nnb, false, cpu_num);
+}
+
+int
+DNNRT::begin(DNNModelCache &cache, unsigned char cpu_num)
+{
+  if (!cache.valid())
+    {
+      return -EINVAL;
+    }
+
+  return setup((nn_network_t *)cache.network(), false, cpu_num);
+}
+
+int
+DNNRT::setup(nn_network_t *network, bool owned, unsigned char cpu_num)
+{
+  int ret;
+  bool initialized = false;
+  dnn_config_t config;
+  size_t heap = 0;
+  unsigned long start = 0;
+
+  // Release the runtime of the previous begin() not ended yet.
+
+  if (_rt)
+    {
+      end();
+    }
+
+  _network = network;
+  _network_owned = owned;
+
+  // Specify the number of CPUs to be used by DNN runtime
+
+  if ((cpu_num < 1) || (cpu_num > 5))
+    {
+      ret = -EINVAL;
+      goto errout;
+    }
+
+  // DNN runtime is already initialized when this object is owned by
+  // DNNModelSet.
+
+  if (!_shared)
+    {
+      config.cpu_num = cpu_num;
+
+      ret = dnn_initialize(&config);
+      if (ret < 0)
+        {
+          goto errout;
+        }
+      initialized = true;
+    }
+
   _rt = (dnn_runtime_t *)malloc(sizeof(dnn_runtime_t));
   if (!_rt)
     {
-      free(_network);
-      _network = NULL;
-      return -1;
+      ret = -1;
+      goto errout;
+    }
+
+  if (_profiling)
+    {
+      heap = mallinfo().uordblks;
+      start = micros();
     }
 
   ret = dnn_runtime_initialize(_rt, _network);
   if (ret < 0)
     {
-      free(_network);
-      free(_rt);
+      ret = -2;
+      goto errout;
+    }
 
-      _network = NULL;
-      _rt = NULL;
+  // Buffers for all variables in the network are allocated by the runtime
+  // initialization, so they are measured here.
 
-      return -2;
+  if (_profiling)
+    {
+      size_t used = mallinfo().uordblks;
+
+      _profile.init = micros() - start;
+      _profile.runtimeMem = (used > heap) ? used - heap : 0;
+      if (_profile.heapMax < used)
+        {
+          _profile.heapMax = used;
+        }
     }
 
   // Get number of input/output data defined by network model.
@@ -105,13 +212,9 @@ DNNRT::begin(File& nnbfile, unsigned char cpu_num)
 
   if (_nr_inputs <= 0 || _nr_outputs <= 0)
     {
-      free(_network);
-      free(_rt);
-
-      _network = NULL;
-      _rt = NULL;
-
-      return -3;
+      dnn_runtime_finalize(_rt);
+      ret = -3;
+      goto errout;
     }
 
   // Allocate input and output data array from network model
@@ -119,16 +222,51 @@ DNNRT::begin(File& nnbfile, unsigned char cpu_num)
   _input = (void **)malloc(sizeof(void *) * _nr_inputs);
   _output = new DNNVariable[_nr_outputs];
 
+  // Output buffers are owned by DNN runtime and never moved, so bind them
+  // to output variables at once.
+
+  for (int i = 0; i < _nr_outputs; i++)
+    {
+      bindOutput(i);
+    }
+
   return 0;
+
+errout:
+  if (initialized)
+    {
+      dnn_finalize();
+    }
+  if (_network_owned)
+    {
+      free(_network);
+    }
+  if (_rt)
+    {
+      free(_rt);
+    }
+  _network = NULL;
+  _network_owned = false;
+  _rt = NULL;
+
+  return ret;
 }
 
 int
 DNNRT::end()
 {
+  if (!_rt)
+    {
+      return 0;
+    }
+
   dnn_runtime_finalize(_rt);
-  dnn_finalize();
+  if (!_shared)
+    {
+      dnn_finalize();
+    }
 
-  if (_network)
+  if (_network && _network_owned)
     {
       free(_network);
     }
@@ -145,6 +283,14 @@ DNNRT::end()
       delete[] _output;
     }
 
+  _network = NULL;
+  _network_owned = false;
+  _rt = NULL;
+  _input = NULL;
+  _output = NULL;
+  _nr_inputs = 0;
+  _nr_outputs = 0;
+
   return 0;
 }
 
@@ -155,6 +301,10 @@ DNNRT::inputVariable(DNNVariable &var, unsigned int index)
     {
       return -1;
     }
+  if (var.size() < (unsigned int)dnn_runtime_input_size(_rt, index))
+    {
+      return -EINVAL;
+    }
 
   _input[index] = var.data();
 
@@ -170,21 +320,130 @@ DNNRT::outputVariable(unsigned int index)
 int
 DNNRT::forward(void)
 {
-  int ret = dnn_runtime_forward(_rt, (const void **)_input, _nr_inputs);
-  if (ret < 0)
+  int ret;
+  size_t heap;
+  size_t used;
+  unsigned long start;
+  unsigned long elapsed;
+
+  if (!_profiling)
     {
-      return ret;
+      return dnn_runtime_forward(_rt, (const void **)_input, _nr_inputs);
     }
 
-  for (int i = 0; i < _nr_outputs; i++)
+  heap = mallinfo().uordblks;
+  start = micros();
+
+  ret = dnn_runtime_forward(_rt, (const void **)_input, _nr_inputs);
+
+  elapsed = micros() - start;
+  used = mallinfo().uordblks;
+
+  _profile.count++;
+  _profile.last = elapsed;
+  _profile.total += elapsed;
+  if (_profile.count == 1 || elapsed < _profile.min)
+    {
+      _profile.min = elapsed;
+    }
+  if (_profile.max < elapsed)
     {
-      _output[i]._data = (float *)dnn_runtime_output_buffer(_rt, i);
-      _output[i]._size = dnn_runtime_output_size(_rt, i);
+      _profile.max = elapsed;
+    }
+  if (used > heap && _profile.forwardMem < used - heap)
+    {
+      _profile.forwardMem = used - heap;
+    }
+  if (_profile.heapMax < used)
+    {
+      _profile.heapMax = used;
     }
 
   return ret;
 }
 
+void
+DNNRT::enableProfile(bool enable)
+{
+  if (enable && !_profiling)
+    {
+      memset(&_profile, 0, sizeof(_profile));
+    }
+  _profiling = enable;
+}
+
+void
+DNNRT::resetProfile()
+{
+  _profile.count = 0;
+  _profile.last = 0;
+  _profile.min = 0;
+  _profile.max = 0;
+  _profile.total = 0;
+  _profile.forwardMem = 0;
+}
+
+void
+DNNRT::printProfile(Print &out, bool csv)
+{
+  unsigned long avg = _profile.count ? _profile.total / _profile.count : 0;
+
+  if (csv)
+    {
+      out.println("count,last_us,min_us,avg_us,max_us,init_us,"
+                  "runtime_mem,forward_mem,heap_max");
+      out.print(_profile.count); out.print(',');
+      out.print(_profile.last); out.print(',');
+      out.print(_profile.min); out.print(',');
+      out.print(avg); out.print(',');
+      out.print(_profile.max); out.print(',');
+      out.print(_profile.init); out.print(',');
+      out.print(_profile.runtimeMem); out.print(',');
+      out.print(_profile.forwardMem); out.print(',');
+      out.println(_profile.heapMax);
+      return;
+    }
+
+  out.print("forward count  : "); out.println(_profile.count);
+  out.print("forward last   : "); out.print(_profile.last); out.println(" us");
+  out.print("forward min    : "); out.print(_profile.min); out.println(" us");
+  out.print("forward avg    : "); out.print(avg); out.println(" us");
+  out.print("forward max    : "); out.print(_profile.max); out.println(" us");
+  out.print("initialize     : "); out.print(_profile.init); out.println(" us");
+  out.print("runtime memory : "); out.print(_profile.runtimeMem);
+  out.println(" bytes");
+  out.print("forward memory : "); out.print(_profile.forwardMem);
+  out.println(" bytes");
+  out.print("heap max       : "); out.print(_profile.heapMax);
+  out.println(" bytes");
+}
+
+void
+DNNRT::bindOutput(int index)
+{
+  DNNVariable &var = _output[index];
+  int ndim;
+
+  var._data = (float *)dnn_runtime_output_buffer(_rt, index);
+  var._size = dnn_runtime_output_size(_rt, index);
+
+  ndim = dnn_runtime_output_ndim(_rt, index);
+  if (ndim < 1 || ndim > DNN_VARIABLE_MAX_DIM)
+    {
+      // Treat as 1 dimensional array when the shape can not be held
+
+      var._ndim = 1;
+      var._shape[0] = var._size;
+      return;
+    }
+
+  var._ndim = ndim;
+  for (int i = 0; i < ndim; i++)
+    {
+      var._shape[i] = dnn_runtime_output_shape(_rt, index, i);
+    }
+}
+
 int
 DNNRT::numOfInput(void)
 {
@@ -241,6 +500,58 @@ DNNRT::outputShapeSize(unsigned int index, unsigned int dindex)
   return ret;
 }
 
+int
+DNNRT::inputDataType(unsigned int index)
+{
+  nn_variable_t *var = dnn_runtime_input_variable(_rt, index);
+  return var ? (int)var->type : -EINVAL;
+}
+
+int
+DNNRT::inputFixedPoint(unsigned int index)
+{
+  nn_variable_t *var = dnn_runtime_input_variable(_rt, index);
+  return var ? (int)var->fp_pos : -EINVAL;
+}
+
+int
+DNNRT::outputDataType(unsigned int index)
+{
+  nn_variable_t *var = dnn_runtime_output_variable(_rt, index);
+  return var ? (int)var->type : -EINVAL;
+}
+
+int
+DNNRT::outputFixedPoint(unsigned int index)
+{
+  nn_variable_t *var = dnn_runtime_output_variable(_rt, index);
+  return var ? (int)var->fp_pos : -EINVAL;
+}
+
+int
+DNNRT::inputBuffer(const void *buf, unsigned int index)
+{
+  if (index >= (unsigned int)_nr_inputs || !buf)
+    {
+      return -1;
+    }
+
+  _input[index] = (void *)buf;
+
+  return 0;
+}
+
+const void *
+DNNRT::outputBuffer(unsigned int index)
+{
+  if (index >= (unsigned int)_nr_outputs)
+    {
+      return NULL;
+    }
+
+  return dnn_runtime_output_buffer(_rt, index);
+}
+
 ////////////////////////////////////////////////////////////////////////////
 // DNNVariable
 ////////////////////////////////////////////////////////////////////////////
@@ -248,29 +559,141 @@ DNNRT::outputShapeSize(unsigned int index, unsigned int dindex)
 DNNVariable::DNNVariable() :
   _data(0),
   _size(0),
-  _allocated(false)
+  _allocated(false),
+  _ndim(1)
 {
+  _shape[0] = 0;
 }
 
 DNNVariable::DNNVariable(unsigned int size)
 {
   _data = (float *)malloc(size * sizeof(float));
-  _size = size;
+  _size = _data ? size : 0;
   _allocated = true;
+  _ndim = 1;
+  _shape[0] = _size;
+}
+
+DNNVariable::DNNVariable(float *data, unsigned int size) :
+  _data(data),
+  _size(size),
+  _allocated(false),
+  _ndim(1)
+{
+  _shape[0] = size;
+}
+
+DNNVariable::DNNVariable(const DNNVariable &var) :
+  _data(var._data),
+  _size(var._size),
+  _allocated(false),
+  _ndim(var._ndim)
+{
+  memcpy(_shape, var._shape, sizeof(_shape));
+}
+
+DNNVariable&
+DNNVariable::operator=(const DNNVariable &var)
+{
+  if (this != &var)
+    {
+      release();
+      _data = var._data;
+      _size = var._size;
+      _allocated = false;
+      _ndim = var._ndim;
+      memcpy(_shape, var._shape, sizeof(_shape));
+    }
+  return *this;
+}
+
+DNNVariable::DNNVariable(DNNVariable &&var) :
+  _data(var._data),
+  _size(var._size),
+  _allocated(var._allocated),
+  _ndim(var._ndim)
+{
+  memcpy(_shape, var._shape, sizeof(_shape));
+  var._allocated = false;
+}
+
+DNNVariable&
+DNNVariable::operator=(DNNVariable &&var)
+{
+  if (this != &var)
+    {
+      release();
+      _data = var._data;
+      _size = var._size;
+      _allocated = var._allocated;
+      _ndim = var._ndim;
+      memcpy(_shape, var._shape, sizeof(_shape));
+      var._allocated = false;
+    }
+  return *this;
 }
 
 DNNVariable::~DNNVariable()
+{
+  release();
+}
+
+void
+DNNVariable::release()
 {
   /*
-   * Free memory for allocated by constructor.
-   * When use this object as output, DNNRT class set _data member
-   * directory, so not free them.
+   * Free memory only when this object owns it.
+   * Views and output variables bound by DNNRT point to the memory owned
+   * by others, so not free them.
    */
 
   if (_allocated)
     {
       free(_data);
     }
+  _data = NULL;
+  _size = 0;
+  _allocated = false;
+}
+
+int
+DNNVariable::setShape(unsigned int ndim, const unsigned int *shape)
+{
+  unsigned int total = 1;
+
+  if (ndim < 1 || ndim > DNN_VARIABLE_MAX_DIM || !shape)
+    {
+      return -EINVAL;
+    }
+  for (unsigned int i = 0; i < ndim; i++)
+    {
+      total *= shape[i];
+    }
+  if (total > _size)
+    {
+      return -EINVAL;
+    }
+
+  _ndim = ndim;
+  memcpy(_shape, shape, sizeof(unsigned int) * ndim);
+
+  return 0;
+}
+
+unsigned int
+DNNVariable::stride(unsigned int dim)
+{
+  unsigned int stride = 1;
+
+  if (dim >= _ndim)
+    {
+      return 0;
+    }
+  for (unsigned int i = dim + 1; i < _ndim; i++)
+    {
+      stride *= _shape[i];
+    }
+  return stride;
 }
 
 int
@@ -295,3 +718,306 @@ DNNVariable::maxIndex()
     }
   return index;
 }
+
+////////////////////////////////////////////////////////////////////////////
+// DNNQuantizer
+////////////////////////////////////////////////////////////////////////////
+
+DNNQuantizer::DNNQuantizer(int type, int fp_pos) :
+  _type(type),
+  _fp_pos(fp_pos)
+{
+  setNormalization(1.0f / 255.0f);
+}
+
+DNNQuantizer::DNNQuantizer(DNNRT &rt, unsigned int index) :
+  _type(rt.inputDataType(index)),
+  _fp_pos(rt.inputFixedPoint(index))
+{
+  if (_type < 0 || _fp_pos < 0)
+    {
+      _type = DNN_DATA_FLOAT;
+      _fp_pos = 0;
+    }
+  setNormalization(1.0f / 255.0f);
+}
+
+static inline int32_t saturate(int32_t v, int32_t min, int32_t max)
+{
+  return (v < min) ? min : ((v > max) ? max : v);
+}
+
+void
+DNNQuantizer::setNormalization(float scale, float offset)
+{
+  float q = (float)(1 << _fp_pos);
+  int32_t min = (_type == DNN_DATA_INT8) ? INT8_MIN : INT16_MIN;
+  int32_t max = (_type == DNN_DATA_INT8) ? INT8_MAX : INT16_MAX;
+
+  _scale = scale;
+  _offset = offset;
+
+  if (_type == DNN_DATA_FLOAT)
+    {
+      return;
+    }
+
+  // Pre-calculate quantized value of all pixel values, so that conversion
+  // costs one table look up per pixel.
+
+  for (int i = 0; i < 256; i++)
+    {
+      float v = ((float)i * scale + offset) * q;
+      _lut[i] = (int16_t)saturate((int32_t)(v < 0 ? v - 0.5f : v + 0.5f),
+                                  min, max);
+    }
+}
+
+unsigned int
+DNNQuantizer::elementSize()
+{
+  switch (_type)
+    {
+      case DNN_DATA_INT8:
+        return sizeof(int8_t);
+      case DNN_DATA_INT16:
+        return sizeof(int16_t);
+      default:
+        return sizeof(float);
+    }
+}
+
+void
+DNNQuantizer::convert8(const uint8_t *src, unsigned int step, void *dst,
+                       unsigned int num)
+{
+  unsigned int i;
+
+  switch (_type)
+    {
+      case DNN_DATA_INT8:
+        {
+          int8_t *d = (int8_t *)dst;
+          for (i = 0; i < num; i++, src += step)
+            {
+              d[i] = (int8_t)_lut[*src];
+            }
+        }
+        break;
+
+      case DNN_DATA_INT16:
+        {
+          int16_t *d = (int16_t *)dst;
+          for (i = 0; i < num; i++, src += step)
+            {
+              d[i] = _lut[*src];
+            }
+        }
+        break;
+
+      default:
+        {
+          float *d = (float *)dst;
+          for (i = 0; i < num; i++, src += step)
+            {
+              d[i] = (float)*src * _scale + _offset;
+            }
+        }
+        break;
+    }
+}
+
+void
+DNNQuantizer::fromGray8(const uint8_t *src, void *dst, unsigned int num)
+{
+  convert8(src, 1, dst, num);
+}
+
+void
+DNNQuantizer::fromYUV422(const uint8_t *src, void *dst, unsigned int num)
+{
+  // Y is placed at odd bytes in UYVY
+
+  convert8(src + 1, 2, dst, num);
+}
+
+void
+DNNQuantizer::fromQ15(const int16_t *src, void *dst, unsigned int num,
+                      unsigned int stride)
+{
+  unsigned int i;
+
+  // Fixed point position is 4 bits in network model, so never exceeds 15.
+
+  int shift = 15 - _fp_pos;
+
+  switch (_type)
+    {
+      case DNN_DATA_INT8:
+        {
+          int8_t *d = (int8_t *)dst;
+          for (i = 0; i < num; i++, src += stride)
+            {
+              int32_t v = *src >> shift;
+              d[i] = (int8_t)saturate(v, INT8_MIN, INT8_MAX);
+            }
+        }
+        break;
+
+      case DNN_DATA_INT16:
+        {
+          int16_t *d = (int16_t *)dst;
+          for (i = 0; i < num; i++, src += stride)
+            {
+              int32_t v = *src >> shift;
+              d[i] = (int16_t)saturate(v, INT16_MIN, INT16_MAX);
+            }
+        }
+        break;
+
+      default:
+        {
+          float *d = (float *)dst;
+          for (i = 0; i < num; i++, src += stride)
+            {
+              d[i] = (float)*src * (1.0f / 32768.0f);
+            }
+        }
+        break;
+    }
+}
+
+float
+DNNQuantizer::toFloat(const void *src, unsigned int index)
+{
+  float q = (float)(1 << _fp_pos);
+
+  switch (_type)
+    {
+      case DNN_DATA_INT8:
+        return (float)((const int8_t *)src)[index] / q;
+      case DNN_DATA_INT16:
+        return (float)((const int16_t *)src)[index] / q;
+      default:
+        return ((const float *)src)[index];
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////
+// DNNModelCache
+////////////////////////////////////////////////////////////////////////////
+
+DNNModelCache::~DNNModelCache()
+{
+  invalidate();
+}
+
+int
+DNNModelCache::load(File &nnbfile)
+{
+  int ret;
+  size_t size;
+
+  if (_valid)
+    {
+      return 0;
+    }
+
+  invalidate();
+
+  // Allocate header and network model at once, so that network model is
+  // placed just after the header same as the saved blob.
+
+  size = nnbfile.size();
+  _blob = (Header *)malloc(sizeof(Header) + size);
+  if (!_blob)
+    {
+      return -1;
+    }
+  _allocated = true;
+
+  ret = nnbfile.read((uint8_t *)(_blob + 1), size);
+  if (ret < 0 || (size_t)ret != size)
+    {
+      invalidate();
+      return -EIO;
+    }
+
+  _blob->magic = DNN_CACHE_MAGIC;
+  _blob->size = size;
+  _blob->crc = dnn_crc32((const uint8_t *)(_blob + 1), size);
+  _blob->reserved = 0;
+  _valid = true;
+
+  return 0;
+}
+
+int
+DNNModelCache::attach(const void *blob, size_t size)
+{
+  const Header *h = (const Header *)blob;
+
+  invalidate();
+
+  if (!h || ((uintptr_t)h & 3) || size < sizeof(Header))
+    {
+      return -EINVAL;
+    }
+  if (h->magic != DNN_CACHE_MAGIC || h->size > size - sizeof(Header))
+    {
+      return -EINVAL;
+    }
+  if (h->crc != dnn_crc32((const uint8_t *)(h + 1), h->size))
+    {
+      return -EINVAL;
+    }
+
+  _blob = (Header *)h;
+  _allocated = false;
+  _valid = true;
+
+  return 0;
+}
+
+int
+DNNModelCache::save(File &file)
+{
+  size_t size;
+
+  if (!_valid)
+    {
+      return -EINVAL;
+    }
+
+  size = sizeof(Header) + _blob->size;
+  if (file.write((const uint8_t *)_blob, size) != size)
+    {
+      return -EIO;
+    }
+
+  return 0;
+}
+
+void
+DNNModelCache::invalidate()
+{
+  if (_blob && _allocated)
+    {
+      free(_blob);
+    }
+  _blob = NULL;
+  _allocated = false;
+  _valid = false;
+}
+
+const void *
+DNNModelCache::network()
+{
+  return _valid ? (const void *)(_blob + 1) : NULL;
+}
+
+size_t
+DNNModelCache::size()
+{
+  return _valid ? _blob->size : 0;
+}
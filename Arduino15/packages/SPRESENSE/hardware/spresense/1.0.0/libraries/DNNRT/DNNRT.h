@@ -34,7 +34,36 @@
 
 #include <dnnrt/runtime.h>
 
+/** Input/Output data is 32bit float */
+#define DNN_DATA_FLOAT NN_DATA_TYPE_FLOAT
+/** Input/Output data is 16bit fixed point */
+#define DNN_DATA_INT16 NN_DATA_TYPE_INT16
+/** Input/Output data is 8bit fixed point */
+#define DNN_DATA_INT8  NN_DATA_TYPE_INT8
+
+/**
+ * Profiling result of DNNRT
+ *
+ * Time is in microseconds, memory is in bytes.
+ */
+struct DNNProfile {
+  unsigned long count;       /**< Number of forward() executed */
+  unsigned long last;        /**< Time of last forward() */
+  unsigned long min;         /**< Minimum time of forward() */
+  unsigned long max;         /**< Maximum time of forward() */
+  unsigned long total;       /**< Total time of forward() */
+  unsigned long init;        /**< Time of runtime initialization in begin() */
+  size_t        runtimeMem;  /**< Heap used by runtime (buffers for network) */
+  size_t        forwardMem;  /**< Maximum heap left allocated when forward()
+                                  returns */
+  size_t        heapMax;     /**< Maximum heap usage sampled when begin() and
+                                  forward() return. Memory allocated and
+                                  freed inside them is not counted. */
+};
+
 class DNNVariable; // forward reference
+class DNNModelCache; // forward reference
+class DNNModelSet; // forward reference
 class File;
 
 /**
@@ -48,9 +77,13 @@ class File;
  */
 
 class DNNRT {
+  friend class DNNModelSet;
 
 public:
-  DNNRT() {};
+  DNNRT() :
+    _shared(false), _rt(NULL), _network(NULL), _network_owned(false),
+    _input(NULL), _nr_inputs(0), _output(NULL), _nr_outputs(0),
+    _profiling(false), _profile() {};
   ~DNNRT() {};
 
   /**
@@ -74,6 +107,33 @@ public:
    */  
   int begin(File &nnbfile, unsigned char cpu_num = 1);
 
+  /**
+   * Initialize runtime object from network model in memory
+   *
+   * The network model is executed in place, it is not copied. So the memory
+   * pointed by nnb must be kept until end() is called. This is useful for
+   * the model embedded into the sketch as a constant array.
+   *
+   * @param nnb Pointer to nnb network model binary
+   * @param cpu_num the number of CPUs to be used by DNN runtime (default 1)
+   * @return 0 on success, otherwise error. See begin(File&, unsigned char).
+   */
+  int begin(const void *nnb, unsigned char cpu_num = 1);
+
+  /**
+   * Initialize runtime object from cached network model
+   *
+   * The network model held by cache is used in place, so repeated begin()
+   * and end() do not read nnb file again. The cache must be kept valid
+   * until end() is called.
+   *
+   * @param cache Validated network model cache
+   * @param cpu_num the number of CPUs to be used by DNN runtime (default 1)
+   * @return 0 on success, otherwise error. See begin(File&, unsigned char).
+   * @retval -22(-EINVAL) cache is not valid
+   */
+  int begin(DNNModelCache &cache, unsigned char cpu_num = 1);
+
   /**
    * Finalize runtime object
    *
@@ -84,9 +144,13 @@ public:
   /**
    * Set input data at index
    *
+   * The data array of var is passed to the network directly, it is not
+   * copied. So var must be kept until forward() is called.
+   *
    * @param [in] var   Input data to the network
    * @param [in] index Index of input data
    * @return 0 on success, otherwise error.
+   * @retval -22(-EINVAL) var is smaller than the input size
    * @note Number of input data is depends on the network model.
    */
   int inputVariable(DNNVariable &var, unsigned int index);
@@ -94,6 +158,9 @@ public:
   /**
    * Get output data at index
    *
+   * Returned variable is a view of the output buffer in DNN runtime. It is
+   * valid until end() is called, and it is overwritten by next forward().
+   *
    * @param [in] index Index of output data
    * @return Output variable data. the shape of output data is depends on the
    *         network model.
@@ -171,21 +238,159 @@ public:
    */
   int outputShapeSize(unsigned int index, unsigned int shapeindex);
 
+  /**
+   * Get data type of input data at index
+   *
+   * Quantized network model takes fixed point data as input. In that case,
+   * input data must be set by inputBuffer() instead of inputVariable().
+   *
+   * @param [in] index Index of input data
+   * @return DNN_DATA_FLOAT, DNN_DATA_INT16 or DNN_DATA_INT8,
+   *         otherwise error.
+   */
+  int inputDataType(unsigned int index);
+
+  /**
+   * Get fixed point position of input data at index
+   *
+   * Real value of fixed point data is (data / 2^position).
+   *
+   * @param [in] index Index of input data
+   * @return Fixed point position, otherwise error.
+   */
+  int inputFixedPoint(unsigned int index);
+
+  /**
+   * Get data type of output data at index
+   *
+   * @param [in] index Index of output data
+   * @return DNN_DATA_FLOAT, DNN_DATA_INT16 or DNN_DATA_INT8,
+   *         otherwise error.
+   */
+  int outputDataType(unsigned int index);
+
+  /**
+   * Get fixed point position of output data at index
+   *
+   * @param [in] index Index of output data
+   * @return Fixed point position, otherwise error.
+   */
+  int outputFixedPoint(unsigned int index);
+
+  /**
+   * Set input data at index in the data type of the network
+   *
+   * The buffer must hold inputSize() elements of inputDataType(), and it
+   * must be kept until forward() is called.
+   *
+   * @param [in] buf   Input data buffer
+   * @param [in] index Index of input data
+   * @return 0 on success, otherwise error.
+   */
+  int inputBuffer(const void *buf, unsigned int index);
+
+  /**
+   * Get output data buffer at index in the data type of the network
+   *
+   * @param [in] index Index of output data
+   * @return Pointer to output data buffer, NULL on error.
+   */
+  const void *outputBuffer(unsigned int index);
+
+  /**
+   * Enable or disable profiling
+   *
+   * When profiling is enabled, execution time of forward() and heap memory
+   * used by the runtime are recorded. Call this before begin() to record
+   * memory used for runtime initialization.
+   *
+   * @param [in] enable true to enable profiling
+   */
+  void enableProfile(bool enable = true);
+
+  /**
+   * Clear profiling result of forward()
+   */
+  void resetProfile();
+
+  /**
+   * Get profiling result
+   *
+   * @return Profiling result
+   */
+  const DNNProfile& profile() {
+    return _profile;
+  }
+
+  /**
+   * Print profiling result
+   *
+   * @param [in] out Output stream (e.g. Serial)
+   * @param [in] csv Print a header line and values in CSV format
+   */
+  void printProfile(Print &out, bool csv = false);
+
 private:
+  int setup(nn_network_t *network, bool owned, unsigned char cpu_num);
+  void bindOutput(int index);
+
+  bool           _shared;        // DNN runtime is shared with DNNModelSet
   dnn_runtime_t *_rt;            // DNN runtime context
   nn_network_t  *_network;       // Network data from .nnb file
+  bool           _network_owned; // _network is allocated by begin()
 
   void         **_input;         // Input data array
   int            _nr_inputs;     // Number of input data
   DNNVariable   *_output;        // Output data array
   int            _nr_outputs;    // Number of output data
+
+  bool           _profiling;     // Profiling is enabled
+  DNNProfile     _profile;       // Profiling result
 };
 
+/** Maximum number of dimensions held by DNNVariable */
+#define DNN_VARIABLE_MAX_DIM 4
+
 class DNNVariable {
   friend class DNNRT;
 
 public:
+  /**
+   * Create variable with own data array
+   *
+   * @param [in] size Number of elements
+   */
   DNNVariable(unsigned int size);
+
+  /**
+   * Create variable as a view of existing data array
+   *
+   * The data array is not copied and not freed by this object, so the
+   * caller must keep it while this variable is used. This is useful for
+   * passing float data (e.g. FFT result) to the network without copying.
+   *
+   * @param [in] data Pointer to data array
+   * @param [in] size Number of elements
+   */
+  DNNVariable(float *data, unsigned int size);
+
+  /**
+   * Copy variable
+   *
+   * The copied variable is a view of the same data array, it does not own
+   * the data array even if the source variable owns it.
+   */
+  DNNVariable(const DNNVariable &var);
+  DNNVariable& operator=(const DNNVariable &var);
+
+  /**
+   * Move variable
+   *
+   * The ownership of the data array is moved to the new variable.
+   */
+  DNNVariable(DNNVariable &&var);
+  DNNVariable& operator=(DNNVariable &&var);
+
   ~DNNVariable();
 
   /**
@@ -213,6 +418,54 @@ public:
     return _data;
   }
 
+  /**
+   * Return whether this variable owns data array
+   *
+   * @return false if this variable is a view of other data array
+   */
+  bool isOwner() {
+    return _allocated;
+  }
+
+  /**
+   * Set shape of data array
+   *
+   * Strides are calculated from the shape in row-major order.
+   *
+   * @param [in] ndim Number of dimensions (1 to DNN_VARIABLE_MAX_DIM)
+   * @param [in] shape Size of each dimension
+   * @return 0 on success, otherwise error.
+   * @retval -22(-EINVAL) invalid shape, or product of shape exceeds size()
+   */
+  int setShape(unsigned int ndim, const unsigned int *shape);
+
+  /**
+   * Get number of dimensions
+   *
+   * @return Number of dimensions
+   */
+  unsigned int dimension() {
+    return _ndim;
+  }
+
+  /**
+   * Get size of dimension
+   *
+   * @param [in] dim Index of dimension
+   * @return Shape size, 0 if dim is out of range.
+   */
+  unsigned int shape(unsigned int dim) {
+    return (dim < _ndim) ? _shape[dim] : 0;
+  }
+
+  /**
+   * Get stride of dimension in elements
+   *
+   * @param [in] dim Index of dimension
+   * @return Stride, 0 if dim is out of range.
+   */
+  unsigned int stride(unsigned int dim);
+
   /**
    * Return array index to the elements in maximum value
    *
@@ -222,9 +475,199 @@ public:
 
 private:
   DNNVariable();
+  void release();
+
   float *_data;
   unsigned int _size;
   bool _allocated;
+  unsigned int _ndim;
+  unsigned int _shape[DNN_VARIABLE_MAX_DIM];
+};
+
+/**
+ * Fused normalization and quantization for network input
+ *
+ * Convert 8bit pixel (e.g. gray scale image, Y of YUV422 camera image) or
+ * q15 audio samples into the input data type of the network in one pass,
+ * without creating intermediate float array.
+ *
+ * For 8bit pixel, the normalized value is (pixel * scale + offset), and it
+ * is looked up from a table created by setNormalization().
+ */
+class DNNQuantizer {
+public:
+  /**
+   * Create quantizer
+   *
+   * @param [in] type    Data type (DNN_DATA_FLOAT, DNN_DATA_INT16 or
+   *                     DNN_DATA_INT8)
+   * @param [in] fp_pos  Fixed point position for DNN_DATA_INT16/INT8
+   */
+  DNNQuantizer(int type = DNN_DATA_FLOAT, int fp_pos = 0);
+
+  /**
+   * Create quantizer for network input
+   *
+   * @param [in] rt    Initialized runtime object
+   * @param [in] index Index of input data
+   */
+  DNNQuantizer(DNNRT &rt, unsigned int index);
+
+  /**
+   * Set normalization for 8bit pixel
+   *
+   * @param [in] scale  Scale factor (default 1/255)
+   * @param [in] offset Offset added after scaling (default 0)
+   */
+  void setNormalization(float scale, float offset = 0.0f);
+
+  /**
+   * Return size of one element in bytes
+   */
+  unsigned int elementSize();
+
+  /**
+   * Convert 8bit gray scale pixels
+   *
+   * @param [in]  src Source pixels
+   * @param [out] dst Destination buffer in the data type
+   * @param [in]  num Number of pixels
+   */
+  void fromGray8(const uint8_t *src, void *dst, unsigned int num);
+
+  /**
+   * Convert luminance of YUV422 (UYVY) pixels
+   *
+   * This can be used for CamImage in CAM_IMAGE_PIX_FMT_YUV422.
+   *
+   * @param [in]  src Source image in UYVY
+   * @param [out] dst Destination buffer in the data type
+   * @param [in]  num Number of pixels
+   */
+  void fromYUV422(const uint8_t *src, void *dst, unsigned int num);
+
+  /**
+   * Convert q15 samples
+   *
+   * Sample value is treated as (sample / 32768). To pick one channel from
+   * interleaved PCM data, specify the number of channels as stride.
+   *
+   * @param [in]  src    Source samples
+   * @param [out] dst    Destination buffer in the data type
+   * @param [in]  num    Number of samples to convert
+   * @param [in]  stride Distance between samples in src (default 1)
+   */
+  void fromQ15(const int16_t *src, void *dst, unsigned int num,
+               unsigned int stride = 1);
+
+  /**
+   * Get real value of an element
+   *
+   * This can be used for reading quantized output data.
+   *
+   * @param [in] src   Buffer in the data type
+   * @param [in] index Index of element
+   * @return Real value
+   */
+  float toFloat(const void *src, unsigned int index);
+
+private:
+  void convert8(const uint8_t *src, unsigned int step, void *dst,
+                unsigned int num);
+
+  int     _type;
+  int     _fp_pos;
+  float   _scale;
+  float   _offset;
+  int16_t _lut[256];  // Quantized value of each pixel
+};
+
+/**
+ * Network model cache
+ *
+ * Hold a network model (.nnb) in memory with a small header and CRC, so that
+ * the model can be validated once and then passed to DNNRT::begin() many
+ * times without reading and copying nnb file.
+ *
+ * The cache blob can be written out by save() and used later from any
+ * memory region (e.g. constant array in the sketch) by attach().
+ */
+class DNNModelCache {
+public:
+  DNNModelCache() : _blob(NULL), _allocated(false), _valid(false) {};
+  ~DNNModelCache();
+
+  /**
+   * Load network model from .nnb file into cache
+   *
+   * If the cache is already valid, this function does nothing and returns
+   * immediately. Call invalidate() to load again.
+   *
+   * @param [in] nnbfile nnb network model binary file
+   * @return 0 on success, otherwise error.
+   * @retval -1 no memory space to load nnbfile
+   * @retval -5(-EIO) failed to read nnbfile
+   */
+  int load(File &nnbfile);
+
+  /**
+   * Attach cache blob in memory
+   *
+   * The blob must be created by save(). Header and CRC are checked at
+   * attaching, and the blob is used in place.
+   *
+   * @param [in] blob Pointer to cache blob, it must be aligned to 4 bytes.
+   * @param [in] size Size of cache blob in bytes
+   * @return 0 on success, otherwise error.
+   * @retval -22(-EINVAL) invalid blob
+   */
+  int attach(const void *blob, size_t size);
+
+  /**
+   * Save cache blob to file
+   *
+   * @param [in] file Destination file
+   * @return 0 on success, otherwise error.
+   */
+  int save(File &file);
+
+  /**
+   * Discard cached network model
+   *
+   * The memory allocated by load() is also released.
+   */
+  void invalidate();
+
+  /**
+   * Return whether the cache holds a validated model
+   */
+  bool valid() {
+    return _valid;
+  }
+
+  /**
+   * Return pointer to cached nnb network model binary
+   *
+   * @return Pointer to network model, or NULL if not valid.
+   */
+  const void *network();
+
+  /**
+   * Return size of cached network model in bytes
+   */
+  size_t size();
+
+private:
+  struct Header {
+    uint32_t magic;
+    uint32_t size;
+    uint32_t crc;
+    uint32_t reserved;
+  };
+
+  Header *_blob;
+  bool    _allocated;
+  bool    _valid;
 };
 
 /** @} dnnrt */
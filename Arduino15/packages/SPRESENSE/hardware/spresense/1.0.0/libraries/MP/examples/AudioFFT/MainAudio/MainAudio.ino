@@ -22,6 +22,7 @@
 #endif
 
 #include <MP.h>
+#include <MPQueue.h>
 #include <Audio.h>
 
 AudioClass *theAudio;
@@ -33,12 +34,19 @@ const int mic_channel_num = 4;
 
 const int subcore = 1;
 
+/* Captured frames are passed to SubCore through the queue */
+
+#define CAPTURE_SAMPLE 768
+#define CAPTURE_NUM    8
+
 struct Capture {
-  void *buff;
-  int  sample;
-  int  chnum;
+  int16_t buff[CAPTURE_SAMPLE * 4];
+  int     sample;
+  int     chnum;
 };
 
+MPQueue<Capture, CAPTURE_NUM> queue;
+
 void setup()
 {
   int ret;
@@ -70,22 +78,27 @@ void setup()
     printf("MP.begin error = %d\n", ret);
   }
 
+  /* Create the queue, and pass it to SubCore */
+  ret = queue.begin();
+  if (ret < 0) {
+    printf("queue.begin error = %d\n", ret);
+  }
+  MP.Send(100, queue.address(), subcore);
+
   Serial.println("Rec start!");
   theAudio->startRecorder();
 }
 
 void loop()
 {
-  int8_t   sndid = 100; /* user-defined msgid */
-  Capture  capture;
+  static Capture capture;
 
-  static const int32_t buffer_sample = 768 * mic_channel_num;
+  static const int32_t buffer_sample = CAPTURE_SAMPLE * mic_channel_num;
   static const int32_t buffer_size = buffer_sample * sizeof(int16_t);
-  static char  buffer[buffer_size];
   uint32_t read_size;
 
   /* Read frames to record in buffer */
-  int err = theAudio->readFrames(buffer, buffer_size, &read_size);
+  int err = theAudio->readFrames((char *)capture.buff, buffer_size, &read_size);
 
   if (err != AUDIOLIB_ECODE_OK && err != AUDIOLIB_ECODE_INSUFFICIENT_BUFFER_AREA) {
     printf("Error err = %d\n", err);
@@ -95,12 +108,14 @@ void loop()
   }
 
   if ((read_size != 0) && (read_size == buffer_size)) {
-    capture.buff   = buffer;
     capture.sample = buffer_sample / mic_channel_num;
     capture.chnum  = mic_channel_num;
-    MP.Send(sndid, &capture, subcore);
+
+    /* The frame is copied into the queue, so the buffer can be reused */
+    if (!queue.push(capture)) {
+      printf("Queue is full\n");
+    }
   } else {
     usleep(1);
   }
 }
-
@@ -22,6 +22,7 @@
 #endif
 
 #include <MP.h>
+#include <MPQueue.h>
 
 /* Use CMSIS library */
 #define ARM_MATH_CM4
@@ -65,12 +66,17 @@ float tmpBuf[FFTLEN];
 
 /* MultiCore definitions */
 
+#define CAPTURE_SAMPLE 768
+#define CAPTURE_NUM    8
+
 struct Capture {
-  void *buff;
-  int  sample;
-  int  chnum;
+  int16_t buff[CAPTURE_SAMPLE * 4];
+  int     sample;
+  int     chnum;
 };
 
+MPQueue<Capture, CAPTURE_NUM> queue;
+
 void setup()
 {
   int ret = 0;
@@ -80,32 +86,42 @@ void setup()
   if (ret < 0) {
     errorLoop(2);
   }
-  /* receive with non-blocking */
-  MP.RecvTimeout(MP_RECV_POLLING);
+
+  /* Receive the queue from MainCore */
+  int8_t msgid;
+  void  *addr;
+  ret = MP.Recv(&msgid, &addr);
+  if ((ret < 0) || (queue.begin(addr) < 0)) {
+    errorLoop(3);
+  }
 }
 
 void loop()
 {
-  int      ret;
-  int8_t   msgid;
   Capture *capture;
+  int      chnum;
 
-  /* Receive PCM captured buffer from MainCore */
-  ret = MP.Recv(&msgid, &capture);
-  if (ret >= 0) {
-    if (capture->chnum == 1) {
-      /* the faster optimization */
-      ringbuf[0].put((q15_t*)capture->buff, capture->sample);
-    } else {
-      int i;
-      for (i = 0; i < capture->chnum; i++) {
-        ringbuf[i].put((q15_t*)capture->buff, capture->sample, capture->chnum, i);
-      }
+  /* Use PCM captured buffer in the queue without copying */
+  if (queue.peek(&capture) == 0) {
+    return;
+  }
+
+  chnum = capture->chnum;
+  if (chnum == 1) {
+    /* the faster optimization */
+    ringbuf[0].put((q15_t*)capture->buff, capture->sample);
+  } else {
+    int i;
+    for (i = 0; i < chnum; i++) {
+      ringbuf[i].put((q15_t*)capture->buff, capture->sample, chnum, i);
     }
   }
 
+  /* Give the buffer back to MainCore */
+  queue.release(1);
+
   while (ringbuf[0].stored() >= FFTLEN) {
-    fft_processing(capture->chnum);
+    fft_processing(chnum);
   }
 }
 
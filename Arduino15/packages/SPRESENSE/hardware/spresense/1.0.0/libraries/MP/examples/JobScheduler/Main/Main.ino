@@ -0,0 +1,93 @@
+/*
+ *  Main.ino - MP Example to run jobs on MainCore and SubCores
+ *  Copyright 2019 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifdef SUBCORE
+#error "Core selection is wrong!!"
+#endif
+
+#include <MP.h>
+#include <MPJob.h>
+
+#define KERNEL_RMS 0
+#define DATA_NUM   4096
+#define BLOCK_SIZE 256
+
+struct Work {
+  int16_t *in;
+  float   *out;
+};
+
+MPJobScheduler scheduler;
+
+int16_t input[DATA_NUM];
+float   output[DATA_NUM / BLOCK_SIZE];
+Work    work = { input, output };
+
+/* Calculate RMS of each block. The same kernel is in SubCores. */
+void rms(void *arg, uint32_t begin, uint32_t end)
+{
+  Work *w = (Work *)arg;
+  float sum = 0.0f;
+
+  for (uint32_t i = begin; i < end; i++) {
+    sum += (float)w->in[i] * w->in[i];
+  }
+  w->out[begin / BLOCK_SIZE] = sqrtf(sum / (end - begin));
+}
+
+void setup()
+{
+  int ret;
+
+  Serial.begin(115200);
+  while (!Serial);
+
+  /* Launch SubCores */
+  MP.begin(1);
+  MP.begin(2);
+
+  scheduler.addKernel(KERNEL_RMS, rms);
+
+  ret = scheduler.begin((1 << 1) | (1 << 2));
+  if (ret < 0) {
+    printf("scheduler.begin error = %d\n", ret);
+  }
+}
+
+void loop()
+{
+  for (int i = 0; i < DATA_NUM; i++) {
+    input[i] = random(-32768, 32767);
+  }
+
+  uint32_t start = micros();
+
+  scheduler.submit(KERNEL_RMS, &work, DATA_NUM, BLOCK_SIZE);
+  scheduler.wait();
+
+  printf("%ld us:", micros() - start);
+  for (int core = 0; core < 3; core++) {
+    uint32_t stolen;
+    uint32_t executed = scheduler.getExecuted(core, &stolen);
+    printf(" core%d %ld(%ld)", core, executed, stolen);
+  }
+  printf("\n");
+
+  delay(1000);
+}
@@ -0,0 +1,80 @@
+/*
+ *  Sub2.ino - MP Example to run jobs on MainCore and SubCores
+ *  Copyright 2019 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#if (SUBCORE != 2)
+#error "Core selection is wrong!!"
+#endif
+
+#include <MP.h>
+#include <MPJob.h>
+
+#define KERNEL_RMS 0
+#define BLOCK_SIZE 256
+
+struct Work {
+  int16_t *in;
+  float   *out;
+};
+
+MPJobScheduler scheduler;
+
+/* Calculate RMS of each block. The same kernel is in MainCore. */
+void rms(void *arg, uint32_t begin, uint32_t end)
+{
+  Work *w = (Work *)arg;
+  float sum = 0.0f;
+
+  for (uint32_t i = begin; i < end; i++) {
+    sum += (float)w->in[i] * w->in[i];
+  }
+  w->out[begin / BLOCK_SIZE] = sqrtf(sum / (end - begin));
+}
+
+void setup()
+{
+  MP.begin();
+
+  scheduler.addKernel(KERNEL_RMS, rms);
+
+  /* Wait for the scheduler from MainCore */
+  if (scheduler.begin() < 0) {
+    errorLoop(2);
+  }
+}
+
+void loop()
+{
+  /* Run jobs until MainCore ends the scheduler */
+  scheduler.run();
+}
+
+void errorLoop(int num)
+{
+  int i;
+
+  while (1) {
+    for (i = 0; i < num; i++) {
+      ledOn(LED0);
+      delay(300);
+      ledOff(LED0);
+      delay(300);
+    }
+    delay(1000);
+  }
+}
@@ -0,0 +1,63 @@
+/*
+ *  Main.ino - MP Example for MP Log Buffer
+ *  Copyright 2019 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifdef SUBCORE
+#error "Core selection is wrong!!"
+#endif
+
+#include <MP.h>
+
+int subcore = 1;
+
+void setup()
+{
+  int ret = 0;
+
+  Serial.begin(115200);
+  while (!Serial);
+
+  /* Buffer MPLog of all cores, and print them from MainCore */
+  ret = MPLogBuf.begin();
+  if (ret < 0) {
+    printf("MPLogBuf.begin() error = %d\n", ret);
+  }
+
+  /* Boot SubCore */
+  ret = MP.begin(subcore);
+  if (ret < 0) {
+    printf("MP.begin(%d) error = %d\n", subcore, ret);
+  }
+}
+
+void loop()
+{
+  static uint32_t count = 0;
+  uint32_t now = millis();
+  uint32_t start = micros();
+
+  MPLog("count=%lu time=%lu.%03lu\n", count, now / 1000, now % 1000);
+
+  /* MPLog only stores the arguments, and returns quickly */
+  uint32_t elapsed = micros() - start;
+
+  MPLog("%s took %lu us\n", "MPLog", elapsed);
+
+  count++;
+  delay(1000);
+}
@@ -0,0 +1,40 @@
+/*
+ *  Sub1.ino - MP Example for MP Log Buffer
+ *  Copyright 2019 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#if (SUBCORE != 1)
+#error "Core selection is wrong!!"
+#endif
+
+#include <MP.h>
+
+void setup()
+{
+  MP.begin();
+}
+
+void loop()
+{
+  static uint32_t count = 0;
+
+  /* Print from MainCore if MPLogBuf is started, or print directly */
+  MPLog("count=%lu value=%d.%02d\n", count, (int)(count / 100), (int)(count % 100));
+
+  count++;
+  delay(100);
+}
@@ -0,0 +1,92 @@
+/*
+ *  Main.ino - MP Example to communicate large data through the bulk channel
+ *  Copyright 2019 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifdef SUBCORE
+#error "Core selection is wrong!!"
+#endif
+
+#include <MP.h>
+
+#define BULK_SIZE (64 * 1024)
+
+int subcore = 1; /* Communication with SubCore1 */
+
+/* Larger than the limit of SendObject() */
+struct Frame {
+  uint32_t seq;
+  int16_t  pcm[768 * 2];
+};
+
+Frame frame;
+
+void setup()
+{
+  int ret = 0;
+
+  Serial.begin(115200);
+  while (!Serial);
+
+  /* Launch SubCore1 */
+  ret = MP.begin(subcore);
+  if (ret < 0) {
+    printf("MP.begin error = %d\n", ret);
+  }
+
+  /* Start the bulk channel */
+  ret = MP.BulkBegin(subcore, BULK_SIZE);
+  if (ret < 0) {
+    printf("MP.BulkBegin error = %d\n", ret);
+  }
+
+  /* Timeout 1000 msec */
+  MP.RecvTimeout(1000);
+}
+
+void loop()
+{
+  int        ret;
+  int8_t     sndid = 100; /* user-defined msgid */
+  int8_t     rcvid;
+  MPBulkSpan span;
+
+  frame.seq++;
+  for (int i = 0; i < 768 * 2; i++) {
+    frame.pcm[i] = (int16_t)(frame.seq + i);
+  }
+
+  /* frame can be modified as soon as SendBulk() returns */
+  ret = MP.SendBulk(sndid, &frame, sizeof(frame), subcore);
+  if (ret < 0) {
+    printf("MP.SendBulk error = %d\n", ret);
+  }
+
+  /* Receive the sum of samples from SubCore */
+  ret = MP.RecvBulk(&rcvid, &span, subcore);
+  if (ret < 0) {
+    printf("MP.RecvBulk error = %d\n", ret);
+    return;
+  }
+
+  int32_t sum = *(int32_t *)span.data;
+  MP.ReleaseBulk(span, subcore);
+
+  printf("Recv: seq=%ld sum=%ld\n", frame.seq, sum);
+
+  delay(1000);
+}
@@ -37,10 +37,11 @@ void loop()
   int cnt = 3;
   int ret;
 
-  /* Busy wait until lock the mutex */
-  do {
-    ret = mutex.Trylock();
-  } while (ret != 0);
+  /* Wait until lock the mutex */
+  ret = mutex.Lock();
+  if (ret != 0) {
+    return;
+  }
 
   /* If the mutex is acquired, blink LED */
   MPLog("Lock\n");
@@ -0,0 +1,76 @@
+/*
+ *  Main.ino - MP Example for SubCore role switching
+ *  Copyright 2019 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifdef SUBCORE
+#error "Core selection is wrong!!"
+#endif
+
+#include <MP.h>
+#include <SDHCI.h>
+
+/* SubCore programs built in advance and saved in the SD card */
+const char *roles[] = {
+  "/mnt/sd0/BIN/fft.elf",
+  "/mnt/sd0/BIN/dnn.elf",
+};
+
+int subcore = 1;
+SDClass SD;
+
+void setup()
+{
+  Serial.begin(115200);
+  while (!Serial);
+
+  while (!SD.begin()) {
+    printf("Insert SD card.\n");
+    delay(1000);
+  }
+
+  /* Copy the programs into the cache on the flash in advance */
+  MP.SetImageCache();
+  for (unsigned int i = 0; i < sizeof(roles) / sizeof(roles[0]); i++) {
+    int ret = MP.CacheImage(roles[i]);
+    if (ret < 0) {
+      printf("MP.CacheImage(%s) error = %d\n", roles[i], ret);
+    }
+  }
+}
+
+void loop()
+{
+  static unsigned int role = 0;
+  uint32_t boot;
+  uint32_t load;
+  int ret;
+
+  /* Switch the role of SubCore */
+  ret = MP.begin(subcore, roles[role]);
+  if (ret < 0) {
+    printf("MP.begin(%d, %s) error = %d\n", subcore, roles[role], ret);
+  } else {
+    load = MP.GetLoadTime(subcore, &boot);
+    printf("%s: load %lu us, boot %lu us\n", roles[role], load, boot);
+  }
+
+  delay(5000);
+
+  MP.end(subcore);
+  role = (role + 1) % (sizeof(roles) / sizeof(roles[0]));
+}
@@ -0,0 +1,75 @@
+/*
+ *  Main.ino - MP Example for MP Shared Heap
+ *  Copyright 2019 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifdef SUBCORE
+#error "Core selection is wrong!!"
+#endif
+
+#include <MP.h>
+#include <MPHeap.h>
+
+#define MSGID_HEAP  1
+#define MSGID_DATA  2
+
+/* Create a MPHeap object */
+MPHeap heap;
+
+int subcore = 1;
+
+void setup()
+{
+  int ret = 0;
+
+  Serial.begin(115200);
+  while (!Serial);
+
+  /* Boot SubCore */
+  ret = MP.begin(subcore);
+  if (ret < 0) {
+    printf("MP.begin(%d) error = %d\n", subcore, ret);
+  }
+
+  /* Create a heap in one shared memory tile */
+  ret = heap.begin(128 * 1024);
+  if (ret < 0) {
+    printf("heap.begin() error = %d\n", ret);
+    return;
+  }
+
+  /* Pass the heap to SubCore */
+  MP.Send(MSGID_HEAP, heap.address(), subcore);
+}
+
+void loop()
+{
+  int8_t msgid;
+  char *str;
+  int used, freeMem, largest;
+
+  /* Receive a buffer allocated by SubCore, and free it on MainCore */
+  if (MP.Recv(&msgid, &str, subcore) < 0) {
+    return;
+  }
+
+  if (msgid == MSGID_DATA) {
+    heap.getInfo(used, freeMem, largest);
+    printf("%s (used=%d free=%d largest=%d)\n", str, used, freeMem, largest);
+    heap.free(str);
+  }
+}
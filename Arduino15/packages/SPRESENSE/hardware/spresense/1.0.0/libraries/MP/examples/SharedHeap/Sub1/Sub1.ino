@@ -0,0 +1,64 @@
+/*
+ *  Sub1.ino - MP Example for MP Shared Heap
+ *  Copyright 2019 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#if (SUBCORE != 1)
+#error "Core selection is wrong!!"
+#endif
+
+#include <MP.h>
+#include <MPHeap.h>
+
+#define MSGID_HEAP  1
+#define MSGID_DATA  2
+
+/* Create a MPHeap object */
+MPHeap heap;
+
+void setup()
+{
+  int8_t msgid;
+  void *addr;
+
+  MP.begin();
+
+  /* Attach to the heap created by MainCore */
+  MP.Recv(&msgid, &addr);
+  if ((msgid != MSGID_HEAP) || (heap.begin(addr) < 0)) {
+    MPLog("Cannot attach to the heap\n");
+  }
+}
+
+void loop()
+{
+  static int count = 0;
+
+  /* Allocate small buffers of various sizes */
+  size_t size = 16 + (count % 8) * 24;
+  char *str = (char *)heap.alloc(size);
+  if (!str) {
+    delay(1000);
+    return;
+  }
+
+  snprintf(str, size, "Hello %d from SubCore (%d bytes)", count, size);
+  MP.Send(MSGID_DATA, str);
+
+  count++;
+  delay(100);
+}
@@ -0,0 +1,84 @@
+/*
+ *  Main.ino - MP Example for MP Trace
+ *  Copyright 2019 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifdef SUBCORE
+#error "Core selection is wrong!!"
+#endif
+
+#include <MP.h>
+
+#define MSGID_WORK  1
+#define MSGID_DONE  2
+#define LOOP_COUNT  100
+
+int subcore = 1;
+
+void setup()
+{
+  int ret = 0;
+
+  Serial.begin(115200);
+  while (!Serial);
+
+  /* Start tracing on all cores */
+  ret = MPTrace.begin();
+  if (ret < 0) {
+    printf("MPTrace.begin() error = %d\n", ret);
+  }
+
+  /* Boot SubCore */
+  ret = MP.begin(subcore);
+  if (ret < 0) {
+    printf("MP.begin(%d) error = %d\n", subcore, ret);
+  }
+}
+
+void loop()
+{
+  static int count = 0;
+  int8_t msgid;
+  uint32_t msgdata;
+
+  if (count == LOOP_COUNT) {
+    /* Print the statistics and the events */
+    MPTrace.stop();
+    MPTrace.report();
+    printf("Save the following JSON, and open it with chrome://tracing\n");
+    MPTrace.exportJson(Serial);
+    MPTrace.end();
+    count++;
+    return;
+  } else if (count > LOOP_COUNT) {
+    return;
+  }
+
+  {
+    MPTRACE_SCOPE("prepare");
+    delayMicroseconds(500);
+  }
+
+  /* Send work to SubCore and wait for the result */
+  MP.Send(MSGID_WORK, count, subcore);
+
+  MPTrace.enter("wait");
+  MP.Recv(&msgid, &msgdata, subcore);
+  MPTrace.leave("wait");
+
+  count++;
+}
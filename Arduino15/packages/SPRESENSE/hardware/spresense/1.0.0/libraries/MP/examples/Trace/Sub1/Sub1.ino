@@ -0,0 +1,50 @@
+/*
+ *  Sub1.ino - MP Example for MP Trace
+ *  Copyright 2019 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#if (SUBCORE != 1)
+#error "Core selection is wrong!!"
+#endif
+
+#include <MP.h>
+
+#define MSGID_WORK  1
+#define MSGID_DONE  2
+
+void setup()
+{
+  MP.begin();
+}
+
+void loop()
+{
+  int8_t msgid;
+  uint32_t msgdata;
+
+  if (MP.Recv(&msgid, &msgdata) < 0) {
+    return;
+  }
+
+  {
+    MPTRACE_SCOPE("work");
+    MPTrace.counter("data", msgdata);
+    delayMicroseconds(1000 + (msgdata % 10) * 100);
+  }
+
+  MP.Send(MSGID_DONE, msgdata);
+}
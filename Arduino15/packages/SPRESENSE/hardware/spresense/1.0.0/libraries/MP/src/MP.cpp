@@ -29,25 +29,171 @@
 #include <armv7-m/nvic.h>
 #include <assert.h>
 #include <nuttx/arch.h>
+#include <sched.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <sys/stat.h>
 #include "MP.h"
 
 /****************************************************************************
  * Pre-processor Definitions
  ****************************************************************************/
 
+#ifndef BACKUP_MEM
 #define BACKUP_MEM 0x04400070
+#endif
 #define MP_MAGIC   0x4d52504d
 
 #define GET_CPU(subid)      ((_rmng->cpu_assign >> ((subid) * 3)) & 7)
 #define SET_CPU(subid, cpu) (((cpu) & 7) << ((subid) * 3))
 #define CLR_CPU(subid)      (7 << ((subid) * 3))
 
+#define BULK_MAGIC 0x4b4c5542
+#define BULK_SHM_ALIGN (128 * 1024)
+#define BULK_ALIGN_UP(x) (((x) + MP_BULK_ALIGN - 1) & ~(MP_BULK_ALIGN - 1))
+
+#define IMAGE_COPY_SIZE  (4096)
+#define IMAGE_CACHE_MAGIC 0x43474d49
+#define IMAGE_CACHE_EXT   ".hdr"
+
+/* Header of each data in the bulk ring buffer */
+
+struct bulk_hdr {
+  uint32_t size;
+  int32_t  msgid;
+};
+
+/* Header of a copy in the image cache, stored in the file of the copy name
+ * and IMAGE_CACHE_EXT. It is written after the copy is completed, so a copy
+ * without the header is never used. image is the full path of the original
+ * file, because the copies of the same file name share the directory.
+ */
+
+struct image_cache_hdr {
+  uint32_t magic;
+  uint32_t size;
+  uint32_t crc;
+  char     image[MP_IMAGE_PATH_LEN];
+};
+
 /****************************************************************************
  * Public Data
  ****************************************************************************/
 
 MPClass MP;
 
+#ifndef SUBCORE
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/* CRC32 (IEEE 802.3) continued from crc. Start with crc = 0. */
+
+static uint32_t image_crc32(uint32_t crc, const uint8_t *buf, size_t len)
+{
+  crc = ~crc;
+  while (len--) {
+    crc ^= *buf++;
+    for (int i = 0; i < 8; i++) {
+      crc = (crc & 1) ? (0xedb88320 ^ (crc >> 1)) : (crc >> 1);
+    }
+  }
+  return ~crc;
+}
+
+static int image_cache_hdrpath(const char *path, char *hpath, size_t size)
+{
+  int n = snprintf(hpath, size, "%s" IMAGE_CACHE_EXT, path);
+
+  return (n < (int)size) ? 0 : -ENAMETOOLONG;
+}
+
+/* Check the copy of image by its header and size. The original image is
+ * not accessed, because stat() on the SD card takes much longer.
+ */
+
+static int image_cache_check(const char *path, const char *image,
+                             struct image_cache_hdr *hdr)
+{
+  char hpath[MP_IMAGE_PATH_LEN];
+  struct stat st;
+  int ret;
+
+  ret = image_cache_hdrpath(path, hpath, sizeof(hpath));
+  if (ret < 0) {
+    return ret;
+  }
+
+  int fd = open(hpath, O_RDONLY);
+  if (fd < 0) {
+    return -ENOENT;
+  }
+  ret = read(fd, hdr, sizeof(*hdr));
+  close(fd);
+
+  if ((ret != sizeof(*hdr)) || (hdr->magic != IMAGE_CACHE_MAGIC) ||
+      (strncmp(hdr->image, image, sizeof(hdr->image)) != 0) ||
+      (stat(path, &st) < 0) || ((uint32_t)st.st_size != hdr->size)) {
+    return -ENOENT;
+  }
+
+  return 0;
+}
+
+static int image_cache_commit(const char *path, const char *image,
+                              uint32_t size, uint32_t crc)
+{
+  char hpath[MP_IMAGE_PATH_LEN];
+  struct image_cache_hdr hdr;
+  int ret;
+
+  ret = image_cache_hdrpath(path, hpath, sizeof(hpath));
+  if (ret < 0) {
+    return ret;
+  }
+
+  memset(&hdr, 0, sizeof(hdr));
+  hdr.magic = IMAGE_CACHE_MAGIC;
+  hdr.size = size;
+  hdr.crc = crc;
+  strncpy(hdr.image, image, sizeof(hdr.image) - 1);
+
+  int fd = open(hpath, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if (fd < 0) {
+    return -errno;
+  }
+  ret = write(fd, &hdr, sizeof(hdr));
+  close(fd);
+
+  if (ret != sizeof(hdr)) {
+    unlink(hpath);
+    return -EIO;
+  }
+
+  return 0;
+}
+
+/* CRC32 of a whole file */
+
+static int image_file_crc(const char *image, char *buf, uint32_t *crc)
+{
+  int fd = open(image, O_RDONLY);
+  if (fd < 0) {
+    return -errno;
+  }
+
+  ssize_t n;
+  *crc = 0;
+  while ((n = read(fd, buf, IMAGE_COPY_SIZE)) > 0) {
+    *crc = image_crc32(*crc, (const uint8_t *)buf, n);
+  }
+  close(fd);
+
+  return (n < 0) ? -EIO : 0;
+}
+#endif /* !SUBCORE */
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -55,10 +201,18 @@ MPClass MP;
 MPClass::MPClass() : _recvTimeout(MP_RECV_BLOCKING)
 {
   memset(_mq, 0, sizeof(_mq));
+  memset(_bulk, 0, sizeof(_bulk));
+#ifdef SUBCORE
+  memset(_v2p, 0, sizeof(_v2p));
+#endif
   _rmng = (struct ResourceManagement*)BACKUP_MEM;
 #ifndef SUBCORE
   memset(_rmng, 0, sizeof(ResourceManagement));
   _rmng->magic = MP_MAGIC;
+  memset(_cycoffset, 0, sizeof(_cycoffset));
+  memset(_loadtime, 0, sizeof(_loadtime));
+  memset(_boottime, 0, sizeof(_boottime));
+  _cachedir = NULL;
   sq_init(&_shmlist);
 #endif
 }
@@ -70,14 +224,20 @@ int MPClass::begin()
 
   ret = mpmq_init(&_mq[0], KEY_MQ, 2);
   if (ret == 0) {
-    /* boot complete */
-    ret = mpmq_send(&_mq[0], 0, 0);
+    /* boot complete with the cycle counter to align the trace */
+    MP_ENABLE_CYCCNT();
+    ret = mpmq_send(&_mq[0], 0, MP_GET_CYCCNT());
   }
 
   return ret;
 }
 #else /* MAINCORE */
 int MPClass::begin(int subid)
+{
+  return begin(subid, NULL);
+}
+
+int MPClass::begin(int subid, const char *image)
 {
   int ret = 0;
 
@@ -90,11 +250,19 @@ int MPClass::begin(int subid)
   while (g_rtc_enabled == false);
 
   if (ret == -ENODEV) {
-    ret = load(subid);
+    uint32_t start = micros();
+    ret = load(subid, image);
+    _loadtime[subid] = micros() - start;
     if (ret == 0) {
       uint32_t data;
       /* wait until boot complete */
+      start = micros();
+      MP_ENABLE_CYCCNT();
       ret = mpmq_timedreceive(&_mq[subid], &data, 1000);
+      if (ret >= 0) {
+        _cycoffset[subid] = MP_GET_CYCCNT() - data;
+      }
+      _boottime[subid] = micros() - start;
     }
   }
   return ret;
@@ -117,6 +285,8 @@ int MPClass::end(int subid)
     return ret;
   }
 
+  BulkEnd(subid);
+
   ret = unload(subid);
 
   return ret;
@@ -143,6 +313,8 @@ int MPClass::Send(int8_t msgid, uint32_t msgdata, int subid)
     return ret;
   }
 
+  MPTrace.message(true, msgid, subid);
+
   return ret;
 }
 
@@ -164,6 +336,8 @@ int MPClass::Recv(int8_t *msgid, uint32_t *msgdata, int subid)
 
   *msgid = (int8_t)ret;
 
+  MPTrace.message(false, *msgid, subid);
+
   return ret;
 }
 
@@ -175,7 +349,16 @@ int MPClass::Send(int8_t msgid, void *msgaddr, int subid)
 
 int MPClass::Recv(int8_t *msgid, void *msgaddr, int subid)
 {
-  return Recv(msgid, (uint32_t*)msgaddr, subid);
+  uint32_t data;
+  int ret;
+
+  /* Store as a pointer, which is not 32-bit on the host simulation */
+  ret = Recv(msgid, &data, subid);
+  if (ret >= 0) {
+    *(void **)msgaddr = (void *)data;
+  }
+
+  return ret;
 }
 
 // send/receive message object
@@ -194,6 +377,276 @@ int MPClass::SendWaitComplete(int subid)
   return ret;
 }
 
+// bulk channel
+#ifdef SUBCORE
+int MPClass::BulkBegin(int subid)
+{
+  int ret;
+  int8_t msgid;
+  uint32_t addr;
+
+  ret = checkid(subid);
+  if (ret) {
+    return ret;
+  }
+
+  /* Bulk channel is only with MainCore */
+  if (subid != 0) {
+    return -EINVAL;
+  }
+
+  if (_bulk[subid]) {
+    return -EBUSY;
+  }
+
+  /* Wait for the shared memory from MainCore */
+  ret = Recv(&msgid, &addr, subid);
+  if (ret < 0) {
+    return ret;
+  }
+
+  BulkRing *ring = (BulkRing *)addr;
+  if ((msgid != MP_BULK_MSGID) || !ring || (ring->magic != BULK_MAGIC)) {
+    MPDBG("bulk setup error: msgid=%d addr=%08lx\n", msgid, addr);
+    return -EPROTO;
+  }
+
+  _bulk[subid] = ring;
+
+  return 0;
+}
+#else /* MAINCORE */
+int MPClass::BulkBegin(int subid, size_t size)
+{
+  int ret;
+
+  ret = checkid(subid);
+  if (ret) {
+    return ret;
+  }
+
+  if (_bulk[subid]) {
+    return -EBUSY;
+  }
+
+  if (size == 0) {
+    return -EINVAL;
+  }
+
+  /* Use all of the shared memory aligned up */
+  uint32_t total = 2 * sizeof(BulkRing) + 2 * BULK_ALIGN_UP(size);
+  total = (total + BULK_SHM_ALIGN - 1) & ~(BULK_SHM_ALIGN - 1);
+
+  BulkRing *ring = (BulkRing *)AllocSharedMemory(total);
+  if (!ring) {
+    return -ENOMEM;
+  }
+
+  uint32_t ringsize = ((total - 2 * sizeof(BulkRing)) / 2) & ~(MP_BULK_ALIGN - 1);
+
+  for (int i = 0; i < 2; i++) {
+    ring[i].magic = BULK_MAGIC;
+    ring[i].size  = ringsize;
+    ring[i].head  = 0;
+    ring[i].tail  = 0;
+    ring[i].data  = (uint32_t)(uintptr_t)&ring[2] + (i * ringsize);
+  }
+  MP_DMB();
+
+  ret = mpmq_send(&_mq[subid], MP_BULK_MSGID, (uint32_t)(uintptr_t)ring);
+  if (ret < 0) {
+    MPDBG("mpmq_send() failure. %d\n", ret);
+    FreeSharedMemory(ring);
+    return ret;
+  }
+
+  _bulk[subid] = ring;
+
+  return 0;
+}
+#endif
+
+int MPClass::BulkEnd(int subid)
+{
+  int ret;
+
+  ret = checkbulk(subid);
+  if (ret) {
+    return ret;
+  }
+
+#ifndef SUBCORE
+  FreeSharedMemory(_bulk[subid]);
+#endif
+  _bulk[subid] = NULL;
+
+  return 0;
+}
+
+int MPClass::SendBulk(int8_t msgid, const void *data, size_t size, int subid)
+{
+  int ret;
+
+  ret = checkbulk(subid);
+  if (ret) {
+    return ret;
+  }
+
+  /* msgid must be 0 or positive value */
+  assert(0 <= msgid);
+
+  if (!data && size) {
+    return -EINVAL;
+  }
+
+  BulkRing *ring = bulkring(subid, true);
+  uint32_t n    = ring->size;
+  uint32_t len  = BULK_ALIGN_UP(sizeof(bulk_hdr) + size);
+
+  if (len > n) {
+    return -EMSGSIZE;
+  }
+
+  uint32_t head = ring->head;
+  uint32_t tail = ring->tail;
+  uint32_t used = (head >= tail) ? (head - tail) : (head + 2 * n - tail);
+
+  /* All data are released, so the receiver does not write tail until the
+   * next data. Restart from the top of the buffer, where any data up to
+   * the size fits.
+   */
+  if ((used == 0) && (head != 0)) {
+    head = 0;
+    ring->tail = 0;
+    MP_DMB();
+    ring->head = 0;
+  }
+
+  uint32_t pos  = (head >= n) ? (head - n) : head;
+
+  /* Data must be contiguous. Skip the end of buffer if it does not fit. */
+  uint32_t skip = (pos + len > n) ? (n - pos) : 0;
+
+  if (used + skip + len > n) {
+    return -EAGAIN;
+  }
+
+  uint32_t start = (head + skip) % (2 * n);
+  pos = (start >= n) ? (start - n) : start;
+
+  bulk_hdr *hdr = (bulk_hdr *)(ring->data + pos);
+  hdr->size  = size;
+  hdr->msgid = msgid;
+  memcpy(hdr + 1, data, size);
+
+  /* Publish the data before the position */
+  MP_DMB();
+  ring->head = (start + len) % (2 * n);
+
+  ret = mpmq_send(&_mq[subid], msgid, start);
+  if (ret < 0) {
+    MPDBG("mpmq_send() failure. %d\n", ret);
+    /* Receiver never knows it, so take it back */
+    ring->head = head;
+    return ret;
+  }
+
+  return ret;
+}
+
+int MPClass::RecvBulk(int8_t *msgid, MPBulkSpan *span, int subid)
+{
+  int ret;
+  uint32_t start;
+
+  ret = checkbulk(subid);
+  if (ret) {
+    return ret;
+  }
+
+  if (!msgid || !span) {
+    return -EINVAL;
+  }
+
+  ret = Recv(msgid, &start, subid);
+  if (ret < 0) {
+    return ret;
+  }
+
+  BulkRing *ring = bulkring(subid, false);
+  uint32_t n     = ring->size;
+
+  if (start >= 2 * n) {
+    MPDBG("bulk position error: %ld\n", start);
+    return -EINVAL;
+  }
+
+  uint32_t pos  = (start >= n) ? (start - n) : start;
+  bulk_hdr *hdr = (bulk_hdr *)(ring->data + pos);
+
+  if ((hdr->msgid != *msgid) || (pos + sizeof(bulk_hdr) + hdr->size > n)) {
+    MPDBG("bulk header error: msgid=%d size=%ld\n", *msgid, hdr->size);
+    return -EINVAL;
+  }
+
+  span->data = hdr + 1;
+  span->size = hdr->size;
+  span->next = (start + BULK_ALIGN_UP(sizeof(bulk_hdr) + hdr->size)) % (2 * n);
+
+  return ret;
+}
+
+int MPClass::ReleaseBulk(MPBulkSpan &span, int subid)
+{
+  int ret;
+
+  ret = checkbulk(subid);
+  if (ret) {
+    return ret;
+  }
+
+  BulkRing *ring = bulkring(subid, false);
+
+  if (span.next >= 2 * ring->size) {
+    return -EINVAL;
+  }
+
+  /* Finish reading the data before the sender overwrites it */
+  MP_DMB();
+  ring->tail = span.next;
+
+  span.data = NULL;
+  span.size = 0;
+
+  return 0;
+}
+
+int MPClass::SendBulkWaitComplete(int subid)
+{
+  int ret;
+
+  ret = checkbulk(subid);
+  if (ret) {
+    return ret;
+  }
+
+  BulkRing *ring = bulkring(subid, true);
+  uint32_t start = millis();
+
+  while (ring->tail != ring->head) {
+    if (_recvTimeout == MP_RECV_POLLING) {
+      return -EAGAIN;
+    }
+    if ((_recvTimeout != MP_RECV_BLOCKING) &&
+        ((millis() - start) >= _recvTimeout)) {
+      return -ETIMEDOUT;
+    }
+    sched_yield();
+  }
+
+  return 0;
+}
+
 // receive timeout
 void MPClass::RecvTimeout(uint32_t timeout)
 {
@@ -212,13 +665,20 @@ uint32_t MPClass::Virt2Phys(void *virt)
   uint32_t reg;
   int8_t tag;
 
-  va = (uint32_t)virt >> 16;
+  va = (uint32_t)(uintptr_t)virt >> 16;
   if (va & 0x0ff0)
     {
-      return (uint32_t)virt;
+      return (uint32_t)(uintptr_t)virt;
     }
   tag = va & 0xf;
 
+#ifdef SUBCORE
+  /* The address conversion of this SubCore is fixed after boot */
+  if (_v2p[tag]) {
+    return _v2p[tag] | ((uint32_t)(uintptr_t)virt & 0xffff);
+  }
+#endif
+
   uint32_t cpuid = MP_GET_CPUID() - 2;
 
   reg = CXD56_ADR_CONV_BASE + (cpuid * 0x20) + 4;
@@ -230,7 +690,11 @@ uint32_t MPClass::Virt2Phys(void *virt)
     }
   pa = (pa & 0x01ff0000u) | ((pa & 0x06000000) << 1);
 
-  return pa | ((uint32_t)virt & 0xffff);
+#ifdef SUBCORE
+  _v2p[tag] = pa;
+#endif
+
+  return pa | ((uint32_t)(uintptr_t)virt & 0xffff);
 }
 
 #define APPDSP_RAMMODE_STAT0 0x04104420
@@ -325,7 +789,7 @@ void MPClass::FreeSharedMemory(void *addr)
 {
   sq_entry_t *entry;
   for (entry = sq_peek(&_shmlist); entry; entry = sq_next(entry)) {
-    if (((shm_entry *)entry)->addr == (uint32_t)addr) {
+    if (((shm_entry *)entry)->addr == (uint32_t)(uintptr_t)addr) {
       sq_rem(entry, &_shmlist);
       break;
     }
@@ -337,6 +801,116 @@ void MPClass::FreeSharedMemory(void *addr)
     free(node);
   }
 }
+
+void MPClass::SetImageCache(const char *dir)
+{
+  _cachedir = dir;
+}
+
+int MPClass::CacheImage(const char *image)
+{
+  struct stat src;
+  struct image_cache_hdr hdr;
+  char path[MP_IMAGE_PATH_LEN];
+  char hpath[MP_IMAGE_PATH_LEN];
+  uint32_t crc = 0;
+  int ret;
+
+  if (!_cachedir) {
+    return -ENODEV;
+  }
+
+  if (!image) {
+    return -EINVAL;
+  }
+
+  ret = cachepath(image, path, sizeof(path));
+  if (ret < 0) {
+    return ret;
+  }
+
+  ret = image_cache_hdrpath(path, hpath, sizeof(hpath));
+  if (ret < 0) {
+    return ret;
+  }
+
+  if (stat(image, &src) < 0) {
+    return -errno;
+  }
+
+  char *buf = (char *)malloc(IMAGE_COPY_SIZE);
+  if (!buf) {
+    return -ENOMEM;
+  }
+
+  /* Already cached. The time of the file is not used, because some file
+   * systems such as SmartFS do not keep it.
+   */
+  if ((image_cache_check(path, image, &hdr) == 0) &&
+      (hdr.size == (uint32_t)src.st_size) &&
+      (image_file_crc(image, buf, &crc) == 0) && (hdr.crc == crc)) {
+    free(buf);
+    return 0;
+  }
+
+  /* Invalidate the copy before it is overwritten */
+  unlink(hpath);
+  mkdir(_cachedir, 0777);
+
+  uint32_t size = 0;
+  crc = 0;
+
+  int in = open(image, O_RDONLY);
+  int out = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if ((in < 0) || (out < 0)) {
+    ret = -errno;
+    MPDBG("Cannot open %s. %d\n", (in < 0) ? image : path, ret);
+  } else {
+    ssize_t n;
+    while ((n = read(in, buf, IMAGE_COPY_SIZE)) > 0) {
+      if (write(out, buf, n) != n) {
+        n = -1;
+        break;
+      }
+      crc = image_crc32(crc, (const uint8_t *)buf, n);
+      size += n;
+    }
+    if (n < 0) {
+      ret = -EIO;
+      MPDBG("Cannot copy %s to %s\n", image, path);
+    }
+  }
+
+  if (in >= 0) {
+    close(in);
+  }
+  if (out >= 0) {
+    close(out);
+    if (ret == 0) {
+      ret = image_cache_commit(path, image, size, crc);
+    }
+    if (ret < 0) {
+      unlink(path);
+    }
+  }
+
+  free(buf);
+
+  return ret;
+}
+
+uint32_t MPClass::GetLoadTime(int subid, uint32_t *boot)
+{
+  if ((subid <= 0) || (MP_MAX_SUBID <= subid)) {
+    return 0;
+  }
+
+  if (boot) {
+    *boot = _boottime[subid];
+  }
+
+  return _loadtime[subid];
+}
 #endif /* !SUBCORE */
 
 /****************************************************************************
@@ -395,18 +969,57 @@ int MPClass::checkid(int subid)
 }
 #endif
 
+int MPClass::checkbulk(int subid)
+{
+  int ret;
+
+  ret = checkid(subid);
+  if (ret) {
+    return ret;
+  }
+
+  if (!_bulk[subid]) {
+    return -EINVAL;
+  }
+
+  return 0;
+}
+
+MPClass::BulkRing *MPClass::bulkring(int subid, bool tx)
+{
+  /* [0] is MainCore to SubCore, [1] is SubCore to MainCore */
+#ifdef SUBCORE
+  return &_bulk[subid][tx ? 1 : 0];
+#else
+  return &_bulk[subid][tx ? 0 : 1];
+#endif
+}
+
 #ifndef SUBCORE
-int MPClass::load(int subid)
+int MPClass::load(int subid, const char *image)
 {
   int ret;
   char filename[5];
+  char path[MP_IMAGE_PATH_LEN];
   cpuid_t cpu;
 
-  snprintf(filename, sizeof(filename), "sub%d", subid);
-
   /* Initialize MP task */
 
-  ret = mptask_init_secure(&_mptask[subid], filename);
+  if (image) {
+    /* Load the ELF file, from the cache if possible. A valid copy is used
+     * without accessing the original image.
+     */
+    struct image_cache_hdr hdr;
+    if (_cachedir && (cachepath(image, path, sizeof(path)) == 0) &&
+        ((image_cache_check(path, image, &hdr) == 0) ||
+         (CacheImage(image) == 0))) {
+      image = path;
+    }
+    ret = mptask_init(&_mptask[subid], image);
+  } else {
+    snprintf(filename, sizeof(filename), "sub%d", subid);
+    ret = mptask_init_secure(&_mptask[subid], filename);
+  }
 
   if (ret != 0) {
     MPDBG("mptask_init() failure. %d\n", ret);
@@ -459,5 +1072,27 @@ int MPClass::unload(int subid)
 
   return ret;
 }
+
+/* The copy is named by the file name and the hash of the full path, so the
+ * files of the same name in different directories have their own copies.
+ */
+
+int MPClass::cachepath(const char *image, char *path, size_t size)
+{
+  const char *name = strrchr(image, '/');
+  size_t len = strlen(image);
+  int n;
+
+  /* The full path must fit in the header of the copy */
+  if (len >= MP_IMAGE_PATH_LEN) {
+    return -ENAMETOOLONG;
+  }
+
+  name = name ? (name + 1) : image;
+  n = snprintf(path, size, "%s/%s.%08lx", _cachedir, name,
+               (unsigned long)image_crc32(0, (const uint8_t *)image, len));
+
+  return (n < (int)size) ? 0 : -ENAMETOOLONG;
+}
 #endif
 
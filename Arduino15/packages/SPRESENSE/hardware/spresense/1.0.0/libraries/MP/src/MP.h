@@ -69,10 +69,43 @@
 #define MP_RECV_BLOCKING    (0)
 #define MP_RECV_POLLING     (MPMQ_NONBLOCK)
 
+/* Hardware access. These can be predefined to run on other than the
+ * CXD5602, such as tools/mpsim.
+ */
+#ifndef MP_GET_CPUID
 #define MP_GET_CPUID()      (*(volatile int *)0x4e002040)
+#endif
+
+#ifndef MP_DMB
+#define MP_DMB()            __asm__ __volatile__ ("dmb" ::: "memory")
+#endif
+
+/* DWT cycle counter of each core */
+#ifndef MP_GET_CYCCNT
+#define MP_DEMCR            (*(volatile uint32_t *)0xe000edfc)
+#define MP_DWT_CTRL         (*(volatile uint32_t *)0xe0001000)
+#define MP_GET_CYCCNT()     (*(volatile uint32_t *)0xe0001004)
+#define MP_ENABLE_CYCCNT()  do { \
+  MP_DEMCR |= (1 << 24); /* TRCENA */ \
+  MP_DWT_CTRL |= 1;      /* CYCCNTENA */ \
+} while (0)
+#endif
 
 #define MP_MAX_SUBID 6
 
+/* msgid reserved by the MP library. A sketch using the feature must not
+ * send the msgid for other purposes.
+ */
+#define MP_BULK_MSGID       (127) /* msgid to set up the bulk channel */
+#define MPJOB_MSGID         (126) /* msgid to wake up the MPJob worker */
+
+/* MP Bulk transfer */
+#define MP_BULK_ALIGN       (8)
+
+/* MP SubCore image cache */
+#define MP_IMAGE_CACHE_DIR  "/mnt/spif/mpcache"
+#define MP_IMAGE_PATH_LEN   (64)
+
 /* MP Log utility */
 #if   (SUBCORE == 1)
 #define MPLOG_PREFIX "[Sub1] "
@@ -88,17 +121,34 @@
 #define MPLOG_PREFIX "[Main] "
 #endif
 
+/* Buffered by MPLogBuf after MPLogBuf.begin() on MainCore.
+ * The arguments are evaluated only once in both ways.
+ */
 #define MPLog(fmt, ...) do { \
+  if (MPLogBuf.active()) { \
+    MPLogBuf.write(fmt, ##__VA_ARGS__); \
+  } else { \
     irqstate_t flags; \
     flags = printlock(); \
     sync_printf(MPLOG_PREFIX fmt, ##__VA_ARGS__); \
     printunlock(flags); \
+  } \
 } while (0)
 
 /****************************************************************************
  * class declaration
  ****************************************************************************/
 
+/**
+ * @struct MPBulkSpan
+ * @brief Payload received by RecvBulk(), which points into the shared memory.
+ */
+struct MPBulkSpan {
+  void     *data; /**< pointer to the payload */
+  uint32_t size;  /**< size of the payload [byte] */
+  uint32_t next;  /**< internal use */
+};
+
 /**
  * @class MPClass
  * @brief This is the interface for MP (Multi-Processor).
@@ -125,6 +175,22 @@ public:
   int begin();
 #else
   int begin(int subid);
+
+  /**
+   * @brief Start the SubCore with the specified program
+   * @param [in] subid - SubCore number(1~5) launched from MainCore.
+   * @param [in] image - path of the SubCore ELF file such as
+   *                     "/mnt/sd0/fft.elf". If NULL, same as begin(subid).
+   * @return error code. It returns minus value on failure.
+   * @retval -22(-EINVAL) Invalid argument
+   * @retval -2(-ENOENT) No such SubCore program
+   * @retval -116(-ETIMEDOUT) No response of boot completion from SubCore
+   * @details Each SubCore number can run different programs in turn by
+   *          end(subid) and begin(subid, image). If the image cache is
+   *          enabled by SetImageCache(), the program is loaded from the copy
+   *          in the cache.
+   */
+  int begin(int subid, const char *image);
 #endif
 
   /**
@@ -144,7 +210,8 @@ public:
 
   /**
    * @brief Send any 32bit-data to the other processor
-   * @param [in] msgid - user-defined message ID (0~127)
+   * @param [in] msgid - user-defined message ID (0~127), except the
+   *                     msgid reserved for the features in use
    *                     It must be zero or positive value.
    * @param [in] msgdata - user-defined message data (32bit)
    * @param [in] subid - SubCore number(1~5) to send any message.
@@ -178,7 +245,8 @@ public:
 
   /**
    * @brief Send the address of any message to the other processor
-   * @param [in] msgid - user-defined message ID (0~127)
+   * @param [in] msgid - user-defined message ID (0~127), except the
+   *                     msgid reserved for the features in use
    *                     It must be zero or positive value.
    * @param [in] msgaddr - pointer to user-defined message address
    * @param [in] subid - SubCore number(1~5) to send any message.
@@ -219,6 +287,7 @@ public:
    * @retval -22(-EINVAL) Invalid argument
    * @retval -19(-ENODEV) No such SubCore program
    * @details The size of object must be 128 bytes or less.
+   *          For a larger object, use SendBulk().
    */
 #ifdef SUBCORE
   template <typename T> int SendObject(T &t, int subid = 0);
@@ -259,6 +328,120 @@ public:
   int SendWaitComplete(int subid);
 #endif
 
+  /**
+   * @brief Start the bulk channel with the other processor
+   * @param [in] subid - SubCore number(1~5) to communicate.
+   *                     If core is SubCore, communicate with MainCore by default.
+   * @param [in] size - size of the ring buffer for each direction [byte].
+   *                    (MainCore only)
+   * @return error code. It returns minus value on failure.
+   * @retval -22(-EINVAL) Invalid argument
+   * @retval -19(-ENODEV) No such SubCore program
+   * @retval -12(-ENOMEM) Out of shared memory
+   * @retval -16(-EBUSY) Already started
+   * @retval -71(-EPROTO) Unexpected message from MainCore
+   * @details MainCore allocates a shared memory for two ring buffers, and
+   *          notifies it to SubCore. The size is aligned up so that all of
+   *          the allocated shared memory is used.
+   *          SubCore waits for the notification, so call this API before any
+   *          other messages are sent from MainCore.
+   */
+#ifdef SUBCORE
+  int BulkBegin(int subid = 0);
+#else
+  int BulkBegin(int subid, size_t size);
+#endif
+
+  /**
+   * @brief End the bulk channel with the other processor
+   * @param [in] subid - SubCore number(1~5) to communicate.
+   *                     If core is SubCore, communicate with MainCore by default.
+   * @return error code. It returns minus value on failure.
+   * @retval -22(-EINVAL) Invalid argument
+   * @details MainCore frees the shared memory of the bulk channel.
+   */
+#ifdef SUBCORE
+  int BulkEnd(int subid = 0);
+#else
+  int BulkEnd(int subid);
+#endif
+
+  /**
+   * @brief Send any size of data through the bulk channel
+   * @param [in] msgid - user-defined message ID (0~127), except the
+   *                     msgid reserved for the features in use
+   *                     It must be zero or positive value.
+   * @param [in] data - pointer to the data
+   * @param [in] size - size of the data [byte]
+   * @param [in] subid - SubCore number(1~5) to send any message.
+   *                     If core is SubCore, send to MainCore by default.
+   * @return error code. It returns minus value on failure.
+   * @retval -22(-EINVAL) Invalid argument or bulk channel not started
+   * @retval -19(-ENODEV) No such SubCore program
+   * @retval -90(-EMSGSIZE) Data is larger than the ring buffer
+   * @retval -11(-EAGAIN) Not enough free space in the ring buffer now
+   * @details The data is copied into the ring buffer, and only its position
+   *          is sent as the message. So the data can be reused as soon as
+   *          this API returns. To wait until the receiver releases all of the
+   *          data, call SendBulkWaitComplete(). When all of the data are
+   *          released, data up to the size of the ring buffer can be sent.
+   */
+#ifdef SUBCORE
+  int SendBulk(int8_t msgid, const void *data, size_t size, int subid = 0);
+#else
+  int SendBulk(int8_t msgid, const void *data, size_t size, int subid);
+#endif
+
+  /**
+   * @brief Receive data from the bulk channel without copying
+   * @param [out] msgid - pointer to user-defined message ID
+   * @param [out] span - pointer to the received payload
+   * @param [in] subid - SubCore number(1~5) to receive any message.
+   *                     If core is SubCore, receive from MainCore by default.
+   * @return msgid or error code. It returns minus value on failure.
+   * @retval -22(-EINVAL) Invalid argument or bulk channel not started
+   * @retval -19(-ENODEV) No such SubCore program
+   * @retval -116(-ETIMEDOUT) Timeout to receive from other core
+   * @details The payload stays in the ring buffer until ReleaseBulk() is
+   *          called. Release payloads in the received order.
+   *          The message sent by SendBulk() must be received by this API.
+   */
+#ifdef SUBCORE
+  int RecvBulk(int8_t *msgid, MPBulkSpan *span, int subid = 0);
+#else
+  int RecvBulk(int8_t *msgid, MPBulkSpan *span, int subid);
+#endif
+
+  /**
+   * @brief Release the payload received by RecvBulk()
+   * @param [in] span - payload to release
+   * @param [in] subid - SubCore number(1~5) to receive any message.
+   *                     If core is SubCore, receive from MainCore by default.
+   * @return error code. It returns minus value on failure.
+   * @retval -22(-EINVAL) Invalid argument or bulk channel not started
+   */
+#ifdef SUBCORE
+  int ReleaseBulk(MPBulkSpan &span, int subid = 0);
+#else
+  int ReleaseBulk(MPBulkSpan &span, int subid);
+#endif
+
+  /**
+   * @brief Wait for all of the data sent by SendBulk() to be released
+   * @param [in] subid - SubCore number(1~5) to send any message.
+   *                     If core is SubCore, send to MainCore by default.
+   * @return error code. It returns minus value on failure.
+   * @retval -22(-EINVAL) Invalid argument or bulk channel not started
+   * @retval -11(-EAGAIN) Not released yet with MP_RECV_POLLING
+   * @retval -116(-ETIMEDOUT) Timeout to wait
+   * @details The timeout is the same as the receiver set by RecvTimeout().
+   */
+#ifdef SUBCORE
+  int SendBulkWaitComplete(int subid = 0);
+#else
+  int SendBulkWaitComplete(int subid);
+#endif
+
   /**
    * @brief Set timeout of receiver
    * @param [in] timeout - waiting time [msec] for reception.
@@ -315,22 +498,79 @@ public:
    * @param [in] addr - address allocated by AllocSharedMemory().
    */
   void FreeSharedMemory(void *addr);
+
+  /**
+   * @brief Enable the SubCore image cache
+   * @param [in] dir - directory on a fast storage to cache ELF files.
+   *                   If NULL, disable the cache.
+   * @details A RAM file system is the fastest if it is available.
+   */
+  void SetImageCache(const char *dir = MP_IMAGE_CACHE_DIR);
+
+  /**
+   * @brief Copy the SubCore ELF file into the image cache in advance
+   * @param [in] image - path of the SubCore ELF file
+   * @return error code. It returns minus value on failure.
+   * @retval -19(-ENODEV) The image cache is not enabled
+   * @details The copy is named by the file name and the hash of the full
+   *          path, and its header keeps the full path. The copy is updated
+   *          when the size or the CRC of the file is changed. begin(subid, image) uses a valid copy without
+   *          accessing the file, so call this function after the file is
+   *          updated.
+   */
+  int CacheImage(const char *image);
+
+  /**
+   * @brief Get the time to start the SubCore by the last begin(subid)
+   * @param [in] subid - SubCore number(1~5)
+   * @param [out] boot - time from loading to the boot completion [usec]
+   * @return time to load the program [usec]
+   */
+  uint32_t GetLoadTime(int subid, uint32_t *boot = NULL);
 #endif
 
 private:
+  friend class MPLogBuffer;
+  friend class MPTracer;
+
   uint32_t _recvTimeout;
   mpmq_t   _mq[MP_MAX_SUBID];
   struct ResourceManagement {
     uint32_t magic;
     uint32_t cpu_assign;
-    uint32_t reserved[2];
-    uint32_t resource[4];
+    uint32_t logbuf; /* physical address of the MPLogBuf */
+    uint32_t trace;  /* physical address of the MPTrace */
+    volatile uint8_t logwriting[8]; /* MPLogBuf.write() in progress per core */
+    uint32_t resource[2];
   } *_rmng;
 
+  /* Ring buffer of the bulk channel in the shared memory.
+   * head and tail run over [0, size * 2) to tell full from empty.
+   */
+  struct BulkRing {
+    uint32_t magic;
+    uint32_t size;
+    volatile uint32_t head;
+    volatile uint32_t tail;
+    uint32_t data;
+    uint32_t reserved[3];
+  } *_bulk[MP_MAX_SUBID];
+
+#ifdef SUBCORE
+  uint32_t _v2p[16]; /* physical address of each 64KByte virtual page */
+#endif
+
   int checkid(int subid);
+  int checkbulk(int subid);
+  BulkRing *bulkring(int subid, bool tx);
 #ifndef SUBCORE
+  uint32_t _cycoffset[MP_MAX_SUBID]; /* cycle counter of MainCore - SubCore */
+  uint32_t _loadtime[MP_MAX_SUBID];
+  uint32_t _boottime[MP_MAX_SUBID];
+  const char *_cachedir;
   mptask_t _mptask[MP_MAX_SUBID];
-  int load(int subid);
+  int load(int subid, const char *image);
+  int cachepath(const char *image, char *path, size_t size);
   int unload(int subid);
   sq_queue_t _shmlist;
   struct shm_entry {
@@ -384,7 +624,7 @@ template <typename T> int MPClass::RecvObject(T &t, int subid)
     return -EINVAL;
   }
 
-  ret = Recv(&rsz, (uint32_t*)&vp, subid);
+  ret = Recv(&rsz, &vp, subid);
 
   if ((ret <= 0) || (msgsz != ret)) {
     MPDBG("Recv(&object) failure. %d\n", ret);
@@ -411,4 +651,7 @@ extern MPClass MP;
 
 /** @} mp */
 
+#include "MPLog.h"
+#include "MPTrace.h"
+
 #endif /* _MP_H_ */
@@ -0,0 +1,289 @@
+/*
+ *  MPHeap.cpp - Spresense Arduino Multi-Processer Shared Heap library
+ *  Copyright 2019 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <sdk/config.h>
+#include <stdio.h>
+#include "MPHeap.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define HEAP_MAGIC  0x5048504d
+#define SHM_ALIGN   (128 * 1024)
+
+/* Page map entries. 1 to MPHEAP_CLASS_NUM are the size class + 1. */
+#define PAGE_FREE   0x0000
+#define PAGE_CONT   0x4000 /* following page of a large buffer */
+#define PAGE_LARGE  0x8000 /* first page of a large buffer | number of pages */
+#define PAGE_META   0xffff /* heap header and page map */
+#define PAGE_NUM(e) ((e) & 0x3fff)
+
+#define CLASS_SIZE(c) (MPHEAP_MIN_SIZE << (c))
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+MPHeap::MPHeap(const char *devname)
+  : _heap(NULL), _allocated(false), _mutex(devname)
+{
+}
+
+#ifndef SUBCORE
+int MPHeap::begin(size_t size)
+{
+  if (_heap || (size == 0)) {
+    return -EINVAL;
+  }
+
+  /* Use the whole tiles */
+  size = (size + SHM_ALIGN - 1) & ~(SHM_ALIGN - 1);
+
+  void *addr = MP.AllocSharedMemory(size);
+  if (!addr) {
+    return -ENOMEM;
+  }
+
+  init(addr, size);
+  _allocated = true;
+
+  return 0;
+}
+#endif
+
+int MPHeap::begin(void *addr)
+{
+  if (!addr || _heap) {
+    return -EINVAL;
+  }
+
+  Heap *heap = (Heap *)addr;
+  if (heap->magic != HEAP_MAGIC) {
+    return -EPROTO;
+  }
+
+  _heap = heap;
+
+  return 0;
+}
+
+void MPHeap::end()
+{
+#ifndef SUBCORE
+  if (_allocated) {
+    MP.FreeSharedMemory(_heap);
+  }
+#endif
+  _heap = NULL;
+  _allocated = false;
+}
+
+void *MPHeap::alloc(size_t size)
+{
+  void *addr = NULL;
+
+  if (!_heap || (size == 0)) {
+    return NULL;
+  }
+
+  int cls = classof(size);
+
+  _mutex.Lock();
+
+  if (cls >= 0) {
+    uint32_t bsize = CLASS_SIZE(cls);
+
+    if (!_heap->freelist[cls]) {
+      /* Carve a new page into the blocks of the class */
+      int p = findpages(1);
+      if (p >= 0) {
+        uint32_t page = _heap->base + (p * MPHEAP_PAGE_SIZE);
+        uint32_t next = 0;
+
+        _heap->pagemap[p] = cls + 1;
+        for (int i = (MPHEAP_PAGE_SIZE / bsize) - 1; i >= 0; i--) {
+          Block *b = (Block *)(page + (i * bsize));
+          b->next = next;
+          next = (uint32_t)(uintptr_t)b;
+        }
+        _heap->freelist[cls] = next;
+      }
+    }
+
+    if (_heap->freelist[cls]) {
+      Block *b = (Block *)_heap->freelist[cls];
+      _heap->freelist[cls] = b->next;
+      _heap->used += bsize;
+      addr = b;
+    }
+  } else {
+    uint32_t num = (size + MPHEAP_PAGE_SIZE - 1) / MPHEAP_PAGE_SIZE;
+    int p = (num <= PAGE_NUM(0xffff)) ? findpages(num) : -1;
+    if (p >= 0) {
+      _heap->pagemap[p] = PAGE_LARGE | num;
+      for (uint32_t i = 1; i < num; i++) {
+        _heap->pagemap[p + i] = PAGE_CONT;
+      }
+      _heap->used += num * MPHEAP_PAGE_SIZE;
+      addr = (void *)(_heap->base + (p * MPHEAP_PAGE_SIZE));
+    }
+  }
+
+  _mutex.Unlock();
+
+  if (!addr) {
+    MPDBG("MPHeap::alloc(%d) failure.\n", size);
+  }
+
+  return addr;
+}
+
+void MPHeap::free(void *addr)
+{
+  if (!_heap || !addr) {
+    return;
+  }
+
+  uint32_t offset = (uint32_t)(uintptr_t)addr - _heap->base;
+  uint32_t p = offset / MPHEAP_PAGE_SIZE;
+
+  if (p >= _heap->npages) {
+    MPERR("MPHeap::free(%08lx) invalid address\n", (uint32_t)(uintptr_t)addr);
+    return;
+  }
+
+  _mutex.Lock();
+
+  uint16_t entry = _heap->pagemap[p];
+
+  if ((entry != PAGE_META) && (entry & PAGE_LARGE) &&
+      ((offset % MPHEAP_PAGE_SIZE) == 0)) {
+    uint32_t num = PAGE_NUM(entry);
+    for (uint32_t i = 0; i < num; i++) {
+      _heap->pagemap[p + i] = PAGE_FREE;
+    }
+    _heap->used -= num * MPHEAP_PAGE_SIZE;
+  } else if ((PAGE_FREE < entry) && (entry <= MPHEAP_CLASS_NUM)) {
+    int cls = entry - 1;
+    Block *b = (Block *)addr;
+    b->next = _heap->freelist[cls];
+    _heap->freelist[cls] = (uint32_t)(uintptr_t)b;
+    _heap->used -= CLASS_SIZE(cls);
+  } else {
+    MPERR("MPHeap::free(%08lx) invalid address\n", (uint32_t)(uintptr_t)addr);
+  }
+
+  _mutex.Unlock();
+}
+
+void MPHeap::getInfo(int &usedMem, int &freeMem, int &largestFreeMem)
+{
+  uint32_t freepages = 0;
+  uint32_t run = 0;
+  uint32_t largest = 0;
+
+  usedMem = freeMem = largestFreeMem = 0;
+
+  if (!_heap) {
+    return;
+  }
+
+  _mutex.Lock();
+
+  for (uint32_t p = 0; p < _heap->npages; p++) {
+    if (_heap->pagemap[p] == PAGE_FREE) {
+      freepages++;
+      if (++run > largest) {
+        largest = run;
+      }
+    } else {
+      run = 0;
+    }
+  }
+  usedMem = _heap->used;
+
+  _mutex.Unlock();
+
+  freeMem = freepages * MPHEAP_PAGE_SIZE;
+  largestFreeMem = largest * MPHEAP_PAGE_SIZE;
+}
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+int MPHeap::classof(size_t size)
+{
+  if (size > CLASS_SIZE(MPHEAP_CLASS_NUM - 1)) {
+    return -1;
+  }
+
+  int cls = 0;
+  while ((size_t)CLASS_SIZE(cls) < size) {
+    cls++;
+  }
+
+  return cls;
+}
+
+/* Find contiguous free pages by first fit. Call with the mutex locked. */
+
+int MPHeap::findpages(uint32_t num)
+{
+  uint32_t run = 0;
+
+  for (uint32_t p = 0; p < _heap->npages; p++) {
+    if (_heap->pagemap[p] != PAGE_FREE) {
+      run = 0;
+      continue;
+    }
+    if (++run == num) {
+      return p - num + 1;
+    }
+  }
+
+  return -1;
+}
+
+void MPHeap::init(void *addr, size_t size)
+{
+  Heap *heap = (Heap *)addr;
+  uint32_t npages = size / MPHEAP_PAGE_SIZE;
+  uint32_t meta = sizeof(Heap) + (npages * sizeof(uint16_t));
+
+  meta = (meta + MPHEAP_PAGE_SIZE - 1) / MPHEAP_PAGE_SIZE;
+
+  memset(heap, 0, sizeof(Heap));
+  heap->base = (uint32_t)(uintptr_t)addr;
+  heap->npages = npages;
+  for (uint32_t p = 0; p < npages; p++) {
+    heap->pagemap[p] = (p < meta) ? PAGE_META : PAGE_FREE;
+  }
+
+  /* Publish the heap after the page map */
+  MP_DMB();
+  heap->magic = HEAP_MAGIC;
+
+  _heap = heap;
+}
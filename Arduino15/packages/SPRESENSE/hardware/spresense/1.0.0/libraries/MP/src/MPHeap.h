@@ -0,0 +1,163 @@
+/*
+ *  MPHeap.h - Spresense Arduino Multi-Processer Shared Heap library
+ *  Copyright 2019 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _MPHEAP_H_
+#define _MPHEAP_H_
+
+/**
+ * @file MPHeap.h
+ * @author Sony Semiconductor Solutions Corporation
+ * @brief Spresense Arduino Multi-Processer Shared Heap library
+ *
+ * @details The MP library can allocate many small buffers from one shared
+ *          memory, instead of a 128KByte tile for each buffer by
+ *          MP.AllocSharedMemory(). Any core can allocate and free buffers.
+ */
+
+/**
+ * @defgroup mpheap MP Shared Heap Library API
+ * @brief MP Shared Heap API
+ * @{
+ */
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <MP.h>
+#include <MPMutex.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define MPHEAP_PAGE_SIZE  (4096) /* Unit of the heap */
+#define MPHEAP_MIN_SIZE   (16)   /* Size of the smallest class */
+#define MPHEAP_CLASS_NUM  (8)    /* Size classes from 16 to 2048 bytes */
+
+/****************************************************************************
+ * class declaration
+ ****************************************************************************/
+
+/**
+ * @class MPHeap
+ * @brief This is the interface for MP Shared Heap.
+ *
+ * @details Small buffers are rounded up to a power of 2 from 16 to 2048
+ *          bytes, and carved from pages of the same size class. Larger
+ *          buffers take contiguous pages. The buffers are physical addresses,
+ *          so they can be passed to the other cores as they are.
+ *          Pages of a size class stay in the class after its buffers are
+ *          freed.
+ */
+class MPHeap
+{
+public:
+  /**
+   * @brief Constructor
+   * @param [in] devname - hardware mutex to lock the heap.
+   *                       MP_MUTEX_ID9 is reserved for this by default.
+   */
+  MPHeap(const char *devname = MP_MUTEX_ID9);
+
+#ifndef SUBCORE
+  /**
+   * @brief Create a heap in a new shared memory
+   * @param [in] size - size of the heap. This is align up to 128KByte.
+   * @return error code. It returns minus value on failure.
+   * @retval -22(-EINVAL) Invalid argument
+   * @retval -12(-ENOMEM) Out of shared memory
+   * @details Pass address() to the other cores, and call begin(addr) there.
+   */
+  int begin(size_t size);
+#endif
+
+  /**
+   * @brief Attach to the heap created by MainCore
+   * @param [in] addr - address of the heap
+   * @return error code. It returns minus value on failure.
+   * @retval -22(-EINVAL) Invalid argument
+   * @retval -71(-EPROTO) No heap at the address
+   */
+  int begin(void *addr);
+
+  /**
+   * @brief Detach from the heap
+   * @details The shared memory created by begin(size) is freed. All cores
+   *          must stop using the heap before that.
+   */
+  void end();
+
+  /**
+   * @brief Get the address to pass to the other cores
+   */
+  void *address() {
+    return (void *)_heap;
+  };
+
+  /**
+   * @brief Allocate a buffer
+   * @param [in] size - size of the buffer [byte]
+   * @return address of the buffer aligned to 16 bytes, or NULL
+   */
+  void *alloc(size_t size);
+
+  /**
+   * @brief Free a buffer
+   * @param [in] addr - address allocated by alloc() on any core
+   */
+  void free(void *addr);
+
+  /**
+   * @brief Get memory information
+   * @param [out] usedMem - Total size of used buffers [byte]
+   * @param [out] freeMem - Total size of free pages [byte]
+   * @param [out] largestFreeMem - Size of the largest contiguous free pages [byte]
+   */
+  void getInfo(int &usedMem, int &freeMem, int &largestFreeMem);
+
+private:
+  struct Block {
+    uint32_t next;
+  };
+
+  /* Shared by all cores, and protected by the hardware semaphore.
+   * The page map follows this header.
+   */
+  struct Heap {
+    uint32_t magic;
+    uint32_t base;     /* address of the first page */
+    uint32_t npages;
+    uint32_t used;     /* used bytes */
+    uint32_t freelist[MPHEAP_CLASS_NUM];
+    uint16_t pagemap[];
+  };
+
+  Heap    *_heap;
+  bool    _allocated;
+  MPMutex _mutex;
+
+  int  classof(size_t size);
+  int  findpages(uint32_t num);
+  void init(void *addr, size_t size);
+};
+
+/** @} mpheap */
+
+#endif /* _MPHEAP_H_ */
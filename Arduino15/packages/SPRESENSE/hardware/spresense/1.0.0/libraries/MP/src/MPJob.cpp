@@ -0,0 +1,362 @@
+/*
+ *  MPJob.cpp - Spresense Arduino Multi-Processer Job Scheduler library
+ *  Copyright 2019 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <sdk/config.h>
+#include <stdio.h>
+#include <sched.h>
+#include "MPJob.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define JOB_MAGIC  0x424f4a4d
+
+#ifdef SUBCORE
+#define JOB_CORE   SUBCORE
+#else
+#define JOB_CORE   0
+#endif
+
+#define JOB_COUNT(s, c) ((s)->tail[c] - (s)->head[c])
+#define JOB_SLOT(n)     ((n) & (MPJOB_QUEUE_NUM - 1))
+
+static_assert((MPJOB_QUEUE_NUM & (MPJOB_QUEUE_NUM - 1)) == 0,
+              "MPJOB_QUEUE_NUM must be a power of two");
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+MPJobScheduler::MPJobScheduler(const char *devname)
+  : _shm(NULL), _mutex(devname), _core(JOB_CORE)
+{
+  memset(_kernel, 0, sizeof(_kernel));
+}
+
+#ifdef SUBCORE
+int MPJobScheduler::begin()
+{
+  int ret;
+  int8_t msgid;
+  void *addr;
+
+  /* Wait for the shared memory from MainCore */
+  ret = MP.Recv(&msgid, &addr);
+  if (ret < 0) {
+    return ret;
+  }
+
+  Shared *shm = (Shared *)addr;
+  if ((msgid != MPJOB_MSGID) || !shm || (shm->magic != JOB_MAGIC)) {
+    MPDBG("job setup error: msgid=%d addr=%08lx\n", msgid, (uint32_t)addr);
+    return -EPROTO;
+  }
+
+  _shm = shm;
+
+  return 0;
+}
+
+void MPJobScheduler::run()
+{
+  int8_t msgid;
+  uint32_t data;
+
+  if (!_shm) {
+    return;
+  }
+
+  while (!_shm->quit) {
+    if (runOnce()) {
+      continue;
+    }
+
+    /* Request to wake up, and check again not to miss a job */
+    _shm->idle[_core] = 1;
+    MP_DMB();
+    if (!empty() || _shm->quit) {
+      _shm->idle[_core] = 0;
+      continue;
+    }
+
+    MP.Recv(&msgid, &data);
+    _shm->idle[_core] = 0;
+  }
+
+  /* MainCore frees the shared memory after this */
+  MP_DMB();
+  _shm->exited[_core] = 1;
+  _shm = NULL;
+}
+#else /* MAINCORE */
+int MPJobScheduler::begin(uint32_t cores)
+{
+  int ret;
+
+  /* SubCore 1 to 5 only */
+  if ((cores == 0) || (cores & ~0x3e) || _shm) {
+    return -EINVAL;
+  }
+
+  _shm = (Shared *)MP.AllocSharedMemory(sizeof(Shared));
+  if (!_shm) {
+    return -ENOMEM;
+  }
+
+  memset(_shm, 0, sizeof(Shared));
+  _shm->cores = cores;
+  MP_DMB();
+  _shm->magic = JOB_MAGIC;
+
+  for (int subid = 1; subid < MP_MAX_SUBID; subid++) {
+    if (cores & (1 << subid)) {
+      ret = MP.Send(MPJOB_MSGID, (void *)_shm, subid);
+      if (ret < 0) {
+        MPDBG("job setup error: subid=%d ret=%d\n", subid, ret);
+        /* Only the workers already started are waited for in end() */
+        _shm->cores &= (1 << subid) - 1;
+        end();
+        return ret;
+      }
+    }
+  }
+
+  return 0;
+}
+
+void MPJobScheduler::end()
+{
+  if (!_shm) {
+    return;
+  }
+
+  _shm->quit = 1;
+  MP_DMB();
+
+  for (int subid = 1; subid < MP_MAX_SUBID; subid++) {
+    if (_shm->cores & (1 << subid)) {
+      MP.Send(MPJOB_MSGID, (uint32_t)0, subid);
+    }
+  }
+
+  /* Workers may still be running a job or reading quit */
+  uint32_t start = millis();
+  for (int subid = 1; subid < MP_MAX_SUBID; subid++) {
+    if (!(_shm->cores & (1 << subid))) {
+      continue;
+    }
+    while (!_shm->exited[subid]) {
+      if ((millis() - start) >= MPJOB_END_TIMEOUT) {
+        MPERR("job worker %d does not exit\n", subid);
+        _shm = NULL;
+        return;
+      }
+      sched_yield();
+    }
+  }
+  MP_DMB();
+
+  MP.FreeSharedMemory(_shm);
+  _shm = NULL;
+}
+
+int MPJobScheduler::submit(uint16_t kernel, void *arg, uint32_t count, uint32_t grain)
+{
+  if (!_shm || (kernel >= MPJOB_KERNEL_NUM) || (count == 0) || (grain == 0)) {
+    return -EINVAL;
+  }
+
+  uint32_t njobs = (count + grain - 1) / grain;
+  uint32_t cores = _shm->cores | 1; /* MainCore runs jobs in wait() */
+  uint32_t space = 0;
+
+  lock();
+
+  for (int c = 0; c < MP_MAX_SUBID; c++) {
+    if (cores & (1 << c)) {
+      space += MPJOB_QUEUE_NUM - JOB_COUNT(_shm, c);
+    }
+  }
+
+  if (space < njobs) {
+    unlock();
+    return -EAGAIN;
+  }
+
+  /* Deal jobs to each core in turn, starting from SubCores */
+  int c = 0;
+  for (uint32_t begin = 0; begin < count; begin += grain) {
+    do {
+      c = (c + 1) % MP_MAX_SUBID;
+    } while (!(cores & (1 << c)) || (JOB_COUNT(_shm, c) == MPJOB_QUEUE_NUM));
+
+    Job *job = &_shm->jobs[c][JOB_SLOT(_shm->tail[c])];
+    job->kernel = kernel;
+    job->arg    = MP.Virt2Phys(arg);
+    job->begin  = begin;
+    job->end    = ((count - begin) > grain) ? (begin + grain) : count;
+    _shm->tail[c]++;
+  }
+
+  _shm->pending += njobs;
+
+  unlock();
+
+  wakeup();
+
+  return njobs;
+}
+
+void MPJobScheduler::wait()
+{
+  while (!done()) {
+    if (!runOnce()) {
+      sched_yield();
+    }
+  }
+}
+
+bool MPJobScheduler::done()
+{
+  return !_shm || (_shm->pending == 0);
+}
+#endif
+
+int MPJobScheduler::addKernel(uint16_t id, MPJobKernel kernel)
+{
+  if (id >= MPJOB_KERNEL_NUM) {
+    return -EINVAL;
+  }
+
+  _kernel[id] = kernel;
+
+  return 0;
+}
+
+bool MPJobScheduler::runOnce()
+{
+  Job job;
+
+  if (!_shm || empty() || !take(&job)) {
+    return false;
+  }
+
+  MPJobKernel kernel = _kernel[job.kernel];
+  if (kernel) {
+    kernel((void *)job.arg, job.begin, job.end);
+  } else {
+    MPERR("kernel %d is not registered\n", job.kernel);
+  }
+
+  lock();
+  _shm->executed[_core]++;
+  _shm->pending--;
+  unlock();
+
+  return true;
+}
+
+uint32_t MPJobScheduler::getExecuted(int core, uint32_t *stolen)
+{
+  if (!_shm || (core < 0) || (MP_MAX_SUBID <= core)) {
+    return 0;
+  }
+
+  if (stolen) {
+    *stolen = _shm->stolen[core];
+  }
+
+  return _shm->executed[core];
+}
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+void MPJobScheduler::lock()
+{
+  _mutex.Lock();
+}
+
+void MPJobScheduler::unlock()
+{
+  _mutex.Unlock();
+}
+
+bool MPJobScheduler::take(Job *job)
+{
+  int c = _core;
+
+  lock();
+
+  if (JOB_COUNT(_shm, c) > 0) {
+    /* Own queue from the newest */
+    _shm->tail[c]--;
+    *job = _shm->jobs[c][JOB_SLOT(_shm->tail[c])];
+  } else {
+    /* Steal from the oldest of the longest queue */
+    uint32_t max = 0;
+    for (int i = 0; i < MP_MAX_SUBID; i++) {
+      if (JOB_COUNT(_shm, i) > max) {
+        max = JOB_COUNT(_shm, i);
+        c = i;
+      }
+    }
+    if (max == 0) {
+      unlock();
+      return false;
+    }
+    *job = _shm->jobs[c][JOB_SLOT(_shm->head[c])];
+    _shm->head[c]++;
+    _shm->stolen[_core]++;
+  }
+
+  unlock();
+
+  return true;
+}
+
+bool MPJobScheduler::empty()
+{
+  for (int i = 0; i < MP_MAX_SUBID; i++) {
+    if (JOB_COUNT(_shm, i) > 0) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void MPJobScheduler::wakeup()
+{
+  /* Check the requests after the jobs are queued */
+  MP_DMB();
+
+  for (int subid = 1; subid < MP_MAX_SUBID; subid++) {
+    if ((_shm->cores & (1 << subid)) && _shm->idle[subid]) {
+      _shm->idle[subid] = 0;
+      MP.Send(MPJOB_MSGID, (uint32_t)0, subid);
+    }
+  }
+}
@@ -0,0 +1,199 @@
+/*
+ *  MPJob.h - Spresense Arduino Multi-Processer Job Scheduler library
+ *  Copyright 2019 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _MPJOB_H_
+#define _MPJOB_H_
+
+/**
+ * @file MPJob.h
+ * @author Sony Semiconductor Solutions Corporation
+ * @brief Spresense Arduino Multi-Processer Job Scheduler library
+ *
+ * @details The MP library can split a data-parallel kernel into jobs, and
+ *          run them on MainCore and SubCores. Each core has its own job
+ *          queue, and takes jobs from the other queues when its own queue
+ *          is empty.
+ */
+
+/**
+ * @defgroup mpjob MP Job Scheduler Library API
+ * @brief MP Job Scheduler API
+ * @{
+ */
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <MP.h>
+#include <MPMutex.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define MPJOB_QUEUE_NUM   (32)  /* Number of jobs in a queue of each core */
+#define MPJOB_KERNEL_NUM  (16)  /* Number of kernels on each core */
+#define MPJOB_END_TIMEOUT (1000) /* Time to wait for the workers in end() [ms] */
+
+/****************************************************************************
+ * class declaration
+ ****************************************************************************/
+
+/**
+ * @brief Kernel function to process items from begin to end - 1
+ */
+typedef void (*MPJobKernel)(void *arg, uint32_t begin, uint32_t end);
+
+/**
+ * @class MPJobScheduler
+ * @brief This is the interface for MP Job Scheduler.
+ *
+ * @details The same kernel must be registered with the same ID on all cores,
+ *          because each core runs its own program.
+ */
+class MPJobScheduler
+{
+public:
+  /**
+   * @brief Constructor
+   * @param [in] devname - hardware mutex to lock the job queues.
+   *                       MP_MUTEX_ID10 is reserved for this by default.
+   */
+  MPJobScheduler(const char *devname = MP_MUTEX_ID10);
+
+#ifdef SUBCORE
+  /**
+   * @brief Start the worker
+   * @return error code. It returns minus value on failure.
+   * @retval -71(-EPROTO) Unexpected message from MainCore
+   * @details Wait for the scheduler from MainCore. Call after MP.begin().
+   */
+  int begin();
+
+  /**
+   * @brief Run jobs until MainCore calls end()
+   * @details When there is no job, the worker waits for MPJOB_MSGID of MP.h.
+   */
+  void run();
+#else
+  /**
+   * @brief Start the scheduler
+   * @param [in] cores - bit mask of SubCore number(1~5) to run jobs.
+   *                     The SubCores must be already started by MP.begin().
+   * @return error code. It returns minus value on failure.
+   * @retval -22(-EINVAL) Invalid argument
+   * @retval -12(-ENOMEM) Out of shared memory
+   */
+  int begin(uint32_t cores);
+
+  /**
+   * @brief Stop the scheduler and the workers
+   * @details The shared memory is freed after all workers leave run().
+   *          If a worker does not leave in MPJOB_END_TIMEOUT, the shared
+   *          memory is left allocated, because the worker may still use it.
+   */
+  void end();
+
+  /**
+   * @brief Submit a kernel
+   * @param [in] kernel - kernel ID
+   * @param [in] arg - argument of the kernel. It is converted by Virt2Phys().
+   * @param [in] count - number of items
+   * @param [in] grain - number of items in a job
+   * @return number of jobs or error code. It returns minus value on failure.
+   * @retval -22(-EINVAL) Invalid argument
+   * @retval -11(-EAGAIN) Not enough space in the job queues
+   * @details Items are split into jobs, and queued to each core in turn.
+   */
+  int submit(uint16_t kernel, void *arg, uint32_t count, uint32_t grain);
+
+  /**
+   * @brief Wait for all of the submitted jobs to be done
+   * @details MainCore also runs jobs while waiting.
+   */
+  void wait();
+
+  /**
+   * @brief Check if all of the submitted jobs are done
+   */
+  bool done();
+#endif
+
+  /**
+   * @brief Register a kernel on this core
+   * @param [in] id - kernel ID (0 ~ MPJOB_KERNEL_NUM - 1)
+   * @param [in] kernel - kernel function
+   * @return error code. It returns minus value on failure.
+   * @retval -22(-EINVAL) Invalid argument
+   */
+  int addKernel(uint16_t id, MPJobKernel kernel);
+
+  /**
+   * @brief Run one job on this core
+   * @return true if a job was run
+   */
+  bool runOnce();
+
+  /**
+   * @brief Get the number of jobs run on the core
+   * @param [in] core - 0 for MainCore, SubCore number(1~5)
+   * @param [out] stolen - number of jobs taken from the other queues
+   */
+  uint32_t getExecuted(int core, uint32_t *stolen = NULL);
+
+private:
+  struct Job {
+    uint16_t kernel;
+    uint16_t reserved;
+    uint32_t arg;
+    uint32_t begin;
+    uint32_t end;
+  };
+
+  /* Shared by all cores. Queues are protected by the hardware semaphore. */
+  struct Shared {
+    uint32_t magic;
+    uint32_t cores;
+    volatile uint32_t quit;
+    volatile uint32_t pending;
+    volatile uint32_t idle[MP_MAX_SUBID];
+    volatile uint32_t exited[MP_MAX_SUBID];
+    volatile uint32_t executed[MP_MAX_SUBID];
+    volatile uint32_t stolen[MP_MAX_SUBID];
+    volatile uint32_t head[MP_MAX_SUBID];
+    volatile uint32_t tail[MP_MAX_SUBID];
+    Job      jobs[MP_MAX_SUBID][MPJOB_QUEUE_NUM];
+  };
+
+  Shared      *_shm;
+  MPMutex     _mutex;
+  int         _core;
+  MPJobKernel _kernel[MPJOB_KERNEL_NUM];
+
+  void lock();
+  void unlock();
+  bool take(Job *job);
+  bool empty();
+  void wakeup();
+};
+
+/** @} mpjob */
+
+#endif /* _MPJOB_H_ */
@@ -0,0 +1,368 @@
+/*
+ *  MPLog.cpp - Spresense Arduino Multi-Processer Log Buffer library
+ *  Copyright 2019 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <sdk/config.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <sched.h>
+#include "MP.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define LOG_MAGIC  0x474f4c4d
+
+#ifdef SUBCORE
+#define LOG_CORE   SUBCORE
+#else
+#define LOG_CORE   0
+#endif
+
+#define LOG_SLOT(n) ((n) & (MPLOG_RECORD_NUM - 1))
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* Shared by all cores. Each core writes only to its own ring. */
+
+struct MPLogBuffer::Shared {
+  uint32_t magic;
+  uint32_t reserved[3];
+  Ring     ring[MP_MAX_SUBID];
+};
+
+/****************************************************************************
+ * Public Data
+ ****************************************************************************/
+
+MPLogBuffer MPLogBuf;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/* Store the arguments as the words passed to a variadic function.
+ * 64-bit arguments start from an even register or an 8-byte aligned stack
+ * slot, that is an odd word index after fmt, as in the ARM procedure call
+ * standard. Strings are converted to the physical address for MainCore.
+ */
+
+static uint32_t log_args(uint32_t *args, const char *fmt, va_list ap)
+{
+  uint32_t n = 0;
+  const char *p = fmt;
+
+  while (*p) {
+    if (*p++ != '%') {
+      continue;
+    }
+
+    /* Flags, width and precision */
+    while (*p && strchr("-+ #0123456789.*", *p)) {
+      if ((*p == '*') && (n < MPLOG_ARG_NUM)) {
+        args[n++] = va_arg(ap, int);
+      }
+      p++;
+    }
+
+    /* Length modifier */
+    int longs = 0;
+    while (*p && strchr("hlLjzt", *p)) {
+      if (*p == 'l') {
+        longs++;
+      } else if ((*p == 'L') || (*p == 'j')) {
+        longs = 2;
+      }
+      p++;
+    }
+
+    bool wide = false;
+    uint64_t val = 0;
+
+    switch (*p) {
+      case '\0':
+        return n;
+      case '%':
+        p++;
+        continue;
+      case 'e': case 'E': case 'f': case 'F':
+      case 'g': case 'G': case 'a': case 'A':
+        {
+          double d = va_arg(ap, double);
+          memcpy(&val, &d, sizeof(val));
+          wide = true;
+        }
+        break;
+      case 's':
+        val = MP.Virt2Phys(va_arg(ap, char *));
+        break;
+      case 'p':
+        val = (uint32_t)(uintptr_t)va_arg(ap, void *);
+        break;
+      default:
+        if (longs >= 2) {
+          val = va_arg(ap, uint64_t);
+          wide = true;
+        } else {
+          val = va_arg(ap, uint32_t);
+        }
+        break;
+    }
+    p++;
+
+    if (wide) {
+      n |= 1;
+      if (n + 2 > MPLOG_ARG_NUM) {
+        break;
+      }
+      args[n++] = (uint32_t)val;
+      args[n++] = (uint32_t)(val >> 32);
+    } else {
+      if (n + 1 > MPLOG_ARG_NUM) {
+        break;
+      }
+      args[n++] = (uint32_t)val;
+    }
+  }
+
+  return n;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+MPLogBuffer::MPLogBuffer()
+{
+#ifndef SUBCORE
+  _shm = NULL;
+  _tid = 0;
+  _running = false;
+  pthread_mutex_init(&_lock, NULL);
+#endif
+}
+
+int MPLogBuffer::write(const char *fmt, ...)
+{
+  volatile uint8_t *writing = &MP._rmng->logwriting[LOG_CORE];
+  va_list ap;
+
+  /* Serialize the tasks on this core only */
+  irqstate_t flags = enter_critical_section();
+
+  /* Tell end() that this core uses the buffer before reading the address,
+   * so the buffer is not freed until this write is finished.
+   */
+  *writing = 1;
+  MP_DMB();
+
+  Shared *shm = (Shared *)MP._rmng->logbuf;
+  if (!shm || (shm->magic != LOG_MAGIC)) {
+    MP_DMB();
+    *writing = 0;
+    leave_critical_section(flags);
+    return -ENODEV;
+  }
+
+  Ring *ring = &shm->ring[LOG_CORE];
+
+  uint32_t head = ring->head;
+  if ((head - ring->tail) >= MPLOG_RECORD_NUM) {
+    ring->dropped++;
+    MP_DMB();
+    *writing = 0;
+    leave_critical_section(flags);
+    return 0;
+  }
+
+  Record *rec = &ring->rec[LOG_SLOT(head)];
+  rec->fmt = MP.Virt2Phys((void *)fmt);
+  va_start(ap, fmt);
+  rec->num = log_args(rec->args, fmt, ap);
+  va_end(ap);
+
+  /* Publish the record before the position */
+  MP_DMB();
+  ring->head = head + 1;
+
+  MP_DMB();
+  *writing = 0;
+
+  leave_critical_section(flags);
+
+  return 0;
+}
+
+bool MPLogBuffer::active()
+{
+  return MP._rmng->logbuf != 0;
+}
+
+#ifndef SUBCORE
+int MPLogBuffer::begin()
+{
+  if (_shm) {
+    return -EBUSY;
+  }
+
+  _shm = (Shared *)MP.AllocSharedMemory(sizeof(Shared));
+  if (!_shm) {
+    return -ENOMEM;
+  }
+
+  memset(_shm, 0, sizeof(Shared));
+  _shm->magic = LOG_MAGIC;
+  MP_DMB();
+
+  pthread_attr_t attr;
+  struct sched_param param;
+
+  _running = true;
+  pthread_attr_init(&attr);
+  pthread_attr_setstacksize(&attr, MPLOG_STACK_SIZE);
+  param.sched_priority = MPLOG_PRIO;
+  pthread_attr_setschedparam(&attr, &param);
+
+  int ret = pthread_create(&_tid, &attr, (pthread_startroutine_t)drain_thread, (pthread_addr_t)this);
+  if (ret != 0) {
+    MPERR("pthread_create() failure. %d\n", ret);
+    _running = false;
+    MP.FreeSharedMemory(_shm);
+    _shm = NULL;
+    return -ret;
+  }
+  pthread_setname_np(_tid, "mplog");
+
+  /* Start buffering on all cores */
+  MP._rmng->logbuf = (uint32_t)(uintptr_t)_shm;
+
+  return 0;
+}
+
+void MPLogBuffer::end()
+{
+  if (!_shm) {
+    return;
+  }
+
+  /* Stop buffering */
+  MP._rmng->logbuf = 0;
+  MP_DMB();
+
+  _running = false;
+  pthread_join(_tid, NULL);
+
+  /* Writers may still be storing a log after reading the address */
+  uint32_t start = millis();
+  for (int core = 0; core < MP_MAX_SUBID; core++) {
+    while (MP._rmng->logwriting[core]) {
+      if ((millis() - start) >= MPLOG_END_TIMEOUT) {
+        MPERR("log writer %d does not finish\n", core);
+        _shm = NULL;
+        return;
+      }
+      sched_yield();
+    }
+  }
+  MP_DMB();
+
+  /* Print the rest */
+  flush();
+
+  MP.FreeSharedMemory(_shm);
+  _shm = NULL;
+}
+
+void MPLogBuffer::flush()
+{
+  if (!_shm) {
+    return;
+  }
+
+  pthread_mutex_lock(&_lock);
+  for (int core = 0; core < MP_MAX_SUBID; core++) {
+    drain(core, &_shm->ring[core]);
+  }
+  pthread_mutex_unlock(&_lock);
+}
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+void *MPLogBuffer::drain_thread(void *arg)
+{
+  MPLogBuffer *log = (MPLogBuffer *)arg;
+
+  while (log->_running) {
+    log->flush();
+    usleep(MPLOG_DRAIN_INTERVAL * 1000);
+  }
+
+  return NULL;
+}
+
+void MPLogBuffer::drain(int core, Ring *ring)
+{
+  char buf[MPLOG_LINE_SIZE];
+  int n;
+
+  while (ring->tail != ring->head) {
+    /* Read the record after the position */
+    MP_DMB();
+
+    Record *rec = &ring->rec[LOG_SLOT(ring->tail)];
+    uint32_t *a = rec->args;
+
+    n = snprintf(buf, sizeof(buf), (core == 0) ? "[Main] " : "[Sub%d] ", core);
+    n += snprintf(&buf[n], sizeof(buf) - n, (const char *)rec->fmt,
+                  a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7]);
+    if (n >= (int)sizeof(buf)) {
+      n = sizeof(buf) - 1;
+    }
+
+    /* Finish reading the record before the core overwrites it */
+    MP_DMB();
+    ring->tail = ring->tail + 1;
+
+    irqstate_t flags = printlock();
+    uart_syncwrite(buf, n);
+    printunlock(flags);
+  }
+
+  uint32_t dropped = ring->dropped;
+  if (dropped != ring->reported) {
+    n = snprintf(buf, sizeof(buf), (core == 0) ? "[Main] " : "[Sub%d] ", core);
+    n += snprintf(&buf[n], sizeof(buf) - n, "%lu logs dropped\n",
+                  (unsigned long)(dropped - ring->reported));
+
+    irqstate_t flags = printlock();
+    uart_syncwrite(buf, n);
+    printunlock(flags);
+    ring->reported = dropped;
+  }
+}
+#endif
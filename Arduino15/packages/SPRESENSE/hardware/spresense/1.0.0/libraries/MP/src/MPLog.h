@@ -0,0 +1,149 @@
+/*
+ *  MPLog.h - Spresense Arduino Multi-Processer Log Buffer library
+ *  Copyright 2019 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _MPLOG_H_
+#define _MPLOG_H_
+
+/**
+ * @file MPLog.h
+ * @author Sony Semiconductor Solutions Corporation
+ * @brief Spresense Arduino Multi-Processer Log Buffer library
+ *
+ * @details After MPLogBuf.begin() on MainCore, MPLog() on every core only
+ *          stores the format and the arguments into the ring buffer of the
+ *          core, and a task on MainCore formats and prints them.
+ *          The format and the strings of %s must stay in memory until they
+ *          are printed, so use string literals.
+ */
+
+/**
+ * @defgroup mplog MP Log Buffer Library API
+ * @brief MP Log Buffer API
+ * @{
+ */
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <stdint.h>
+#include <pthread.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define MPLOG_RECORD_NUM     (256) /* Number of records per core */
+#define MPLOG_ARG_NUM        (8)   /* Argument words per record */
+#define MPLOG_LINE_SIZE      (128)
+#define MPLOG_DRAIN_INTERVAL (10)  /* msec */
+#define MPLOG_STACK_SIZE     (2048)
+#define MPLOG_PRIO           (100)
+#define MPLOG_END_TIMEOUT    (1000) /* msec */
+
+/****************************************************************************
+ * class declaration
+ ****************************************************************************/
+
+/**
+ * @class MPLogBuffer
+ * @brief This is the interface for MP Log Buffer.
+ *
+ */
+class MPLogBuffer
+{
+public:
+  MPLogBuffer();
+
+#ifndef SUBCORE
+  /**
+   * @brief Start the log buffers of all cores and the drain task
+   * @return error code. It returns minus value on failure.
+   * @retval -12(-ENOMEM) Out of shared memory
+   * @retval -16(-EBUSY) Already started
+   */
+  int begin();
+
+  /**
+   * @brief Print all logs, and stop the log buffers
+   * @details The buffers are freed after the writes in progress on all cores
+   *          are finished. If a core does not finish in MPLOG_END_TIMEOUT,
+   *          the buffers are left allocated.
+   */
+  void end();
+
+  /**
+   * @brief Print all logs in the buffers now
+   */
+  void flush();
+#endif
+
+  /**
+   * @brief Store a log into the buffer of this core
+   * @return error code. It returns minus value if the buffer is not started.
+   * @details Use MPLog() instead of this function. When the buffer is full,
+   *          the log is dropped and counted.
+   */
+  int write(const char *fmt, ...);
+
+  /**
+   * @brief Check whether the log buffers are started
+   * @return true if MPLog() stores logs into the buffer
+   * @details A log of MPLog() is dropped if the buffers are stopped just
+   *          after this check.
+   */
+  bool active();
+
+private:
+  struct Record {
+    uint32_t fmt;
+    uint32_t num;
+    uint32_t args[MPLOG_ARG_NUM];
+  };
+
+  struct Ring {
+    volatile uint32_t head;
+    volatile uint32_t tail;
+    volatile uint32_t dropped;
+    uint32_t reported;
+    Record   rec[MPLOG_RECORD_NUM];
+  };
+
+  struct Shared;
+
+#ifndef SUBCORE
+  Shared          *_shm;
+  pthread_t       _tid;
+  volatile bool   _running;
+  pthread_mutex_t _lock;
+
+  static void *drain_thread(void *arg);
+  void drain(int core, Ring *ring);
+#endif
+};
+
+/****************************************************************************
+ * extern declaration
+ ****************************************************************************/
+
+extern MPLogBuffer MPLogBuf;
+
+/** @} mplog */
+
+#endif /* _MPLOG_H_ */
@@ -26,6 +26,8 @@
  * @brief Spresense Arduino Multi-Processer Mutex library
  *
  * @details The MP library can manage the Multi-processor Mutex.
+ *          MPMutex is a hardware semaphore shared by all cores, and
+ *          MPRWLock is a multi-reader/single-writer lock built on it.
  */
 
 /**
@@ -47,11 +49,20 @@
 #include <sys/ioctl.h>
 
 #include <cxd56_sph.h>
+#include <hardware/cxd56_sph.h>
+#include <common/arm_internal.h>
+
+#include <MP.h>
 
 /****************************************************************************
  * Pre-processor Definitions
  ****************************************************************************/
 
+/* The libraries on MP take the following by default. Do not use them in a
+ * sketch using the library, or pass another ID to the library.
+ *   MP_MUTEX_ID9  : MPHeap
+ *   MP_MUTEX_ID10 : MPJobScheduler
+ */
 #define MP_MUTEX_ID0  "/dev/hsem14"
 #define MP_MUTEX_ID1  "/dev/hsem13"
 #define MP_MUTEX_ID2  "/dev/hsem12"
@@ -64,6 +75,32 @@
 #define MP_MUTEX_ID9  "/dev/hsem5"
 #define MP_MUTEX_ID10 "/dev/hsem4"
 
+/* Backoff of Lock() in loop count. After the maximum, wait by WFE. */
+#define MP_MUTEX_BACKOFF_MIN  (16)
+#define MP_MUTEX_BACKOFF_MAX  (4096)
+
+#ifndef MP_MUTEX_WFE
+#define MP_MUTEX_WFE()      __asm__ __volatile__ ("wfe")
+#define MP_MUTEX_SEV()      __asm__ __volatile__ ("sev")
+#endif
+
+/****************************************************************************
+ * inline functions
+ ****************************************************************************/
+
+/* Wait a while, and double the next wait. Once it reaches the maximum,
+ * sleep until an event from Unlock() or an interrupt.
+ */
+static inline void mpmutex_backoff(uint32_t *delay)
+{
+  if (*delay < MP_MUTEX_BACKOFF_MAX) {
+    for (volatile uint32_t i = 0; i < *delay; i++);
+    *delay <<= 1;
+  } else {
+    MP_MUTEX_WFE();
+  }
+}
+
 /****************************************************************************
  * class declaration
  ****************************************************************************/
@@ -76,7 +113,7 @@
 class MPMutex
 {
 public:
-  MPMutex(const char *devname) : _fd(-1) {
+  MPMutex(const char *devname) : _fd(-1), _semid(-1) {
     strncpy(_devname, devname, sizeof(_devname));
   };
   ~MPMutex() {
@@ -84,30 +121,218 @@ public:
       close(_fd);
     }
   }
-#if 0 /* not support yet */
+  /**
+   * @brief Lock the mutex
+   * @return 0 on success, -1 on failure
+   * @details Wait until the mutex is unlocked. The core retries with
+   *          exponential backoff, and then sleeps by WFE.
+   */
   int Lock() {
     if (_create()) { return -1; }
-    return ioctl(_fd, HSLOCK, 0);
+    uint32_t delay = MP_MUTEX_BACKOFF_MIN;
+    while (!_trylock()) {
+      mpmutex_backoff(&delay);
+    }
+    return 0;
   };
-#endif
+  /**
+   * @brief Try to lock the mutex
+   * @return 0 on success, -1 if it is locked by the other core or on
+   *         failure. errno is set to EBUSY when locked, as the ioctl of
+   *         the semaphore driver did.
+   */
   int Trylock() {
     if (_create()) { return -1; }
-    return ioctl(_fd, HSTRYLOCK, 0);
+    if (!_trylock()) {
+      errno = EBUSY;
+      return -1;
+    }
+    return 0;
   };
+  /**
+   * @brief Unlock the mutex
+   * @return 0 on success, -1 on failure
+   */
   int Unlock() {
     if (_create()) { return -1; }
-    return ioctl(_fd, HSUNLOCK, 0);
+    MP_DMB();
+    putreg32(REQ_UNLOCK, CXD56_SPH_REQ(_semid));
+    /* Wake up the cores waiting by WFE */
+    MP_MUTEX_SEV();
+    return 0;
   };
 
 private:
   int  _fd;
+  int  _semid;
   char _devname[16];
   int  _create() {
     if (_fd < 0) {
       _fd = open(_devname, 0);
-      return (_fd < 0) ? -1 : 0;
+      if (_fd < 0) {
+        return -1;
+      }
+      /* Access the semaphore registers directly after this */
+      const char *num = strpbrk(_devname, "0123456789");
+      _semid = num ? atoi(num) : -1;
+      if (_semid < 0) {
+        close(_fd);
+        _fd = -1;
+        return -1;
+      }
+    }
+    return 0;
+  }
+  bool _trylock() {
+    uint32_t sts = getreg32(CXD56_SPH_STS(_semid));
+    if (STS_STATE(sts) != STATE_IDLE) {
+      return false;
+    }
+    putreg32(REQ_LOCK, CXD56_SPH_REQ(_semid));
+    sts = getreg32(CXD56_SPH_STS(_semid));
+    if ((STS_STATE(sts) == STATE_LOCKED) && ((int)LOCK_OWNER(sts) == MP_GET_CPUID())) {
+      MP_DMB();
+      return true;
+    }
+    return false;
+  }
+};
+
+/**
+ * @class MPRWLock
+ * @brief This is the interface for MP Reader/Writer Lock.
+ *
+ * @details Any number of readers or one writer can hold the lock. A waiting
+ *          writer blocks new readers. The state is in the shared memory, and
+ *          it is protected by MPMutex for a short time.
+ */
+class MPRWLock
+{
+public:
+  MPRWLock(const char *devname) : _mutex(devname), _state(NULL) {};
+
+  /**
+   * @brief Set the state of the lock
+   * @param [in] addr - address of the state in the memory shared by cores.
+   *                    The size must be memsize() or more.
+   * @param [in] create - true on the core which initializes the state
+   * @return 0 on success, -1 on failure
+   */
+  int begin(void *addr, bool create = false) {
+    if (!addr) {
+      return -1;
+    }
+    _state = (State *)addr;
+    if (create) {
+      _state->readers = 0;
+      _state->writer  = 0;
+      _state->waiting = 0;
+      MP_DMB();
     }
     return 0;
+  };
+
+  /**
+   * @brief Get the size of the state [byte]
+   */
+  static size_t memsize() {
+    return sizeof(State);
+  };
+
+  /**
+   * @brief Lock for reading
+   * @return 0 on success, -1 on failure
+   * @details Wait while a writer holds or waits for the lock. The core
+   *          retries with exponential backoff, and then sleeps by WFE.
+   */
+  int ReadLock() {
+    uint32_t delay = MP_MUTEX_BACKOFF_MIN;
+    if (!_state) { return -1; }
+    while (1) {
+      if (_mutex.Lock()) { return -1; }
+      if (!_blocked(false)) {
+        _state->readers++;
+        _mutex.Unlock();
+        return 0;
+      }
+      _mutex.Unlock();
+      _wait(&delay, false);
+    }
+  };
+  /**
+   * @brief Unlock for reading
+   * @return 0 on success, -1 on failure
+   */
+  int ReadUnlock() {
+    if (!_state) { return -1; }
+    if (_mutex.Lock()) { return -1; }
+    _state->readers--;
+    return _mutex.Unlock();
+  };
+  /**
+   * @brief Lock for writing
+   * @return 0 on success, -1 on failure
+   * @details Wait until all readers and the writer unlock. New readers are
+   *          blocked while waiting. The core retries with exponential
+   *          backoff, and then sleeps by WFE.
+   */
+  int WriteLock() {
+    uint32_t delay = MP_MUTEX_BACKOFF_MIN;
+    if (!_state) { return -1; }
+    if (_mutex.Lock()) { return -1; }
+    _state->waiting++;
+    while (_blocked(true)) {
+      _mutex.Unlock();
+      _wait(&delay, true);
+      if (_mutex.Lock()) { return -1; }
+    }
+    _state->waiting--;
+    _state->writer = 1;
+    return _mutex.Unlock();
+  };
+  /**
+   * @brief Unlock for writing
+   * @return 0 on success, -1 on failure
+   */
+  int WriteUnlock() {
+    if (!_state) { return -1; }
+    if (_mutex.Lock()) { return -1; }
+    _state->writer = 0;
+    return _mutex.Unlock();
+  };
+
+private:
+  struct State {
+    volatile uint32_t readers;
+    volatile uint32_t writer;
+    volatile uint32_t waiting;
+  };
+
+  MPMutex _mutex;
+  State   *_state;
+
+  bool _blocked(bool write) {
+    if (write) {
+      return _state->writer || _state->readers;
+    }
+    return _state->writer || _state->waiting;
+  }
+  /* The SEV of our own Unlock() sets the event register of this core, so
+   * WFE would return at once. Clear it by SEV and WFE, and then check the
+   * state again before sleeping. An Unlock() on the other core after the
+   * check sets the event again, so the wake up is never missed.
+   */
+  void _wait(uint32_t *delay, bool write) {
+    if (*delay < MP_MUTEX_BACKOFF_MAX) {
+      mpmutex_backoff(delay);
+      return;
+    }
+    MP_MUTEX_SEV();
+    MP_MUTEX_WFE();
+    MP_DMB();
+    if (_blocked(write)) {
+      MP_MUTEX_WFE();
+    }
   }
 };
 
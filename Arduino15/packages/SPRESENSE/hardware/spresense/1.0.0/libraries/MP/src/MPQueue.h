@@ -0,0 +1,339 @@
+/*
+ *  MPQueue.h - Spresense Arduino Multi-Processer Queue library
+ *  Copyright 2019 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _MPQUEUE_H_
+#define _MPQUEUE_H_
+
+/**
+ * @file MPQueue.h
+ * @author Sony Semiconductor Solutions Corporation
+ * @brief Spresense Arduino Multi-Processer Queue library
+ *
+ * @details The MP library can pass data between two cores through a
+ *          single-producer single-consumer queue in the shared memory.
+ */
+
+/**
+ * @defgroup mpqueue MP Queue Library API
+ * @brief MP Queue API
+ * @{
+ */
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <MP.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define MP_QUEUE_MAGIC 0x5551504d
+
+/****************************************************************************
+ * class declaration
+ ****************************************************************************/
+
+/**
+ * @class MPQueue
+ * @brief This is the interface for MP Queue.
+ *
+ * @details One core pushes, and the other core pops. The queue does not
+ *          send any message while both cores keep up. When pop() finds the
+ *          queue empty (or push() finds it full), the next push() (or pop())
+ *          on the other core sends one message to notify it, if the message
+ *          ID is set by setNotify().
+ *
+ * @param T - type of an item. It is copied by memcpy.
+ * @param N - number of items. It must be power of 2.
+ */
+template <typename T, uint32_t N>
+class MPQueue
+{
+public:
+  MPQueue() : _q(NULL), _allocated(false), _msgid(-1), _subid(0) {};
+  ~MPQueue() {
+    end();
+  }
+
+#ifndef SUBCORE
+  /**
+   * @brief Create a queue in a new shared memory
+   * @return error code. It returns minus value on failure.
+   * @retval -12(-ENOMEM) Out of shared memory
+   * @details Pass address() to the other core, and call begin(addr) there.
+   */
+  int begin() {
+    void *addr = MP.AllocSharedMemory(sizeof(Queue));
+    if (!addr) {
+      return -ENOMEM;
+    }
+    init(addr);
+    _allocated = true;
+    return 0;
+  };
+#endif
+
+  /**
+   * @brief Create a queue in the specified memory, or attach to it
+   * @param [in] addr - address of the memory for the queue
+   * @param [in] create - true to create a queue, false to attach to the queue
+   *                      created by the other core
+   * @return error code. It returns minus value on failure.
+   * @retval -22(-EINVAL) Invalid argument
+   * @retval -71(-EPROTO) No queue of the same type at the address
+   * @details The memory must be accessible from both cores, and its size
+   *          must be memsize() or more.
+   */
+  int begin(void *addr, bool create = false) {
+    if (!addr || _q) {
+      return -EINVAL;
+    }
+    if (create) {
+      init(addr);
+      return 0;
+    }
+    Queue *q = (Queue *)addr;
+    if ((q->magic != MP_QUEUE_MAGIC) || (q->num != N) || (q->itemsize != sizeof(T))) {
+      return -EPROTO;
+    }
+    _q = q;
+    return 0;
+  };
+
+  /**
+   * @brief Detach from the queue
+   * @details The shared memory allocated by begin() is freed.
+   */
+  void end() {
+#ifndef SUBCORE
+    if (_allocated) {
+      MP.FreeSharedMemory(_q);
+    }
+#endif
+    _q = NULL;
+    _allocated = false;
+  };
+
+  /**
+   * @brief Get the address to pass to the other core
+   * @return physical address of the queue
+   */
+  void *address() {
+    return (void *)MP.Virt2Phys(_q);
+  };
+
+  /**
+   * @brief Get the size of memory for the queue [byte]
+   */
+  static size_t memsize() {
+    return sizeof(Queue);
+  };
+
+  /**
+   * @brief Set the message to notify the other core
+   * @param [in] msgid - user-defined message ID (0~127) to send
+   * @param [in] subid - SubCore number(1~5) of the other core.
+   *                     If the other core is MainCore, 0.
+   * @details The message data is the number of items in the queue.
+   */
+  void setNotify(int8_t msgid, int subid = 0) {
+    _msgid = msgid;
+    _subid = subid;
+  };
+
+  /**
+   * @brief Push an item
+   * @return true on success, false if the queue is full
+   */
+  bool push(const T &item) {
+    return push(&item, 1) == 1;
+  };
+
+  /**
+   * @brief Push items
+   * @return number of pushed items
+   */
+  uint32_t push(const T *items, uint32_t num) {
+    if (!_q) {
+      return 0;
+    }
+    uint32_t head = _q->head;
+    uint32_t n = N - (head - _q->tail);
+    if (n == 0) {
+      /* Request to notify when the queue is not full */
+      _q->waiting[TX] = 1;
+      MP_DMB();
+      n = N - (head - _q->tail);
+    }
+    if (n > num) {
+      n = num;
+    }
+    for (uint32_t i = 0; i < n; i++) {
+      memcpy(&_q->items[(head + i) & (N - 1)], &items[i], sizeof(T));
+    }
+    /* Publish the items before the position */
+    MP_DMB();
+    _q->head = head + n;
+    if (n) {
+      wakeup(RX, head + n - _q->tail);
+    }
+    return n;
+  };
+
+  /**
+   * @brief Pop an item
+   * @return true on success, false if the queue is empty
+   */
+  bool pop(T &item) {
+    return pop(&item, 1) == 1;
+  };
+
+  /**
+   * @brief Pop items
+   * @return number of popped items
+   */
+  uint32_t pop(T *items, uint32_t num) {
+    if (!_q) {
+      return 0;
+    }
+    uint32_t tail = _q->tail;
+    uint32_t n = wait_items(tail);
+    if (n > num) {
+      n = num;
+    }
+    for (uint32_t i = 0; i < n; i++) {
+      memcpy(&items[i], &_q->items[(tail + i) & (N - 1)], sizeof(T));
+    }
+    release(n);
+    return n;
+  };
+
+  /**
+   * @brief Get the items at the front without copying
+   * @param [out] item - pointer to the first item in the queue
+   * @return number of contiguous items from *item
+   * @details Call release() after using the items.
+   */
+  uint32_t peek(T **item) {
+    if (!_q) {
+      return 0;
+    }
+    uint32_t tail = _q->tail;
+    uint32_t n = wait_items(tail);
+    uint32_t idx = tail & (N - 1);
+    if (n > N - idx) {
+      n = N - idx;
+    }
+    *item = &_q->items[idx];
+    return n;
+  };
+
+  /**
+   * @brief Release the items got by peek()
+   * @param [in] num - number of items to release
+   */
+  void release(uint32_t num) {
+    if (!_q || (num == 0)) {
+      return;
+    }
+    /* Finish reading the items before the producer overwrites them */
+    MP_DMB();
+    uint32_t tail = _q->tail + num;
+    _q->tail = tail;
+    wakeup(TX, N - (_q->head - tail));
+  };
+
+  /**
+   * @brief Get the number of items in the queue
+   */
+  uint32_t available() {
+    return _q ? (_q->head - _q->tail) : 0;
+  };
+
+  /**
+   * @brief Get the number of free items in the queue
+   */
+  uint32_t space() {
+    return _q ? (N - (_q->head - _q->tail)) : 0;
+  };
+
+private:
+  enum { RX = 0, TX = 1 };
+
+  /* head and tail are free-running counters, so N must be power of 2. */
+  static_assert((N != 0) && ((N & (N - 1)) == 0), "N must be power of 2");
+
+  struct Queue {
+    uint32_t magic;
+    uint32_t num;
+    uint32_t itemsize;
+    volatile uint32_t head;
+    volatile uint32_t tail;
+    volatile uint32_t waiting[2];
+    uint32_t reserved;
+    T items[N];
+  };
+
+  Queue  *_q;
+  bool   _allocated;
+  int8_t _msgid;
+  int    _subid;
+
+  void init(void *addr) {
+    _q = (Queue *)addr;
+    _q->num = N;
+    _q->itemsize = sizeof(T);
+    _q->head = 0;
+    _q->tail = 0;
+    _q->waiting[RX] = 0;
+    _q->waiting[TX] = 0;
+    MP_DMB();
+    _q->magic = MP_QUEUE_MAGIC;
+  };
+
+  uint32_t wait_items(uint32_t tail) {
+    uint32_t n = _q->head - tail;
+    if (n == 0) {
+      /* Request to notify when the queue is not empty */
+      _q->waiting[RX] = 1;
+      MP_DMB();
+      n = _q->head - tail;
+    }
+    /* Read the items after the position */
+    MP_DMB();
+    return n;
+  };
+
+  void wakeup(int side, uint32_t count) {
+    /* Check the request after the position is updated */
+    MP_DMB();
+    if (_q->waiting[side]) {
+      _q->waiting[side] = 0;
+      if (_msgid >= 0) {
+        MP.Send(_msgid, count, _subid);
+      }
+    }
+  };
+};
+
+/** @} mpqueue */
+
+#endif /* _MPQUEUE_H_ */
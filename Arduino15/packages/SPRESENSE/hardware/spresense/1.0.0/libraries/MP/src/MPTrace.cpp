@@ -0,0 +1,556 @@
+/*
+ *  MPTrace.cpp - Spresense Arduino Multi-Processer Trace library
+ *  Copyright 2019 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <sdk/config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "MP.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define TRACE_MAGIC 0x4352544d
+
+#ifdef SUBCORE
+#define TRACE_CORE  SUBCORE
+#else
+#define TRACE_CORE  0
+#endif
+
+#define TRACE_LINE_SIZE (192)
+#define TRACE_NAME_SIZE (96)
+#define TRACE_FLOW_ID(src, dst, seq) \
+  ((((src) * MP_MAX_SUBID + (dst)) << 20) | ((seq) & 0xfffff))
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* Shared by all cores. Each core writes only to its own ring. */
+
+struct MPTracer::Shared {
+  uint32_t magic;
+  uint32_t start;            /* cycle counter of MainCore at begin() */
+  volatile uint32_t stop;    /* cycle counter of MainCore at stop() */
+  volatile uint32_t stopped;
+  Ring     ring[MP_MAX_SUBID];
+};
+
+struct MPTracer::Stats {
+  struct Channel {
+    uint32_t sent;
+    uint32_t recvd;
+    uint32_t maxdepth;
+    uint32_t num;
+    uint64_t sum;
+    uint64_t min;
+    uint64_t max;
+    uint64_t fifo[MPTRACE_FIFO_NUM];
+  } ch[MP_MAX_SUBID][MP_MAX_SUBID]; /* [sender][receiver] */
+  uint32_t events[MP_MAX_SUBID];
+  uint32_t dropped[MP_MAX_SUBID];
+  uint64_t busy[MP_MAX_SUBID];
+  uint64_t span;
+};
+
+/****************************************************************************
+ * Public Data
+ ****************************************************************************/
+
+MPTracer MPTrace;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+#ifndef SUBCORE
+static const char *core_name(int core)
+{
+  static const char *name[MP_MAX_SUBID] = {
+    "Main", "Sub1", "Sub2", "Sub3", "Sub4", "Sub5"
+  };
+  return name[core];
+}
+
+/* Copy an event name as a JSON string body, truncated to fit */
+
+static char *trace_escape(char *buf, size_t size, const char *name)
+{
+  size_t n = 0;
+
+  for (; *name; name++) {
+    unsigned char ch = (unsigned char)*name;
+    char esc[8];
+    size_t len;
+
+    if ((ch == '"') || (ch == '\\')) {
+      esc[0] = '\\';
+      esc[1] = ch;
+      esc[2] = '\0';
+      len = 2;
+    } else if (ch < 0x20) {
+      len = snprintf(esc, sizeof(esc), "\\u%04x", ch);
+    } else {
+      esc[0] = ch;
+      esc[1] = '\0';
+      len = 1;
+    }
+    if (n + len >= size) {
+      break;
+    }
+    memcpy(&buf[n], esc, len);
+    n += len;
+  }
+  buf[n] = '\0';
+  return buf;
+}
+
+/* Convert a cycle counter of the core into the cycles from begin() */
+
+static uint64_t trace_time(uint32_t ts, uint32_t offset, uint32_t start,
+                           uint32_t *last, uint32_t *wraps)
+{
+  uint32_t d = ts + offset - start;
+  if (d < *last) {
+    (*wraps)++;
+  }
+  *last = d;
+  return ((uint64_t)*wraps << 32) | d;
+}
+
+static char *trace_us(char *buf, size_t size, uint64_t cycles, uint32_t cpm)
+{
+  snprintf(buf, size, "%lu.%03lu", (unsigned long)(cycles / cpm),
+           (unsigned long)((cycles % cpm) * 1000 / cpm));
+  return buf;
+}
+
+static void trace_emit(Print *json, bool *first, const char *line)
+{
+  if (!json) {
+    return;
+  }
+  json->print(*first ? "" : ",\n");
+  json->print(line);
+  *first = false;
+}
+#endif
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+MPTracer::MPTracer()
+{
+#ifndef SUBCORE
+  _shm = NULL;
+#endif
+}
+
+#ifndef SUBCORE
+int MPTracer::begin()
+{
+  if (_shm) {
+    return -EBUSY;
+  }
+
+  _shm = (Shared *)MP.AllocSharedMemory(sizeof(Shared));
+  if (!_shm) {
+    return -ENOMEM;
+  }
+
+  memset(_shm, 0, sizeof(Shared));
+  MP_ENABLE_CYCCNT();
+  _shm->start = MP_GET_CYCCNT();
+  _shm->magic = TRACE_MAGIC;
+  MP_DMB();
+
+  /* Start recording on all cores */
+  MP._rmng->trace = (uint32_t)(uintptr_t)_shm;
+
+  return 0;
+}
+
+void MPTracer::stop()
+{
+  if (!_shm || _shm->stopped) {
+    return;
+  }
+
+  MP._rmng->trace = 0;
+  _shm->stop = MP_GET_CYCCNT();
+  _shm->stopped = 1;
+  MP_DMB();
+}
+
+void MPTracer::end()
+{
+  if (!_shm) {
+    return;
+  }
+
+  stop();
+
+  MP.FreeSharedMemory(_shm);
+  _shm = NULL;
+}
+
+void MPTracer::report()
+{
+  if (!_shm) {
+    return;
+  }
+
+  Stats *st = (Stats *)malloc(sizeof(Stats));
+  if (!st) {
+    MPERR("Out of memory\n");
+    return;
+  }
+
+  process(NULL, st);
+
+  uint32_t cpm = clockCyclesPerMicrosecond();
+  uint32_t span = st->span / cpm;
+
+  printf("Trace: %lu us\n", span);
+  printf("Core  Events Dropped  Busy[us] Util[%%]\n");
+  for (int c = 0; c < MP_MAX_SUBID; c++) {
+    if (!st->events[c] && !st->dropped[c]) {
+      continue;
+    }
+    uint32_t busy = st->busy[c] / cpm;
+    uint32_t util = span ? (uint32_t)((uint64_t)busy * 1000 / span) : 0;
+    printf("%-5s %6lu %7lu %9lu %3lu.%lu\n", core_name(c),
+           st->events[c], st->dropped[c], busy, util / 10, util % 10);
+  }
+
+  printf("Channel    Msgs  Latency min/avg/max[us] MaxDepth\n");
+  for (int s = 0; s < MP_MAX_SUBID; s++) {
+    for (int r = 0; r < MP_MAX_SUBID; r++) {
+      Stats::Channel *ch = &st->ch[s][r];
+      if (!ch->sent) {
+        continue;
+      }
+      uint32_t avg = ch->num ? (uint32_t)(ch->sum / ch->num / cpm) : 0;
+      printf("%s>%s %6lu %7lu/%7lu/%7lu %8lu\n", core_name(s), core_name(r),
+             ch->sent, (uint32_t)(ch->min / cpm), avg,
+             (uint32_t)(ch->max / cpm), ch->maxdepth);
+    }
+  }
+
+  free(st);
+}
+
+int MPTracer::exportJson(Print &out)
+{
+  if (!_shm) {
+    return -ENODEV;
+  }
+
+  Stats *st = (Stats *)malloc(sizeof(Stats));
+  if (!st) {
+    return -ENOMEM;
+  }
+
+  process(&out, st);
+
+  free(st);
+
+  return 0;
+}
+#endif
+
+void MPTracer::enter(const char *name)
+{
+  record(EV_BEGIN, name, 0);
+}
+
+void MPTracer::leave(const char *name)
+{
+  record(EV_END, name, 0);
+}
+
+void MPTracer::instant(const char *name)
+{
+  record(EV_INSTANT, name, 0);
+}
+
+void MPTracer::counter(const char *name, int32_t value)
+{
+  record(EV_COUNTER, name, value);
+}
+
+MPTraceScope::MPTraceScope(const char *name) : _name(name)
+{
+  MPTrace.enter(name);
+}
+
+MPTraceScope::~MPTraceScope()
+{
+  MPTrace.leave(_name);
+}
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+void MPTracer::record(uint8_t type, const char *name, int32_t value, int peer)
+{
+  Shared *shm = (Shared *)MP._rmng->trace;
+  if (!shm || (shm->magic != TRACE_MAGIC)) {
+    return;
+  }
+
+  Ring *ring = &shm->ring[TRACE_CORE];
+
+  /* Serialize the tasks on this core only */
+  irqstate_t flags = enter_critical_section();
+
+  uint32_t head = ring->head;
+  if (head >= MPTRACE_EVENT_NUM) {
+    ring->dropped++;
+    leave_critical_section(flags);
+    return;
+  }
+
+  Event *ev = &ring->ev[head];
+  ev->ts    = MP_GET_CYCCNT();
+  ev->name  = name ? MP.Virt2Phys((void *)name) : 0;
+  ev->type  = type;
+  ev->peer  = peer;
+  ev->value = value;
+
+  /* Publish the event before the position */
+  MP_DMB();
+  ring->head = head + 1;
+
+  leave_critical_section(flags);
+}
+
+void MPTracer::message(bool send, int8_t msgid, int peer)
+{
+  record(send ? EV_SEND : EV_RECV, NULL, msgid, peer);
+}
+
+#ifndef SUBCORE
+/* Merge the events of all cores in time order, and calculate statistics.
+ * If json is not NULL, write the events in Chrome trace JSON format.
+ */
+
+int MPTracer::process(Print *json, Stats *st)
+{
+  uint32_t count[MP_MAX_SUBID];
+  uint32_t idx[MP_MAX_SUBID];
+  uint32_t last[MP_MAX_SUBID];
+  uint32_t wraps[MP_MAX_SUBID];
+  uint32_t depth[MP_MAX_SUBID];
+  uint64_t next[MP_MAX_SUBID];
+  uint64_t busy_start[MP_MAX_SUBID];
+  uint32_t cpm = clockCyclesPerMicrosecond();
+  uint64_t tmax = 0;
+  bool first = true;
+  char line[TRACE_LINE_SIZE];
+  char name[TRACE_NAME_SIZE];
+  char ts[16];
+
+  memset(st, 0, sizeof(Stats));
+
+  for (int c = 0; c < MP_MAX_SUBID; c++) {
+    count[c] = _shm->ring[c].head;
+    st->events[c] = count[c];
+    st->dropped[c] = _shm->ring[c].dropped;
+    idx[c] = 0;
+    last[c] = 0;
+    wraps[c] = 0;
+    depth[c] = 0;
+    busy_start[c] = 0;
+  }
+
+  /* Read the events after the positions */
+  MP_DMB();
+
+  for (int c = 0; c < MP_MAX_SUBID; c++) {
+    if (count[c]) {
+      next[c] = trace_time(_shm->ring[c].ev[0].ts, MP._cycoffset[c],
+                           _shm->start, &last[c], &wraps[c]);
+    }
+  }
+
+  if (json) {
+    json->print("{\"traceEvents\":[\n");
+    for (int c = 0; c < MP_MAX_SUBID; c++) {
+      snprintf(line, sizeof(line),
+               "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,"
+               "\"args\":{\"name\":\"%s\"}}", c, core_name(c));
+      trace_emit(json, &first, line);
+    }
+  }
+
+  for (;;) {
+    int c = -1;
+    for (int i = 0; i < MP_MAX_SUBID; i++) {
+      if ((idx[i] < count[i]) && ((c < 0) || (next[i] < next[c]))) {
+        c = i;
+      }
+    }
+    if (c < 0) {
+      break;
+    }
+
+    Event *ev = &_shm->ring[c].ev[idx[c]];
+    uint64_t t = next[c];
+
+    trace_escape(name, sizeof(name), ev->name ? (const char *)ev->name : "");
+    trace_us(ts, sizeof(ts), t, cpm);
+    if (t > tmax) {
+      tmax = t;
+    }
+
+    switch (ev->type) {
+      case EV_BEGIN:
+        if (depth[c]++ == 0) {
+          busy_start[c] = t;
+        }
+        snprintf(line, sizeof(line),
+                 "{\"name\":\"%s\",\"ph\":\"B\",\"ts\":%s,\"pid\":0,\"tid\":%d}",
+                 name, ts, c);
+        trace_emit(json, &first, line);
+        break;
+
+      case EV_END:
+        if ((depth[c] > 0) && (--depth[c] == 0)) {
+          st->busy[c] += t - busy_start[c];
+        }
+        snprintf(line, sizeof(line),
+                 "{\"name\":\"%s\",\"ph\":\"E\",\"ts\":%s,\"pid\":0,\"tid\":%d}",
+                 name, ts, c);
+        trace_emit(json, &first, line);
+        break;
+
+      case EV_INSTANT:
+        snprintf(line, sizeof(line),
+                 "{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%s,"
+                 "\"pid\":0,\"tid\":%d}", name, ts, c);
+        trace_emit(json, &first, line);
+        break;
+
+      case EV_COUNTER:
+        snprintf(line, sizeof(line),
+                 "{\"name\":\"%s\",\"ph\":\"C\",\"ts\":%s,\"pid\":0,\"tid\":%d,"
+                 "\"args\":{\"value\":%ld}}", name, ts, c, (long)ev->value);
+        trace_emit(json, &first, line);
+        break;
+
+      case EV_SEND:
+      case EV_RECV:
+        {
+          bool send = (ev->type == EV_SEND);
+          int src = send ? c : ev->peer;
+          int dst = send ? ev->peer : c;
+          uint32_t seq;
+
+          if ((src >= MP_MAX_SUBID) || (dst >= MP_MAX_SUBID)) {
+            break;
+          }
+
+          Stats::Channel *ch = &st->ch[src][dst];
+
+          if (send) {
+            seq = ch->sent;
+            ch->fifo[seq % MPTRACE_FIFO_NUM] = t;
+            ch->sent++;
+          } else {
+            /* Message sent before begin() is not counted */
+            if (ch->recvd >= ch->sent) {
+              break;
+            }
+            seq = ch->recvd;
+            if ((ch->sent - seq) <= MPTRACE_FIFO_NUM) {
+              uint64_t latency = t - ch->fifo[seq % MPTRACE_FIFO_NUM];
+              if (!ch->num || (latency < ch->min)) {
+                ch->min = latency;
+              }
+              if (latency > ch->max) {
+                ch->max = latency;
+              }
+              ch->sum += latency;
+              ch->num++;
+            }
+            ch->recvd++;
+          }
+
+          uint32_t qdepth = ch->sent - ch->recvd;
+          if (qdepth > ch->maxdepth) {
+            ch->maxdepth = qdepth;
+          }
+
+          snprintf(line, sizeof(line),
+                   "{\"name\":\"%s %d\",\"cat\":\"mp\",\"ph\":\"i\",\"s\":\"t\","
+                   "\"ts\":%s,\"pid\":0,\"tid\":%d,\"args\":{\"%s\":\"%s\"}}",
+                   send ? "Send" : "Recv", (int)ev->value, ts, c,
+                   send ? "to" : "from", core_name(send ? dst : src));
+          trace_emit(json, &first, line);
+
+          /* Flow arrow from Send to Recv */
+          snprintf(line, sizeof(line),
+                   "{\"name\":\"msg\",\"cat\":\"mp\",\"ph\":\"%s\",%s"
+                   "\"id\":%lu,\"ts\":%s,\"pid\":0,\"tid\":%d}",
+                   send ? "s" : "f", send ? "" : "\"bp\":\"e\",",
+                   (unsigned long)TRACE_FLOW_ID(src, dst, seq), ts, c);
+          trace_emit(json, &first, line);
+
+          snprintf(line, sizeof(line),
+                   "{\"name\":\"mq %s>%s\",\"ph\":\"C\",\"ts\":%s,\"pid\":0,"
+                   "\"args\":{\"depth\":%lu}}",
+                   core_name(src), core_name(dst), ts, (unsigned long)qdepth);
+          trace_emit(json, &first, line);
+        }
+        break;
+
+      default:
+        break;
+    }
+
+    if (++idx[c] < count[c]) {
+      next[c] = trace_time(_shm->ring[c].ev[idx[c]].ts, MP._cycoffset[c],
+                           _shm->start, &last[c], &wraps[c]);
+    }
+  }
+
+  /* Busy until the end of the trace */
+  uint32_t end = (_shm->stopped ? _shm->stop : MP_GET_CYCCNT()) - _shm->start;
+  st->span = (end > tmax) ? end : tmax;
+  for (int c = 0; c < MP_MAX_SUBID; c++) {
+    if (depth[c] > 0) {
+      st->busy[c] += st->span - busy_start[c];
+    }
+  }
+
+  if (json) {
+    json->print("\n]}\n");
+  }
+
+  return 0;
+}
+#endif
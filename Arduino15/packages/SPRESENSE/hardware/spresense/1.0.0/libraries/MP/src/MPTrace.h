@@ -0,0 +1,202 @@
+/*
+ *  MPTrace.h - Spresense Arduino Multi-Processer Trace library
+ *  Copyright 2019 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _MPTRACE_H_
+#define _MPTRACE_H_
+
+/**
+ * @file MPTrace.h
+ * @author Sony Semiconductor Solutions Corporation
+ * @brief Spresense Arduino Multi-Processer Trace library
+ *
+ * @details After MPTrace.begin() on MainCore, each core records timestamped
+ *          events into its own buffer in the shared memory, and MP.Send()
+ *          and MP.Recv() are recorded automatically. MainCore reports the
+ *          utilization of each core, the message latency and the message
+ *          queue depth, and exports the events in Chrome trace JSON format.
+ *          Event names must stay in memory, so use string literals.
+ */
+
+/**
+ * @defgroup mptrace MP Trace Library API
+ * @brief MP Trace API
+ * @{
+ */
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <stdint.h>
+#include <Print.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define MPTRACE_EVENT_NUM (1024) /* Number of events per core */
+#define MPTRACE_FIFO_NUM  (16)   /* Messages in flight to measure latency */
+
+/** Trace the current scope */
+#define MPTRACE_SCOPE(name) MPTraceScope _mptrace_scope(name)
+
+/****************************************************************************
+ * class declaration
+ ****************************************************************************/
+
+/**
+ * @class MPTracer
+ * @brief This is the interface for MP Trace.
+ *
+ * @details Timestamps are the DWT cycle counter of each core. The counters
+ *          of SubCores are aligned to MainCore at MP.begin(), so start
+ *          SubCores by MP.begin() of this library. A buffer stops recording
+ *          when it is full, and the count of dropped events is reported.
+ */
+class MPTracer
+{
+public:
+  MPTracer();
+
+#ifndef SUBCORE
+  /**
+   * @brief Start recording on all cores
+   * @return error code. It returns minus value on failure.
+   * @retval -12(-ENOMEM) Out of shared memory
+   * @retval -16(-EBUSY) Already started
+   */
+  int begin();
+
+  /**
+   * @brief Stop recording on all cores
+   * @details The recorded events are kept until end().
+   */
+  void stop();
+
+  /**
+   * @brief Stop recording, and free the buffers
+   */
+  void end();
+
+  /**
+   * @brief Print the statistics of the recorded events
+   * @details Busy time of each core is the time inside enter() and leave().
+   *          Latency is from MP.Send() to MP.Recv() of the same message.
+   */
+  void report();
+
+  /**
+   * @brief Write the recorded events in Chrome trace JSON format
+   * @param [in] out - output such as Serial or File
+   * @return error code. It returns minus value on failure.
+   * @retval -19(-ENODEV) Not started
+   * @retval -12(-ENOMEM) Out of memory
+   */
+  int exportJson(Print &out);
+#endif
+
+  /**
+   * @brief Record the beginning of a section
+   * @param [in] name - name of the section
+   */
+  void enter(const char *name);
+
+  /**
+   * @brief Record the end of a section
+   * @param [in] name - name of the section
+   */
+  void leave(const char *name);
+
+  /**
+   * @brief Record an instant event
+   * @param [in] name - name of the event
+   */
+  void instant(const char *name);
+
+  /**
+   * @brief Record a value such as a queue depth
+   * @param [in] name - name of the counter
+   * @param [in] value - value of the counter
+   */
+  void counter(const char *name, int32_t value);
+
+private:
+  friend class MPClass;
+
+  enum {
+    EV_BEGIN,
+    EV_END,
+    EV_INSTANT,
+    EV_COUNTER,
+    EV_SEND,
+    EV_RECV,
+  };
+
+  struct Event {
+    uint32_t ts;
+    uint32_t name;
+    uint8_t  type;
+    uint8_t  peer;
+    uint16_t reserved;
+    int32_t  value;
+  };
+
+  struct Ring {
+    volatile uint32_t head;
+    volatile uint32_t dropped;
+    uint32_t reserved[2];
+    Event    ev[MPTRACE_EVENT_NUM];
+  };
+
+  struct Shared;
+  struct Stats;
+
+  void record(uint8_t type, const char *name, int32_t value, int peer = 0);
+  void message(bool send, int8_t msgid, int peer);
+
+#ifndef SUBCORE
+  Shared *_shm;
+
+  int process(Print *json, Stats *stats);
+#endif
+};
+
+/**
+ * @class MPTraceScope
+ * @brief Record a section from the constructor to the destructor.
+ */
+class MPTraceScope
+{
+public:
+  MPTraceScope(const char *name);
+  ~MPTraceScope();
+
+private:
+  const char *_name;
+};
+
+/****************************************************************************
+ * extern declaration
+ ****************************************************************************/
+
+extern MPTracer MPTrace;
+
+/** @} mptrace */
+
+#endif /* _MPTRACE_H_ */
@@ -0,0 +1,218 @@
+/*
+ *  MemoryPoolLayout.h - Memory pool layout builder for the Spresense SDK
+ *  Copyright 2019 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef MemoryPoolLayout_h
+#define MemoryPoolLayout_h
+
+/**
+ * @file MemoryPoolLayout.h
+ * @brief Build a layout of the static memory pools in the sketch.
+ *
+ * @details The pools of memutil/pool_layout.h are placed by
+ *          tools/mem_layout.py. This header places the pools in the same
+ *          way with constexpr functions, so a layout can be sized in the
+ *          sketch and checked at compile time.
+ *
+ *          constexpr PoolLayoutEntry player_pools[] = {
+ *            //  pool_ID                  type       seg fence align size
+ *            { S0_DEC_ES_MAIN_BUF_POOL, BasicType,   4, true,  8, 6144 * 4 },
+ *            { S0_REND_PCM_BUF_POOL,    BasicType,   5, true,  8, 18000 * 5 },
+ *            ...
+ *          };
+ *          MEMORY_POOL_LAYOUT_ASSERT(player_pools);
+ *
+ *          MemoryUtil.setLayout(0, player_pools, POOL_LAYOUT_NUM(player_pools));
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <memutils/memory_manager/MemMgrTypes.h>
+
+/*--------------------------------------------------------------------------*/
+/* Same parameters as tools/mem_layout.py */
+
+#define POOL_LAYOUT_FENCE_SIZE  4
+#define POOL_LAYOUT_MIN_ALIGN   4
+#define POOL_LAYOUT_POOL_DATA   16  /* MemPool data of the Basic type */
+#define POOL_LAYOUT_SEG_DATA    2   /* Segment number queue and reference counter */
+
+/** Layout number recorded by the MemoryManager for a layout of the sketch */
+
+#define POOL_LAYOUT_USER_NO     (MemMgrLite::BadLayoutNo - 1)
+
+/** Number of entries of a layout array */
+
+#define POOL_LAYOUT_NUM(entries) (sizeof(entries) / sizeof((entries)[0]))
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @struct PoolLayoutEntry
+ * @brief Pool of a layout. The address is decided by the order of entries.
+ */
+
+struct PoolLayoutEntry
+{
+  MemMgrLite::PoolId   id;
+  MemMgrLite::PoolType type;
+  MemMgrLite::NumSeg   num_segs;
+  bool                 fence;
+  uint32_t             align;
+  uint32_t             size;
+};
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief Placement of the pools. Each function is a single expression,
+ *        so all of them can be evaluated at compile time.
+ */
+
+namespace PoolLayout
+{
+
+constexpr uint32_t roundUp(uint32_t val, uint32_t align)
+{
+  return (val + align - 1) / align * align;
+}
+
+constexpr uint32_t fenceSize(const PoolLayoutEntry &entry)
+{
+  return entry.fence ? POOL_LAYOUT_FENCE_SIZE : 0;
+}
+
+/* Address of the pool placed at top. The lower fence is put before it. */
+
+constexpr uint32_t placeAddr(const PoolLayoutEntry &entry, uint32_t top)
+{
+  return roundUp(top + fenceSize(entry), entry.align);
+}
+
+/* Next top after the pool and the upper fence */
+
+constexpr uint32_t placeEnd(const PoolLayoutEntry &entry, uint32_t top)
+{
+  return placeAddr(entry, top) + entry.size + fenceSize(entry);
+}
+
+/* Top of the free area after num pools are placed from area_addr */
+
+constexpr uint32_t topOf(const PoolLayoutEntry *entries,
+                         size_t num,
+                         uint32_t area_addr)
+{
+  return (num == 0) ? area_addr :
+         placeEnd(entries[num - 1], topOf(entries, num - 1, area_addr));
+}
+
+/** Address of the pool of the index */
+
+constexpr uint32_t poolAddr(const PoolLayoutEntry *entries,
+                            size_t index,
+                            uint32_t area_addr)
+{
+  return placeAddr(entries[index], topOf(entries, index, area_addr));
+}
+
+/** Size used in the area, including the fences and the skips for align */
+
+constexpr uint32_t usedSize(const PoolLayoutEntry *entries,
+                            size_t num,
+                            uint32_t area_addr)
+{
+  return topOf(entries, num, area_addr) - area_addr;
+}
+
+/** Work area used by the MemoryManager for the pools */
+
+constexpr uint32_t workSize(const PoolLayoutEntry *entries, size_t num)
+{
+  return (num == 0) ? 0 :
+         roundUp(POOL_LAYOUT_POOL_DATA +
+                 POOL_LAYOUT_SEG_DATA * entries[num - 1].num_segs,
+                 POOL_LAYOUT_MIN_ALIGN) +
+         workSize(entries, num - 1);
+}
+
+/** Same checks of a pool as tools/mem_layout.py */
+
+constexpr bool isValidEntry(const PoolLayoutEntry &entry)
+{
+  return entry.type == MemMgrLite::BasicType &&
+         entry.align != 0 && (entry.align % POOL_LAYOUT_MIN_ALIGN) == 0 &&
+         entry.size != 0 && (entry.size % POOL_LAYOUT_MIN_ALIGN) == 0 &&
+         entry.num_segs != 0 && entry.size >= entry.num_segs;
+}
+
+constexpr bool isValidEntries(const PoolLayoutEntry *entries, size_t num)
+{
+  return (num == 0) ? true :
+         isValidEntry(entries[num - 1]) && isValidEntries(entries, num - 1);
+}
+
+/* The pools are placed in order, so they never overlap as long as each of
+ * them ends in the area. The end is compared in 64 bits not to wrap around.
+ */
+
+constexpr bool isInArea(const PoolLayoutEntry *entries,
+                        size_t num,
+                        uint32_t area_addr,
+                        uint32_t area_size)
+{
+  return (num == 0) ? true :
+         isInArea(entries, num - 1, area_addr, area_size) &&
+         entries[num - 1].align <= area_size &&
+         (uint64_t)placeAddr(entries[num - 1],
+                             topOf(entries, num - 1, area_addr)) +
+         entries[num - 1].size + fenceSize(entries[num - 1]) <=
+         (uint64_t)area_addr + area_size;
+}
+
+/** All of the checks done by MemoryUtilClass::setLayout() */
+
+constexpr bool isValid(const PoolLayoutEntry *entries,
+                       size_t num,
+                       uint32_t area_addr,
+                       uint32_t area_size,
+                       uint32_t work_size)
+{
+  return num != 0 &&
+         isValidEntries(entries, num) &&
+         isInArea(entries, num, area_addr, area_size) &&
+         workSize(entries, num) <= work_size;
+}
+
+} /* namespace PoolLayout */
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief Check a layout of section 0 at compile time.
+ *
+ * @details The pools are placed in COMMON_WORK_AREA, and the work area of
+ *          the MemoryManager is S0_MEMMGR_WORK_AREA.
+ */
+
+#define MEMORY_POOL_LAYOUT_ASSERT(entries) \
+  static_assert(PoolLayout::isValid(entries, \
+                                    POOL_LAYOUT_NUM(entries), \
+                                    COMMON_WORK_AREA_ADDR, \
+                                    COMMON_WORK_AREA_SIZE, \
+                                    S0_MEMMGR_WORK_AREA_SIZE), \
+                "Bad memory pool layout: " #entries)
+
+#endif /* MemoryPoolLayout_h */
@@ -94,23 +94,29 @@ int MemoryUtilClass::begin(void)
 }
 
 /*--------------------------------------------------------------------------*/
-int MemoryUtilClass::setLayout(uint8_t sec_no, uint8_t layout_no)
+static void getWorkArea(uint8_t sec_no, void **work_va, uint32_t *work_sz)
 {
-  void                  *work_va;
-  uint32_t               work_sz;
-  const PoolSectionAttr *ptr; 
-
   switch(sec_no)
     {
     case 0:
-      work_va = translatePoolAddrToVa(S0_MEMMGR_WORK_AREA_ADDR);
-      work_sz = S0_MEMMGR_WORK_AREA_SIZE;
+      *work_va = translatePoolAddrToVa(S0_MEMMGR_WORK_AREA_ADDR);
+      *work_sz = S0_MEMMGR_WORK_AREA_SIZE;
       break;
     default:
-      work_va = translatePoolAddrToVa(S1_MEMMGR_WORK_AREA_ADDR);
-      work_sz = S1_MEMMGR_WORK_AREA_SIZE;
+      *work_va = translatePoolAddrToVa(S1_MEMMGR_WORK_AREA_ADDR);
+      *work_sz = S1_MEMMGR_WORK_AREA_SIZE;
       break;
     }
+}
+
+/*--------------------------------------------------------------------------*/
+int MemoryUtilClass::setLayout(uint8_t sec_no, uint8_t layout_no)
+{
+  void                  *work_va;
+  uint32_t               work_sz;
+  const PoolSectionAttr *ptr; 
+
+  getWorkArea(sec_no, &work_va, &work_sz);
 
   ptr = &MemoryPoolLayouts[sec_no][layout_no][0];
 
@@ -123,6 +129,98 @@ int MemoryUtilClass::setLayout(uint8_t sec_no, uint8_t layout_no)
   return 0;
 }
 
+/*--------------------------------------------------------------------------*/
+/* The MemoryManager keeps the pointer to the attributes, so the layout of
+ * the sketch is converted into this table.
+ */
+
+static PoolSectionAttr s_user_layout[NUM_MEM_SECTIONS][NUM_MEM_POOLS];
+
+int MemoryUtilClass::setLayout(uint8_t sec_no,
+                               const PoolLayoutEntry *entries,
+                               uint8_t num,
+                               uint32_t area_addr,
+                               uint32_t area_size)
+{
+  void     *work_va;
+  uint32_t  work_sz;
+  bool      used[NUM_MEM_POOLS] = { false };
+
+  if (sec_no >= NUM_MEM_SECTIONS || entries == NULL ||
+      num == 0 || num >= pool_num[sec_no])
+    {
+      printf("Bad memory pool layout. sec=%d num=%d\n", sec_no, num);
+      return 1;
+    }
+
+  getWorkArea(sec_no, &work_va, &work_sz);
+
+  if (!PoolLayout::isValidEntries(entries, num))
+    {
+      printf("Bad memory pool parameter.\n");
+      return 1;
+    }
+
+  if (!PoolLayout::isInArea(entries, num, area_addr, area_size))
+    {
+      printf("Memory pools over the area. used=0x%08lx size=0x%08lx\n",
+             (unsigned long)PoolLayout::usedSize(entries, num, area_addr),
+             (unsigned long)area_size);
+      return 1;
+    }
+
+  if (PoolLayout::workSize(entries, num) > work_sz)
+    {
+      printf("Memory manager work area over. used=0x%08lx size=0x%08lx\n",
+             (unsigned long)PoolLayout::workSize(entries, num),
+             (unsigned long)work_sz);
+      return 1;
+    }
+
+  PoolSectionAttr *layout = s_user_layout[sec_no];
+  uint32_t         top    = area_addr;
+
+  for (uint8_t i = 0; i < num; i++)
+    {
+      const PoolLayoutEntry &entry = entries[i];
+
+      if (entry.id.sec != sec_no ||
+          entry.id.pool == 0 || entry.id.pool >= pool_num[sec_no] ||
+          used[entry.id.pool])
+        {
+          printf("Bad memory pool ID. index=%d\n", i);
+          return 1;
+        }
+      used[entry.id.pool] = true;
+
+      PoolSectionAttr attr = {
+        entry.id,
+        entry.type,
+        entry.num_segs,
+        entry.fence,
+        PoolLayout::placeAddr(entry, top),
+        entry.size
+      };
+      layout[i] = attr;
+      top = PoolLayout::placeEnd(entry, top);
+    }
+
+  PoolSectionAttr null_attr = { { 0, sec_no }, 0, 0, false, 0, 0 };
+  layout[num] = null_attr;
+
+  if (Manager::createStaticPools(sec_no,
+                                 POOL_LAYOUT_USER_NO,
+                                 work_va,
+                                 work_sz,
+                                 layout) != ERR_OK)
+    {
+      printf("createStaticPools() failure.\n");
+      return 1;
+    }
+
+  return 0;
+}
+
 /*--------------------------------------------------------------------------*/
 int MemoryUtilClass::clearLayout(void)
 {
@@ -44,6 +44,8 @@
 #include "memutil/memory_layout.h"
 #endif
 
+#include "MemoryPoolLayout.h"
+
 using namespace MemMgrLite;
 
 /*--------------------------------------------------------------------------*/
@@ -77,6 +79,23 @@ public:
 
   int setLayout(uint8_t sec_no, uint8_t layout_no);
 
+  /**
+   * @brief Generate static memory pool group from a layout of the sketch.
+   *
+   * @details The pools are placed in order from area_addr with the same
+   *          fences and alignment as tools/mem_layout.py. The layout is
+   *          checked before any pool is created, and 1 is returned if the
+   *          pools do not fit in the area or in the work area of the
+   *          MemoryManager. The pool IDs must be of sec_no.
+   *          When both sections are used, give them separate areas.
+   */
+
+  int setLayout(uint8_t sec_no,
+                const PoolLayoutEntry *entries,
+                uint8_t num,
+                uint32_t area_addr = COMMON_WORK_AREA_ADDR,
+                uint32_t area_size = COMMON_WORK_AREA_SIZE);
+
   /**
    * @brief Destroy the static memory pool.
    *
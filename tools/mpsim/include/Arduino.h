@@ -0,0 +1,79 @@
+/*
+ *  Arduino.h - Arduino core for the host simulation
+ *  Copyright 2019 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _MPSIM_ARDUINO_H_
+#define _MPSIM_ARDUINO_H_
+
+/* The subset of the Spresense Arduino core used by the MP examples */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include <nuttx/irq.h>
+#include <Print.h>
+
+#define HIGH  0x1
+#define LOW   0x0
+
+#define LED0  (0)
+#define LED1  (1)
+#define LED2  (2)
+#define LED3  (3)
+
+#define ledOn(x)  digitalWrite(x, HIGH)
+#define ledOff(x) digitalWrite(x, LOW)
+
+/* The heap is shared by all cores */
+#define USER_HEAP_SIZE(size)
+
+class HardwareSerial : public Print
+{
+public:
+  void begin(unsigned long baud) { (void)baud; };
+  void end() {};
+  operator bool() { return true; };
+  size_t write(uint8_t c);
+  size_t write(const uint8_t *buffer, size_t size);
+};
+
+extern HardwareSerial Serial;
+
+extern bool g_rtc_enabled;
+
+void digitalWrite(uint8_t pin, uint8_t value);
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+void interrupts(void);
+void noInterrupts(void);
+unsigned long clockCyclesPerMicrosecond(void);
+
+#endif /* _MPSIM_ARDUINO_H_ */
@@ -0,0 +1,68 @@
+/*
+ *  Audio.h - Audio recorder for the host simulation
+ *  Copyright 2019 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _MPSIM_AUDIO_H_
+#define _MPSIM_AUDIO_H_
+
+/* PCM recorder generating a sine wave of 1kHz x (channel + 1) in real time.
+ * readFrames() returns the requested size once that much time has passed.
+ */
+
+#include <stdint.h>
+
+#define AUDIOLIB_ECODE_OK                          0
+#define AUDIOLIB_ECODE_INSUFFICIENT_BUFFER_AREA    8
+#define AUDIOLIB_ECODE_STATE_ERROR                 9
+
+#define AS_SETRECDR_STS_INPUTDEVICE_MIC  0
+#define AS_CODECTYPE_PCM                 2
+#define AS_SAMPLINGRATE_48000            48000
+#define AS_CHANNEL_MONO                  1
+#define AS_CHANNEL_STEREO                2
+#define AS_CHANNEL_4CH                   4
+
+#define MPSIM_AUDIO_FREQ  (1000) /* frequency of channel 0 [Hz] */
+
+typedef int err_t;
+
+class AudioClass
+{
+public:
+  static AudioClass *getInstance();
+
+  err_t begin(void);
+  err_t end(void);
+  err_t setRecorderMode(uint8_t input_device, int32_t input_gain = 0);
+  err_t initRecorder(uint8_t codec_type, const char *codec_path,
+                     uint32_t sampling_rate, uint8_t channel);
+  err_t startRecorder(void);
+  err_t stopRecorder(void);
+  err_t readFrames(char *buffer, uint32_t buffer_size, uint32_t *read_size);
+
+private:
+  AudioClass();
+
+  uint32_t _rate;
+  uint8_t  _channel;
+  bool     _running;
+  uint64_t _start;
+  uint64_t _frames;
+};
+
+#endif /* _MPSIM_AUDIO_H_ */
@@ -0,0 +1,51 @@
+/*
+ *  Print.h - Print class for the host simulation
+ *  Copyright 2019 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _MPSIM_PRINT_H_
+#define _MPSIM_PRINT_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+class Print
+{
+public:
+  virtual ~Print() {};
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t *buffer, size_t size);
+
+  size_t print(const char *str);
+  size_t print(char c);
+  size_t print(int n);
+  size_t print(unsigned int n);
+  size_t print(long n);
+  size_t print(unsigned long n);
+  size_t print(double n, int digits = 2);
+
+  size_t println(void);
+  size_t println(const char *str);
+  size_t println(char c);
+  size_t println(int n);
+  size_t println(unsigned int n);
+  size_t println(long n);
+  size_t println(unsigned long n);
+  size_t println(double n, int digits = 2);
+};
+
+#endif /* _MPSIM_PRINT_H_ */
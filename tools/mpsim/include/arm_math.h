@@ -0,0 +1,68 @@
+/*
+ *  arm_math.h - CMSIS DSP functions for the host simulation
+ *  Copyright 2019 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _MPSIM_ARM_MATH_H_
+#define _MPSIM_ARM_MATH_H_
+
+/* Reference implementation of the CMSIS DSP functions used by the MP
+ * examples. The output formats are the same as CMSIS.
+ */
+
+#include <stdint.h>
+
+typedef int16_t q15_t;
+typedef int32_t q31_t;
+typedef float   float32_t;
+
+typedef enum {
+  ARM_MATH_SUCCESS        = 0,
+  ARM_MATH_ARGUMENT_ERROR = -1,
+} arm_status;
+
+typedef struct {
+  uint16_t fftLenRFFT;
+} arm_rfft_fast_instance_f32;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+arm_status arm_rfft_fast_init_f32(arm_rfft_fast_instance_f32 *S, uint16_t fftLen);
+arm_status arm_rfft_32_fast_init_f32(arm_rfft_fast_instance_f32 *S);
+arm_status arm_rfft_64_fast_init_f32(arm_rfft_fast_instance_f32 *S);
+arm_status arm_rfft_128_fast_init_f32(arm_rfft_fast_instance_f32 *S);
+arm_status arm_rfft_256_fast_init_f32(arm_rfft_fast_instance_f32 *S);
+arm_status arm_rfft_512_fast_init_f32(arm_rfft_fast_instance_f32 *S);
+arm_status arm_rfft_1024_fast_init_f32(arm_rfft_fast_instance_f32 *S);
+arm_status arm_rfft_2048_fast_init_f32(arm_rfft_fast_instance_f32 *S);
+arm_status arm_rfft_4096_fast_init_f32(arm_rfft_fast_instance_f32 *S);
+void arm_rfft_fast_f32(const arm_rfft_fast_instance_f32 *S, float32_t *p,
+                       float32_t *pOut, uint8_t ifftFlag);
+
+void arm_cmplx_mag_f32(const float32_t *pSrc, float32_t *pDst, uint32_t numSamples);
+void arm_max_f32(const float32_t *pSrc, uint32_t blockSize,
+                 float32_t *pResult, uint32_t *pIndex);
+void arm_copy_q15(const q15_t *pSrc, q15_t *pDst, uint32_t blockSize);
+void arm_q15_to_float(const q15_t *pSrc, float32_t *pDst, uint32_t blockSize);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _MPSIM_ARM_MATH_H_ */
@@ -0,0 +1,26 @@
+/*
+ *  nvic.h - NVIC registers for the host simulation
+ *  Copyright 2019 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _MPSIM_ARMV7_M_NVIC_H_
+#define _MPSIM_ARMV7_M_NVIC_H_
+
+#define NVIC_IRQ_ENABLE(n)  (0xe000e100 + (((n) >> 5) << 2))
+#define NVIC_IRQ_CLEAR(n)   (0xe000e180 + (((n) >> 5) << 2))
+
+#endif /* _MPSIM_ARMV7_M_NVIC_H_ */
@@ -0,0 +1,29 @@
+/*
+ *  asmp.h - ASMP framework for the host simulation
+ *  Copyright 2019 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _MPSIM_ASMP_ASMP_H_
+#define _MPSIM_ASMP_ASMP_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <nuttx/queue.h>
+
+typedef uint8_t cpuid_t;
+
+#endif /* _MPSIM_ASMP_ASMP_H_ */
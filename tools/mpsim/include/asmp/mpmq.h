@@ -0,0 +1,52 @@
+/*
+ *  mpmq.h - ASMP message queue for the host simulation
+ *  Copyright 2019 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _MPSIM_ASMP_MPMQ_H_
+#define _MPSIM_ASMP_MPMQ_H_
+
+#include <asmp/asmp.h>
+
+#define MPMQ_NONBLOCK 0xffffffffu
+
+/* A queue receives the messages from cpuid to local, and sends the
+ * messages from local to cpuid.
+ */
+
+typedef struct mpmq_s {
+  cpuid_t cpuid;
+  cpuid_t local;
+  int     key;
+} mpmq_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int mpmq_init(mpmq_t *mq, int key, cpuid_t cpu);
+int mpmq_destroy(mpmq_t *mq);
+int mpmq_send(mpmq_t *mq, int8_t msgid, uint32_t data);
+int mpmq_trysend(mpmq_t *mq, int8_t msgid, uint32_t data);
+int mpmq_receive(mpmq_t *mq, uint32_t *data);
+int mpmq_timedreceive(mpmq_t *mq, uint32_t *data, uint32_t ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _MPSIM_ASMP_MPMQ_H_ */
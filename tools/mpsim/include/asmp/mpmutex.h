@@ -0,0 +1,31 @@
+/*
+ *  mpmutex.h - ASMP mutex for the host simulation
+ *  Copyright 2019 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _MPSIM_ASMP_MPMUTEX_H_
+#define _MPSIM_ASMP_MPMUTEX_H_
+
+#include <asmp/asmp.h>
+
+/* MPMutex accesses the hardware semaphore directly, see mpsim_getreg32() */
+
+typedef struct mpmutex_s {
+  int semid;
+} mpmutex_t;
+
+#endif /* _MPSIM_ASMP_MPMUTEX_H_ */
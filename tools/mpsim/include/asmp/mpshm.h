@@ -0,0 +1,48 @@
+/*
+ *  mpshm.h - ASMP shared memory for the host simulation
+ *  Copyright 2019 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _MPSIM_ASMP_MPSHM_H_
+#define _MPSIM_ASMP_MPSHM_H_
+
+#include <stddef.h>
+#include <asmp/asmp.h>
+
+typedef struct mpshm_s {
+  int   key;
+  int   tile;
+  int   num;
+  void *addr;
+} mpshm_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int mpshm_init(mpshm_t *shm, int key, size_t size);
+int mpshm_destroy(mpshm_t *shm);
+void *mpshm_attach(mpshm_t *shm, int shmflg);
+int mpshm_detach(mpshm_t *shm);
+uintptr_t mpshm_virt2phys(mpshm_t *shm, void *va);
+void *mpshm_phys2virt(mpshm_t *shm, uintptr_t pa);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _MPSIM_ASMP_MPSHM_H_ */
@@ -0,0 +1,54 @@
+/*
+ *  mptask.h - ASMP task for the host simulation
+ *  Copyright 2019 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _MPSIM_ASMP_MPTASK_H_
+#define _MPSIM_ASMP_MPTASK_H_
+
+#include <pthread.h>
+#include <asmp/asmp.h>
+
+/* A task is a thread running the core of the same number as the image
+ * name "subN", instead of loading an ELF file.
+ */
+
+typedef struct mptask_s {
+  int       core;
+  cpuid_t   cpu;
+  int       tile;
+  bool      running;
+  pthread_t tid;
+} mptask_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int mptask_init(mptask_t *task, const char *filename);
+int mptask_init_secure(mptask_t *task, const char *filename);
+int mptask_assign(mptask_t *task);
+cpuid_t mptask_getcpuid(mptask_t *task);
+int mptask_bindobj(mptask_t *task, void *obj);
+int mptask_exec(mptask_t *task);
+int mptask_destroy(mptask_t *task, bool force, int *exitstatus);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _MPSIM_ASMP_MPTASK_H_ */
@@ -0,0 +1,25 @@
+/*
+ *  cxd5602_backupmem.h - Backup SRAM for the host simulation
+ *  Copyright 2019 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _MPSIM_CHIP_HARDWARE_CXD5602_BACKUPMEM_H_
+#define _MPSIM_CHIP_HARDWARE_CXD5602_BACKUPMEM_H_
+
+/* See BACKUP_MEM in mpsim_hw.h */
+
+#endif /* _MPSIM_CHIP_HARDWARE_CXD5602_BACKUPMEM_H_ */
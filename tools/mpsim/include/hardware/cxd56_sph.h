@@ -0,0 +1,40 @@
+/*
+ *  cxd56_sph.h - Hardware semaphore registers for the host simulation
+ *  Copyright 2019 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _MPSIM_HARDWARE_CXD56_SPH_H_
+#define _MPSIM_HARDWARE_CXD56_SPH_H_
+
+#include <mpsim.h>
+
+#define CXD56_SPH_REQ(n)  (MPSIM_SPH_BASE + ((n) * 16) + 0)
+#define CXD56_SPH_STS(n)  (MPSIM_SPH_BASE + ((n) * 16) + 4)
+
+#define REQ_UNRESERVE 0
+#define REQ_LOCK      1
+#define REQ_UNLOCK    2
+#define REQ_RESERVE   3
+
+#define STATE_IDLE              0
+#define STATE_LOCKED            1
+#define STATE_LOCKEDANDRESERVED 2
+
+#define STS_STATE(sts)  (((sts) >> 16) & 0x3)
+#define LOCK_OWNER(sts) ((sts) & 0x1f)
+
+#endif /* _MPSIM_HARDWARE_CXD56_SPH_H_ */
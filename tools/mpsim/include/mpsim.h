@@ -0,0 +1,111 @@
+/*
+ *  mpsim.h - Host simulation of the Spresense Multi-Processer environment
+ *  Copyright 2019 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _MPSIM_H_
+#define _MPSIM_H_
+
+/**
+ * @file mpsim.h
+ * @brief Host simulation of the Spresense Multi-Processer environment
+ *
+ * @details Each core runs as a thread of one Linux process, and the shared
+ *          memory is a common region mapped at the address of the CXD5602
+ *          SRAM. The sketch of each core is built into its own relocatable
+ *          object, so the globals such as MP are separated per core.
+ *          The MP library must keep working with 32-bit addresses, so all of
+ *          the memory visible to the sketches is kept below 4GByte.
+ */
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <stdint.h>
+#include <stddef.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define MPSIM_CPU_CLOCK     (156000000) /* CYCCNT frequency [Hz] */
+#define MPSIM_MAIN_CPU      (2)         /* cpuid of MainCore */
+#define MPSIM_CPU_NUM       (9)         /* cpuid 2 to 8 are used */
+#define MPSIM_CORE_NUM      (6)         /* MainCore and SubCore 1 to 5 */
+
+#define MPSIM_SHM_BASE      (0x0d000000) /* same as the CXD5602 SRAM */
+#define MPSIM_TILE_SIZE     (128 * 1024)
+#define MPSIM_TILE_NUM      (12)
+#define MPSIM_MAIN_TILES    (6)          /* tiles used by MainCore itself */
+
+#define MPSIM_STACK_BASE    (0x0e000000)
+#define MPSIM_STACK_SIZE    (256 * 1024)
+#define MPSIM_STACK_NUM     (32)
+
+#define MPSIM_BACKUP_SIZE   (256)
+
+/* Simulated registers. See mpsim_getreg32(). */
+#define MPSIM_SPH_BASE      (0x04100000)
+#define MPSIM_SPH_NUM       (16)
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+/* Entry of a core, exported from the object of each core as mpsim_coreN */
+
+typedef struct mpsim_core_s {
+  void (*setup)(void);
+  void (*loop)(void);
+} mpsim_core_t;
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** cpuid of the calling thread. Threads inherit it from the creator. */
+uint32_t mpsim_cpuid(void);
+
+/** Cycle counter of 156MHz shared by all cores */
+uint32_t mpsim_cyccnt(void);
+
+/** Time since the simulation started */
+uint64_t mpsim_now_us(void);
+
+/** Memory used as the backup SRAM */
+uintptr_t mpsim_backup_mem(void);
+
+/** Register access emulated for the hardware semaphore and the tile status.
+ *  The other registers read as 0, and writes to them are ignored.
+ */
+uint32_t mpsim_getreg32(uintptr_t addr);
+void mpsim_putreg32(uint32_t val, uintptr_t addr);
+
+/** Wait for an event on the hardware semaphore, or a short time */
+void mpsim_wfe(void);
+void mpsim_sev(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _MPSIM_H_ */
@@ -0,0 +1,39 @@
+/*
+ *  mpsim_hw.h - Hardware access of the MP library on the host simulation
+ *  Copyright 2019 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _MPSIM_HW_H_
+#define _MPSIM_HW_H_
+
+/* Included before every source of the cores by -include. This replaces the
+ * register and instruction macros of the MP library.
+ */
+
+#include <mpsim.h>
+
+#define MP_GET_CPUID()      ((int)mpsim_cpuid())
+#define MP_DMB()            __sync_synchronize()
+#define MP_GET_CYCCNT()     mpsim_cyccnt()
+#define MP_ENABLE_CYCCNT()  do { } while (0)
+
+#define MP_MUTEX_WFE()      mpsim_wfe()
+#define MP_MUTEX_SEV()      mpsim_sev()
+
+#define BACKUP_MEM          mpsim_backup_mem()
+
+#endif /* _MPSIM_HW_H_ */
@@ -0,0 +1,39 @@
+/*
+ *  multi_print.h - Print from multiple cores for the host simulation
+ *  Copyright 2019 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _MPSIM_MULTI_PRINT_H_
+#define _MPSIM_MULTI_PRINT_H_
+
+#include <sys/types.h>
+#include <nuttx/irq.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+irqstate_t printlock(void);
+void printunlock(irqstate_t flags);
+int sync_printf(const char *fmt, ...);
+ssize_t uart_syncwrite(const char *buffer, size_t buflen);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _MPSIM_MULTI_PRINT_H_ */
@@ -0,0 +1,45 @@
+/*
+ *  irq.h - Interrupt control for the host simulation
+ *  Copyright 2019 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _MPSIM_NUTTX_IRQ_H_
+#define _MPSIM_NUTTX_IRQ_H_
+
+#include <stdint.h>
+
+/* A critical section serializes the threads of the same core only, like
+ * disabling the interrupts of the core.
+ */
+
+typedef uint32_t irqstate_t;
+
+#define CXD56_IRQ_EXTINT  (16)
+#define CXD56_IRQ_UART1   (CXD56_IRQ_EXTINT + 10)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+irqstate_t enter_critical_section(void);
+void leave_critical_section(irqstate_t flags);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _MPSIM_NUTTX_IRQ_H_ */
@@ -0,0 +1,70 @@
+/*
+ *  queue.h - Singly linked queue for the host simulation
+ *  Copyright 2019 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _MPSIM_NUTTX_QUEUE_H_
+#define _MPSIM_NUTTX_QUEUE_H_
+
+#include <stddef.h>
+
+typedef struct sq_entry_s {
+  struct sq_entry_s *flink;
+} sq_entry_t;
+
+typedef struct sq_queue_s {
+  sq_entry_t *head;
+  sq_entry_t *tail;
+} sq_queue_t;
+
+#define sq_init(q)  do { (q)->head = NULL; (q)->tail = NULL; } while (0)
+#define sq_next(p)  ((p)->flink)
+#define sq_peek(q)  ((q)->head)
+
+static inline void sq_addfirst(sq_entry_t *node, sq_queue_t *queue)
+{
+  node->flink = queue->head;
+  if (!queue->head) {
+    queue->tail = node;
+  }
+  queue->head = node;
+}
+
+static inline void sq_rem(sq_entry_t *node, sq_queue_t *queue)
+{
+  sq_entry_t *prev = NULL;
+  sq_entry_t *curr;
+
+  for (curr = queue->head; curr && (curr != node); curr = curr->flink) {
+    prev = curr;
+  }
+  if (!curr) {
+    return;
+  }
+
+  if (prev) {
+    prev->flink = node->flink;
+  } else {
+    queue->head = node->flink;
+  }
+  if (queue->tail == node) {
+    queue->tail = prev;
+  }
+  node->flink = NULL;
+}
+
+#endif /* _MPSIM_NUTTX_QUEUE_H_ */
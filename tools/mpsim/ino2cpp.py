@@ -0,0 +1,70 @@
+#! /usr/bin/env python3
+#
+# Convert an Arduino sketch to C++ like the Arduino builder does.
+#
+#   ino2cpp.py <sketch.ino> <output.cpp>
+#
+# Arduino.h is included at the top, and the prototypes of the functions
+# defined in the sketch are inserted before the first function.
+#
+
+import re
+import sys
+
+KEYWORDS = ('if', 'for', 'while', 'switch', 'return', 'else', 'do', 'sizeof')
+
+FUNC_RE = re.compile(
+    r'^(?P<decl>[A-Za-z_][\w:<>\*&\s,]*?[\s\*&](?P<name>[A-Za-z_]\w*)\s*\((?P<args>[^;{}()]*)\))\s*\{',
+    re.MULTILINE)
+
+def strip_comments(src):
+    # Replace the comments and strings with spaces to keep the offsets
+    def blank(m):
+        return re.sub(r'[^\n]', ' ', m.group(0))
+    return re.sub(r'//[^\n]*|/\*.*?\*/|"(?:\\.|[^"\\])*"|\'(?:\\.|[^\'\\])*\'',
+                  blank, src, flags=re.DOTALL)
+
+def main():
+    if len(sys.argv) != 3:
+        sys.stderr.write('Usage: %s <sketch.ino> <output.cpp>\n' % sys.argv[0])
+        return 1
+
+    ino = sys.argv[1]
+    with open(ino) as f:
+        src = f.read()
+
+    code = strip_comments(src)
+    depth = 0
+    protos = []
+    first = None
+    pos = 0
+
+    # Top level function definitions only
+    for m in FUNC_RE.finditer(code):
+        depth += code.count('{', pos, m.start()) - code.count('}', pos, m.start())
+        pos = m.start()
+        if depth != 0 or m.group('name') in KEYWORDS:
+            continue
+        protos.append(' '.join(m.group('decl').split()) + ';')
+        if first is None:
+            first = m.start()
+
+    if first is None:
+        first = len(src)
+
+    line = src.count('\n', 0, first) + 1
+    out = []
+    out.append('#include <Arduino.h>\n')
+    out.append('#line 1 "%s"\n' % ino)
+    out.append(src[:first])
+    out.append('\n'.join(protos) + '\n')
+    out.append('#line %d "%s"\n' % (line, ino))
+    out.append(src[first:])
+
+    with open(sys.argv[2], 'w') as f:
+        f.write(''.join(out))
+
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,198 @@
+/*
+ *  arduino.cpp - Arduino core for the host simulation
+ *  Copyright 2019 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <Arduino.h>
+#include <time.h>
+#include <mpsim.h>
+
+/****************************************************************************
+ * Public Data
+ ****************************************************************************/
+
+HardwareSerial Serial;
+
+bool g_rtc_enabled = true;
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+size_t Print::write(const uint8_t *buffer, size_t size)
+{
+  size_t n = 0;
+
+  while (size--) {
+    n += write(*buffer++);
+  }
+
+  return n;
+}
+
+size_t Print::print(const char *str)
+{
+  return write((const uint8_t *)str, strlen(str));
+}
+
+size_t Print::print(char c)
+{
+  return write((uint8_t)c);
+}
+
+size_t Print::print(int n)
+{
+  return print((long)n);
+}
+
+size_t Print::print(unsigned int n)
+{
+  return print((unsigned long)n);
+}
+
+size_t Print::print(long n)
+{
+  char buf[24];
+  snprintf(buf, sizeof(buf), "%ld", n);
+  return print(buf);
+}
+
+size_t Print::print(unsigned long n)
+{
+  char buf[24];
+  snprintf(buf, sizeof(buf), "%lu", n);
+  return print(buf);
+}
+
+size_t Print::print(double n, int digits)
+{
+  char buf[64];
+  snprintf(buf, sizeof(buf), "%.*f", digits, n);
+  return print(buf);
+}
+
+size_t Print::println(void)
+{
+  return print("\r\n");
+}
+
+size_t Print::println(const char *str)
+{
+  return print(str) + println();
+}
+
+size_t Print::println(char c)
+{
+  return print(c) + println();
+}
+
+size_t Print::println(int n)
+{
+  return print(n) + println();
+}
+
+size_t Print::println(unsigned int n)
+{
+  return print(n) + println();
+}
+
+size_t Print::println(long n)
+{
+  return print(n) + println();
+}
+
+size_t Print::println(unsigned long n)
+{
+  return print(n) + println();
+}
+
+size_t Print::println(double n, int digits)
+{
+  return print(n, digits) + println();
+}
+
+size_t HardwareSerial::write(uint8_t c)
+{
+  return fwrite(&c, 1, 1, stdout);
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size)
+{
+  return fwrite(buffer, 1, size, stdout);
+}
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+  (void)pin;
+  (void)value;
+}
+
+unsigned long millis(void)
+{
+  return mpsim_now_us() / 1000;
+}
+
+unsigned long micros(void)
+{
+  return mpsim_now_us();
+}
+
+void delay(unsigned long ms)
+{
+  struct timespec ts = { (time_t)(ms / 1000), (long)(ms % 1000) * 1000000 };
+  while (nanosleep(&ts, &ts) < 0);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+  uint64_t end = mpsim_now_us() + us;
+  while (mpsim_now_us() < end);
+}
+
+long random(long max)
+{
+  return (max > 0) ? (::random() % max) : 0;
+}
+
+long random(long min, long max)
+{
+  return (min < max) ? (min + random(max - min)) : min;
+}
+
+void randomSeed(unsigned long seed)
+{
+  if (seed != 0) {
+    srandom(seed);
+  }
+}
+
+void interrupts(void)
+{
+}
+
+void noInterrupts(void)
+{
+}
+
+unsigned long clockCyclesPerMicrosecond(void)
+{
+  return MPSIM_CPU_CLOCK / 1000000;
+}
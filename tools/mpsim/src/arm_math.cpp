@@ -0,0 +1,183 @@
+/*
+ *  arm_math.cpp - CMSIS DSP functions for the host simulation
+ *  Copyright 2019 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <math.h>
+#include <string.h>
+#include <complex>
+#include <vector>
+#include <arm_math.h>
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/* In-place radix-2 FFT */
+
+static void fft(std::vector<std::complex<float> > &x)
+{
+  size_t n = x.size();
+
+  for (size_t i = 1, j = 0; i < n; i++) {
+    size_t bit = n >> 1;
+    for (; j & bit; bit >>= 1) {
+      j ^= bit;
+    }
+    j ^= bit;
+    if (i < j) {
+      std::swap(x[i], x[j]);
+    }
+  }
+
+  for (size_t len = 2; len <= n; len <<= 1) {
+    std::complex<float> w(cosf(-2 * M_PI / len), sinf(-2 * M_PI / len));
+    for (size_t i = 0; i < n; i += len) {
+      std::complex<float> wk(1, 0);
+      for (size_t k = 0; k < len / 2; k++) {
+        std::complex<float> u = x[i + k];
+        std::complex<float> v = x[i + k + len / 2] * wk;
+        x[i + k] = u + v;
+        x[i + k + len / 2] = u - v;
+        wk *= w;
+      }
+    }
+  }
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+extern "C" {
+
+arm_status arm_rfft_fast_init_f32(arm_rfft_fast_instance_f32 *S, uint16_t fftLen)
+{
+  if ((fftLen < 32) || (4096 < fftLen) || (fftLen & (fftLen - 1))) {
+    return ARM_MATH_ARGUMENT_ERROR;
+  }
+
+  S->fftLenRFFT = fftLen;
+
+  return ARM_MATH_SUCCESS;
+}
+
+arm_status arm_rfft_32_fast_init_f32(arm_rfft_fast_instance_f32 *S)
+{
+  return arm_rfft_fast_init_f32(S, 32);
+}
+
+arm_status arm_rfft_64_fast_init_f32(arm_rfft_fast_instance_f32 *S)
+{
+  return arm_rfft_fast_init_f32(S, 64);
+}
+
+arm_status arm_rfft_128_fast_init_f32(arm_rfft_fast_instance_f32 *S)
+{
+  return arm_rfft_fast_init_f32(S, 128);
+}
+
+arm_status arm_rfft_256_fast_init_f32(arm_rfft_fast_instance_f32 *S)
+{
+  return arm_rfft_fast_init_f32(S, 256);
+}
+
+arm_status arm_rfft_512_fast_init_f32(arm_rfft_fast_instance_f32 *S)
+{
+  return arm_rfft_fast_init_f32(S, 512);
+}
+
+arm_status arm_rfft_1024_fast_init_f32(arm_rfft_fast_instance_f32 *S)
+{
+  return arm_rfft_fast_init_f32(S, 1024);
+}
+
+arm_status arm_rfft_2048_fast_init_f32(arm_rfft_fast_instance_f32 *S)
+{
+  return arm_rfft_fast_init_f32(S, 2048);
+}
+
+arm_status arm_rfft_4096_fast_init_f32(arm_rfft_fast_instance_f32 *S)
+{
+  return arm_rfft_fast_init_f32(S, 4096);
+}
+
+/* The output is packed as CMSIS. [0] is the real part of DC, [1] is the
+ * real part of Nyquist, and the complex values of 1 to N/2-1 follow.
+ * The inverse transform is not supported.
+ */
+
+void arm_rfft_fast_f32(const arm_rfft_fast_instance_f32 *S, float32_t *p,
+                       float32_t *pOut, uint8_t ifftFlag)
+{
+  uint32_t n = S->fftLenRFFT;
+
+  if (ifftFlag) {
+    memset(pOut, 0, n * sizeof(float32_t));
+    return;
+  }
+
+  std::vector<std::complex<float> > x(p, p + n);
+  fft(x);
+
+  pOut[0] = x[0].real();
+  pOut[1] = x[n / 2].real();
+  for (uint32_t k = 1; k < n / 2; k++) {
+    pOut[2 * k]     = x[k].real();
+    pOut[2 * k + 1] = x[k].imag();
+  }
+}
+
+void arm_cmplx_mag_f32(const float32_t *pSrc, float32_t *pDst, uint32_t numSamples)
+{
+  for (uint32_t i = 0; i < numSamples; i++) {
+    pDst[i] = sqrtf(pSrc[2 * i] * pSrc[2 * i] + pSrc[2 * i + 1] * pSrc[2 * i + 1]);
+  }
+}
+
+void arm_max_f32(const float32_t *pSrc, uint32_t blockSize,
+                 float32_t *pResult, uint32_t *pIndex)
+{
+  uint32_t index = 0;
+
+  for (uint32_t i = 1; i < blockSize; i++) {
+    if (pSrc[i] > pSrc[index]) {
+      index = i;
+    }
+  }
+
+  *pResult = pSrc[index];
+  *pIndex  = index;
+}
+
+void arm_copy_q15(const q15_t *pSrc, q15_t *pDst, uint32_t blockSize)
+{
+  memcpy(pDst, pSrc, blockSize * sizeof(q15_t));
+}
+
+void arm_q15_to_float(const q15_t *pSrc, float32_t *pDst, uint32_t blockSize)
+{
+  for (uint32_t i = 0; i < blockSize; i++) {
+    pDst[i] = (float32_t)pSrc[i] / 32768.0f;
+  }
+}
+
+} /* extern "C" */
@@ -0,0 +1,112 @@
+/*
+ *  audio.cpp - Audio recorder for the host simulation
+ *  Copyright 2019 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <math.h>
+#include <Audio.h>
+#include <mpsim.h>
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+AudioClass::AudioClass()
+  : _rate(AS_SAMPLINGRATE_48000), _channel(AS_CHANNEL_MONO), _running(false),
+    _start(0), _frames(0)
+{
+}
+
+AudioClass *AudioClass::getInstance()
+{
+  static AudioClass instance;
+  return &instance;
+}
+
+err_t AudioClass::begin(void)
+{
+  return AUDIOLIB_ECODE_OK;
+}
+
+err_t AudioClass::end(void)
+{
+  _running = false;
+  return AUDIOLIB_ECODE_OK;
+}
+
+err_t AudioClass::setRecorderMode(uint8_t input_device, int32_t input_gain)
+{
+  (void)input_device;
+  (void)input_gain;
+  return AUDIOLIB_ECODE_OK;
+}
+
+err_t AudioClass::initRecorder(uint8_t codec_type, const char *codec_path,
+                               uint32_t sampling_rate, uint8_t channel)
+{
+  (void)codec_type;
+  (void)codec_path;
+  _rate    = sampling_rate;
+  _channel = channel;
+  return AUDIOLIB_ECODE_OK;
+}
+
+err_t AudioClass::startRecorder(void)
+{
+  _start   = mpsim_now_us();
+  _frames  = 0;
+  _running = true;
+  return AUDIOLIB_ECODE_OK;
+}
+
+err_t AudioClass::stopRecorder(void)
+{
+  _running = false;
+  return AUDIOLIB_ECODE_OK;
+}
+
+err_t AudioClass::readFrames(char *buffer, uint32_t buffer_size, uint32_t *read_size)
+{
+  *read_size = 0;
+
+  if (!_running) {
+    return AUDIOLIB_ECODE_STATE_ERROR;
+  }
+
+  uint32_t frames = buffer_size / (_channel * sizeof(int16_t));
+  uint64_t recorded = (mpsim_now_us() - _start) * _rate / 1000000;
+
+  if (recorded < _frames + frames) {
+    return AUDIOLIB_ECODE_OK;
+  }
+
+  int16_t *pcm = (int16_t *)buffer;
+  for (uint32_t i = 0; i < frames; i++) {
+    double t = (double)(_frames + i) / _rate;
+    for (int ch = 0; ch < _channel; ch++) {
+      *pcm++ = (int16_t)(16000 * sin(2 * M_PI * MPSIM_AUDIO_FREQ * (ch + 1) * t));
+    }
+  }
+  _frames += frames;
+  *read_size = frames * _channel * sizeof(int16_t);
+
+  return AUDIOLIB_ECODE_OK;
+}
@@ -0,0 +1,49 @@
+/*
+ *  core_entry.cpp - Entry of a core for the host simulation
+ *  Copyright 2019 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/* Built into the object of each core with -DMPSIM_CORE=N. This is the only
+ * symbol exported from the object.
+ */
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <mpsim.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define MPSIM_ENTRY_(n) mpsim_core##n
+#define MPSIM_ENTRY(n)  MPSIM_ENTRY_(n)
+
+/****************************************************************************
+ * External Function Prototypes
+ ****************************************************************************/
+
+void setup(void);
+void loop(void);
+
+/****************************************************************************
+ * Public Data
+ ****************************************************************************/
+
+extern "C" __attribute__((visibility("default")))
+const mpsim_core_t MPSIM_ENTRY(MPSIM_CORE) = { setup, loop };
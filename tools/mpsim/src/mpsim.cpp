@@ -0,0 +1,963 @@
+/*
+ *  mpsim.cpp - Host simulation of the Spresense Multi-Processer environment
+ *  Copyright 2019 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <malloc.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+
+#include <mpsim.h>
+#include <asmp/mpmq.h>
+#include <asmp/mpshm.h>
+#include <asmp/mptask.h>
+#include <hardware/cxd56_sph.h>
+#include <multi_print.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define MQ_DEPTH_MAX        (64)
+#define MQ_DEPTH_DEFAULT    (8)
+
+#define APPDSP_RAMMODE_STAT0 0x04104420
+#define APPDSP_RAMMODE_STAT1 0x04104424
+
+#define WFE_TIMEOUT_US      (1000)
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct mq_msg {
+  int8_t   msgid;
+  uint32_t data;
+  uint64_t sent;  /* [us] */
+  uint64_t due;   /* [us] sent + latency */
+};
+
+/* Messages from one cpu to another */
+
+struct mailbox {
+  pthread_mutex_t lock;
+  pthread_cond_t  cond;
+  struct mq_msg   msg[MQ_DEPTH_MAX];
+  uint32_t        head;
+  uint32_t        tail;
+
+  /* Statistics */
+  uint32_t        count;
+  uint32_t        blocked;   /* sends which waited for a free slot */
+  uint32_t        maxdepth;
+  uint64_t        latency;   /* total of send to receive [us] */
+  uint64_t        maxlatency;
+};
+
+struct thread_start {
+  void    *(*func)(void *);
+  void     *arg;
+  uint32_t cpu;
+};
+
+/****************************************************************************
+ * External Function Prototypes
+ ****************************************************************************/
+
+extern "C" {
+int __real_open(const char *path, int flags, ...);
+int __real_pthread_create(pthread_t *thread, const pthread_attr_t *attr,
+                          void *(*func)(void *), void *arg);
+}
+
+/* Entries of the cores. A core not built into the binary is NULL. */
+
+extern "C" {
+extern const mpsim_core_t mpsim_core0 __attribute__((weak));
+extern const mpsim_core_t mpsim_core1 __attribute__((weak));
+extern const mpsim_core_t mpsim_core2 __attribute__((weak));
+extern const mpsim_core_t mpsim_core3 __attribute__((weak));
+extern const mpsim_core_t mpsim_core4 __attribute__((weak));
+extern const mpsim_core_t mpsim_core5 __attribute__((weak));
+}
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static const mpsim_core_t *g_cores[MPSIM_CORE_NUM] = {
+  &mpsim_core0, &mpsim_core1, &mpsim_core2,
+  &mpsim_core3, &mpsim_core4, &mpsim_core5,
+};
+
+static __thread uint32_t g_cpu = MPSIM_MAIN_CPU;
+
+static struct timespec g_start;
+
+/* Configuration */
+
+static uint32_t g_latency = 0;                /* [us] */
+static uint32_t g_depth   = MQ_DEPTH_DEFAULT; /* messages */
+
+/* Resources of the cores */
+
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t g_csec[MPSIM_CPU_NUM];
+static pthread_mutex_t g_printlock;
+static int             g_cpucore[MPSIM_CPU_NUM]; /* core number or -1 */
+static int             g_tile[MPSIM_TILE_NUM];   /* owner cpu or 0 */
+static uint32_t        g_stackused;
+static uint32_t        g_backup[MPSIM_BACKUP_SIZE / 4];
+
+static struct mailbox  g_mbx[MPSIM_CPU_NUM][MPSIM_CPU_NUM]; /* [to][from] */
+
+/* Hardware semaphore and WFE/SEV */
+
+static volatile uint32_t g_sph[MPSIM_SPH_NUM];
+static pthread_mutex_t   g_evlock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t    g_evcond;
+static bool              g_evreg[MPSIM_CPU_NUM]; /* event register of each cpu */
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static void abstime(struct timespec *ts, uint64_t us)
+{
+  uint64_t ns = (uint64_t)g_start.tv_nsec + (us * 1000);
+
+  ts->tv_sec  = g_start.tv_sec + (ns / 1000000000);
+  ts->tv_nsec = ns % 1000000000;
+}
+
+static void cond_init(pthread_cond_t *cond)
+{
+  pthread_condattr_t attr;
+
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+  pthread_cond_init(cond, &attr);
+  pthread_condattr_destroy(&attr);
+}
+
+static const char *cpuname(int cpu, char *buf, size_t size)
+{
+  if (cpu == MPSIM_MAIN_CPU) {
+    snprintf(buf, size, "Main");
+  } else if (g_cpucore[cpu] > 0) {
+    snprintf(buf, size, "Sub%d", g_cpucore[cpu]);
+  } else {
+    snprintf(buf, size, "cpu%d", cpu);
+  }
+  return buf;
+}
+
+/* Keep the memory of the sketches below 4GByte. The heap grows by brk just
+ * after the globals of the non-PIE binary, and the stacks of the threads
+ * are taken from a fixed region.
+ */
+
+__attribute__((constructor(101)))
+static void mpsim_initialize(void)
+{
+  clock_gettime(CLOCK_MONOTONIC, &g_start);
+
+  mallopt(M_MMAP_MAX, 0);
+  mallopt(M_ARENA_MAX, 1);
+
+  void *shm = mmap((void *)MPSIM_SHM_BASE, MPSIM_TILE_NUM * MPSIM_TILE_SIZE,
+                   PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+  void *stack = mmap((void *)MPSIM_STACK_BASE, MPSIM_STACK_NUM * MPSIM_STACK_SIZE,
+                     PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+  if ((shm != (void *)MPSIM_SHM_BASE) || (stack != (void *)MPSIM_STACK_BASE)) {
+    fprintf(stderr, "mpsim: cannot map the memory of the cores\n");
+    exit(1);
+  }
+
+  pthread_mutexattr_t attr;
+  pthread_mutexattr_init(&attr);
+  pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+  for (int cpu = 0; cpu < MPSIM_CPU_NUM; cpu++) {
+    pthread_mutex_init(&g_csec[cpu], &attr);
+    g_cpucore[cpu] = -1;
+  }
+  pthread_mutex_init(&g_printlock, &attr);
+  pthread_mutexattr_destroy(&attr);
+
+  for (int to = 0; to < MPSIM_CPU_NUM; to++) {
+    for (int from = 0; from < MPSIM_CPU_NUM; from++) {
+      pthread_mutex_init(&g_mbx[to][from].lock, NULL);
+      cond_init(&g_mbx[to][from].cond);
+    }
+  }
+  cond_init(&g_evcond);
+
+  /* MainCore itself */
+  g_cpucore[MPSIM_MAIN_CPU] = 0;
+  for (int i = 0; i < MPSIM_MAIN_TILES; i++) {
+    g_tile[i] = MPSIM_MAIN_CPU;
+  }
+}
+
+/* Find contiguous free tiles. Call with g_lock locked. */
+
+static int tile_alloc(int num, int cpu)
+{
+  int run = 0;
+
+  for (int i = 0; i < MPSIM_TILE_NUM; i++) {
+    run = g_tile[i] ? 0 : (run + 1);
+    if (run == num) {
+      int start = i - num + 1;
+      for (int j = start; j <= i; j++) {
+        g_tile[j] = cpu;
+      }
+      return start;
+    }
+  }
+
+  return -1;
+}
+
+static void tile_free(int start, int num)
+{
+  for (int i = start; (i < start + num) && (i < MPSIM_TILE_NUM); i++) {
+    g_tile[i] = 0;
+  }
+}
+
+static void *thread_start(void *arg)
+{
+  struct thread_start start = *(struct thread_start *)arg;
+
+  free(arg);
+  g_cpu = start.cpu;
+
+  return start.func(start.arg);
+}
+
+static int thread_create(pthread_t *thread, const pthread_attr_t *attr,
+                         void *(*func)(void *), void *arg, uint32_t cpu)
+{
+  pthread_attr_t lowattr;
+  int detach = PTHREAD_CREATE_JOINABLE;
+
+  /* Stacks are not reused, because a thread may still run on its stack
+   * while it is exiting.
+   */
+  uint32_t slot = __sync_fetch_and_add(&g_stackused, 1);
+  if (slot >= MPSIM_STACK_NUM) {
+    fprintf(stderr, "mpsim: out of thread stacks\n");
+    return EAGAIN;
+  }
+
+  struct thread_start *start = (struct thread_start *)malloc(sizeof(*start));
+  if (!start) {
+    return ENOMEM;
+  }
+  start->func = func;
+  start->arg  = arg;
+  start->cpu  = cpu;
+
+  if (attr) {
+    pthread_attr_getdetachstate(attr, &detach);
+  }
+  pthread_attr_init(&lowattr);
+  pthread_attr_setdetachstate(&lowattr, detach);
+  pthread_attr_setstack(&lowattr,
+                        (void *)(uintptr_t)(MPSIM_STACK_BASE + (slot * MPSIM_STACK_SIZE)),
+                        MPSIM_STACK_SIZE);
+
+  int ret = __real_pthread_create(thread, &lowattr, thread_start, start);
+  pthread_attr_destroy(&lowattr);
+  if (ret != 0) {
+    free(start);
+  }
+
+  return ret;
+}
+
+static void *core_main(void *arg)
+{
+  const mpsim_core_t *core = (const mpsim_core_t *)arg;
+
+  core->setup();
+  for (;;) {
+    core->loop();
+
+    /* Let the other threads run even if loop() is empty */
+    pthread_testcancel();
+    sched_yield();
+  }
+
+  return NULL;
+}
+
+static void report(void)
+{
+  uint64_t now = mpsim_now_us();
+  char from[16];
+  char to[16];
+
+  fprintf(stderr, "\nmpsim: %.3f sec, latency %lu us, depth %lu\n",
+          now / 1000000.0, (unsigned long)g_latency, (unsigned long)g_depth);
+  fprintf(stderr, "  %-11s %10s %10s %10s %10s %6s %8s\n", "channel",
+          "messages", "msg/sec", "avg[us]", "max[us]", "depth", "blocked");
+
+  for (int t = 0; t < MPSIM_CPU_NUM; t++) {
+    for (int f = 0; f < MPSIM_CPU_NUM; f++) {
+      struct mailbox *box = &g_mbx[t][f];
+
+      pthread_mutex_lock(&box->lock);
+      if (box->count) {
+        fprintf(stderr, "  %4s->%-5s %10lu %10.1f %10.1f %10lu %6lu %8lu\n",
+                cpuname(f, from, sizeof(from)), cpuname(t, to, sizeof(to)),
+                (unsigned long)box->count,
+                now ? box->count * 1000000.0 / now : 0.0,
+                (double)box->latency / box->count,
+                (unsigned long)box->maxlatency,
+                (unsigned long)box->maxdepth, (unsigned long)box->blocked);
+      }
+      pthread_mutex_unlock(&box->lock);
+    }
+  }
+}
+
+static void usage(const char *name)
+{
+  fprintf(stderr,
+          "Usage: %s [-l latency] [-d depth] [-t seconds]\n"
+          "  -l latency  delay of each message [us] (default 0)\n"
+          "  -d depth    messages in flight per channel (default %d, max %d)\n"
+          "  -t seconds  stop and report after the time (default: run until SIGINT)\n",
+          name, MQ_DEPTH_DEFAULT, MQ_DEPTH_MAX);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+extern "C" {
+
+uint32_t mpsim_cpuid(void)
+{
+  return g_cpu;
+}
+
+uint64_t mpsim_now_us(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)(ts.tv_sec - g_start.tv_sec) * 1000000) +
+         ((int64_t)ts.tv_nsec - g_start.tv_nsec) / 1000;
+}
+
+uint32_t mpsim_cyccnt(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  uint64_t ns = ((uint64_t)ts.tv_sec * 1000000000) + ts.tv_nsec;
+  return (uint32_t)(ns * (MPSIM_CPU_CLOCK / 1000000) / 1000);
+}
+
+uintptr_t mpsim_backup_mem(void)
+{
+  return (uintptr_t)g_backup;
+}
+
+uint32_t mpsim_getreg32(uintptr_t addr)
+{
+  if ((MPSIM_SPH_BASE <= addr) && (addr < CXD56_SPH_REQ(MPSIM_SPH_NUM))) {
+    uint32_t n = (addr - MPSIM_SPH_BASE) / 16;
+    if (addr == CXD56_SPH_STS(n)) {
+      return g_sph[n];
+    }
+    return 0;
+  }
+
+  if ((addr == APPDSP_RAMMODE_STAT0) || (addr == APPDSP_RAMMODE_STAT1)) {
+    int first = (addr == APPDSP_RAMMODE_STAT0) ? 0 : 6;
+    uint32_t stat = 0;
+
+    pthread_mutex_lock(&g_lock);
+    for (int i = 0; i < 6; i++) {
+      if (g_tile[first + i]) {
+        stat |= 1 << (i * 2);
+      }
+    }
+    pthread_mutex_unlock(&g_lock);
+    return stat;
+  }
+
+  return 0;
+}
+
+void mpsim_putreg32(uint32_t val, uintptr_t addr)
+{
+  if ((MPSIM_SPH_BASE <= addr) && (addr < CXD56_SPH_REQ(MPSIM_SPH_NUM))) {
+    uint32_t n = (addr - MPSIM_SPH_BASE) / 16;
+    uint32_t locked = (STATE_LOCKED << 16) | g_cpu;
+
+    if (addr != CXD56_SPH_REQ(n)) {
+      return;
+    }
+    if (val == REQ_LOCK) {
+      __sync_bool_compare_and_swap(&g_sph[n], 0, locked);
+    } else if (val == REQ_UNLOCK) {
+      __sync_bool_compare_and_swap(&g_sph[n], locked, 0);
+    }
+  }
+}
+
+/* As the Cortex-M, WFE returns at once and clears the event register if it
+ * is set, and SEV sets the event register of all cpus including itself.
+ * The timeout stands for an interrupt.
+ */
+
+void mpsim_wfe(void)
+{
+  struct timespec ts;
+  uint32_t cpu = mpsim_cpuid();
+
+  pthread_mutex_lock(&g_evlock);
+  abstime(&ts, mpsim_now_us() + WFE_TIMEOUT_US);
+  while (!g_evreg[cpu]) {
+    if (pthread_cond_timedwait(&g_evcond, &g_evlock, &ts) == ETIMEDOUT) {
+      break;
+    }
+  }
+  g_evreg[cpu] = false;
+  pthread_mutex_unlock(&g_evlock);
+}
+
+void mpsim_sev(void)
+{
+  pthread_mutex_lock(&g_evlock);
+  for (int cpu = 0; cpu < MPSIM_CPU_NUM; cpu++) {
+    g_evreg[cpu] = true;
+  }
+  pthread_cond_broadcast(&g_evcond);
+  pthread_mutex_unlock(&g_evlock);
+}
+
+/* Critical section and print lock */
+
+irqstate_t enter_critical_section(void)
+{
+  pthread_mutex_lock(&g_csec[g_cpu]);
+  return 0;
+}
+
+void leave_critical_section(irqstate_t flags)
+{
+  (void)flags;
+  pthread_mutex_unlock(&g_csec[g_cpu]);
+}
+
+irqstate_t printlock(void)
+{
+  pthread_mutex_lock(&g_printlock);
+  return 0;
+}
+
+void printunlock(irqstate_t flags)
+{
+  (void)flags;
+  pthread_mutex_unlock(&g_printlock);
+}
+
+int sync_printf(const char *fmt, ...)
+{
+  va_list ap;
+
+  va_start(ap, fmt);
+  int ret = vprintf(fmt, ap);
+  va_end(ap);
+  fflush(stdout);
+
+  return ret;
+}
+
+ssize_t uart_syncwrite(const char *buffer, size_t buflen)
+{
+  size_t n = fwrite(buffer, 1, buflen, stdout);
+  fflush(stdout);
+
+  return n;
+}
+
+/* Linked with --wrap=open and --wrap=pthread_create */
+
+int __wrap_open(const char *path, int flags, ...)
+{
+  mode_t mode = 0;
+
+  /* Hardware semaphore devices */
+  if (strncmp(path, "/dev/hsem", 9) == 0) {
+    return __real_open("/dev/null", O_RDONLY);
+  }
+
+  if (flags & O_CREAT) {
+    va_list ap;
+    va_start(ap, flags);
+    mode = va_arg(ap, int);
+    va_end(ap);
+  }
+
+  return __real_open(path, flags, mode);
+}
+
+int __wrap_pthread_create(pthread_t *thread, const pthread_attr_t *attr,
+                          void *(*func)(void *), void *arg)
+{
+  /* A task runs on the core of the creator */
+  return thread_create(thread, attr, func, arg, g_cpu);
+}
+
+/* Message queue */
+
+int mpmq_init(mpmq_t *mq, int key, cpuid_t cpu)
+{
+  if (!mq || (cpu < MPSIM_MAIN_CPU) || (MPSIM_CPU_NUM <= cpu)) {
+    return -EINVAL;
+  }
+
+  mq->cpuid = cpu;
+  mq->local = g_cpu;
+  mq->key   = key;
+
+  return 0;
+}
+
+int mpmq_destroy(mpmq_t *mq)
+{
+  if (!mq || !mq->cpuid) {
+    return -EINVAL;
+  }
+
+  /* Discard the messages in both directions */
+  struct mailbox *boxes[2] = {
+    &g_mbx[mq->cpuid][mq->local], &g_mbx[mq->local][mq->cpuid]
+  };
+  for (int i = 0; i < 2; i++) {
+    pthread_mutex_lock(&boxes[i]->lock);
+    boxes[i]->head = boxes[i]->tail;
+    pthread_cond_broadcast(&boxes[i]->cond);
+    pthread_mutex_unlock(&boxes[i]->lock);
+  }
+
+  return 0;
+}
+
+static int mq_send(mpmq_t *mq, int8_t msgid, uint32_t data, bool wait)
+{
+  if (!mq || !mq->cpuid) {
+    return -EINVAL;
+  }
+
+  struct mailbox *box = &g_mbx[mq->cpuid][mq->local];
+
+  pthread_mutex_lock(&box->lock);
+
+  if ((box->tail - box->head) >= g_depth) {
+    if (!wait) {
+      pthread_mutex_unlock(&box->lock);
+      return -EAGAIN;
+    }
+    box->blocked++;
+    while ((box->tail - box->head) >= g_depth) {
+      pthread_cond_wait(&box->cond, &box->lock);
+    }
+  }
+
+  uint64_t now = mpsim_now_us();
+  struct mq_msg *msg = &box->msg[box->tail % MQ_DEPTH_MAX];
+
+  msg->msgid = msgid;
+  msg->data  = data;
+  msg->sent  = now;
+  msg->due   = now + g_latency;
+  box->tail++;
+
+  if ((box->tail - box->head) > box->maxdepth) {
+    box->maxdepth = box->tail - box->head;
+  }
+
+  pthread_cond_broadcast(&box->cond);
+  pthread_mutex_unlock(&box->lock);
+
+  return 0;
+}
+
+int mpmq_send(mpmq_t *mq, int8_t msgid, uint32_t data)
+{
+  return mq_send(mq, msgid, data, true);
+}
+
+int mpmq_trysend(mpmq_t *mq, int8_t msgid, uint32_t data)
+{
+  return mq_send(mq, msgid, data, false);
+}
+
+int mpmq_timedreceive(mpmq_t *mq, uint32_t *data, uint32_t ms)
+{
+  if (!mq || !mq->cpuid || !data) {
+    return -EINVAL;
+  }
+
+  struct mailbox *box = &g_mbx[mq->local][mq->cpuid];
+  bool poll = (ms == MPMQ_NONBLOCK);
+  uint64_t deadline = (poll || (ms == 0)) ? 0 : mpsim_now_us() + (ms * 1000ull);
+  struct timespec ts;
+  int ret = 0;
+
+  pthread_mutex_lock(&box->lock);
+
+  for (;;) {
+    uint64_t now = mpsim_now_us();
+    uint64_t wake = deadline;
+
+    if (box->head != box->tail) {
+      struct mq_msg *msg = &box->msg[box->head % MQ_DEPTH_MAX];
+
+      if (msg->due <= now) {
+        *data = msg->data;
+        ret = msg->msgid;
+        box->head++;
+
+        box->count++;
+        box->latency += now - msg->sent;
+        if ((now - msg->sent) > box->maxlatency) {
+          box->maxlatency = now - msg->sent;
+        }
+
+        pthread_cond_broadcast(&box->cond);
+        break;
+      }
+
+      /* Not arrived yet */
+      if (!wake || (msg->due < wake)) {
+        wake = msg->due;
+      }
+    }
+
+    if (poll) {
+      ret = -EAGAIN;
+      break;
+    }
+    if (deadline && (deadline <= now)) {
+      ret = -ETIMEDOUT;
+      break;
+    }
+
+    if (wake) {
+      abstime(&ts, wake);
+      pthread_cond_timedwait(&box->cond, &box->lock, &ts);
+    } else {
+      pthread_cond_wait(&box->cond, &box->lock);
+    }
+  }
+
+  pthread_mutex_unlock(&box->lock);
+
+  return ret;
+}
+
+int mpmq_receive(mpmq_t *mq, uint32_t *data)
+{
+  return mpmq_timedreceive(mq, data, 0);
+}
+
+/* Shared memory */
+
+int mpshm_init(mpshm_t *shm, int key, size_t size)
+{
+  if (!shm || (size == 0)) {
+    return -EINVAL;
+  }
+
+  int num = (size + MPSIM_TILE_SIZE - 1) / MPSIM_TILE_SIZE;
+
+  pthread_mutex_lock(&g_lock);
+  int tile = tile_alloc(num, g_cpu);
+  pthread_mutex_unlock(&g_lock);
+
+  if (tile < 0) {
+    return -ENOMEM;
+  }
+
+  shm->key  = key;
+  shm->tile = tile;
+  shm->num  = num;
+  shm->addr = NULL;
+
+  return 0;
+}
+
+int mpshm_destroy(mpshm_t *shm)
+{
+  if (!shm || !shm->num) {
+    return -EINVAL;
+  }
+
+  pthread_mutex_lock(&g_lock);
+  tile_free(shm->tile, shm->num);
+  pthread_mutex_unlock(&g_lock);
+
+  shm->num = 0;
+
+  return 0;
+}
+
+void *mpshm_attach(mpshm_t *shm, int shmflg)
+{
+  (void)shmflg;
+
+  if (!shm || !shm->num) {
+    return NULL;
+  }
+
+  shm->addr = (void *)(uintptr_t)(MPSIM_SHM_BASE + (shm->tile * MPSIM_TILE_SIZE));
+
+  return shm->addr;
+}
+
+int mpshm_detach(mpshm_t *shm)
+{
+  if (!shm) {
+    return -EINVAL;
+  }
+
+  shm->addr = NULL;
+
+  return 0;
+}
+
+/* The same address is used by all cores */
+
+uintptr_t mpshm_virt2phys(mpshm_t *shm, void *va)
+{
+  (void)shm;
+  return (uintptr_t)va;
+}
+
+void *mpshm_phys2virt(mpshm_t *shm, uintptr_t pa)
+{
+  (void)shm;
+  return (void *)pa;
+}
+
+/* Task */
+
+int mptask_init(mptask_t *task, const char *filename)
+{
+  if (!task || !filename) {
+    return -EINVAL;
+  }
+
+  /* Run the core by the name of the image such as "/mnt/sd0/sub1.elf" */
+  const char *name = strrchr(filename, '/');
+  name = name ? (name + 1) : filename;
+
+  if (strncasecmp(name, "sub", 3) == 0) {
+    int core = atoi(&name[3]);
+    if ((0 < core) && (core < MPSIM_CORE_NUM) && g_cores[core]) {
+      memset(task, 0, sizeof(*task));
+      task->core = core;
+      return 0;
+    }
+  }
+
+  return -ENOENT;
+}
+
+int mptask_init_secure(mptask_t *task, const char *filename)
+{
+  return mptask_init(task, filename);
+}
+
+int mptask_assign(mptask_t *task)
+{
+  int ret = -EBUSY;
+
+  if (!task || !task->core) {
+    return -EINVAL;
+  }
+
+  pthread_mutex_lock(&g_lock);
+
+  for (int cpu = MPSIM_MAIN_CPU + 1; cpu < MPSIM_CPU_NUM; cpu++) {
+    if (g_cpucore[cpu] < 0) {
+      /* The image of SubCore takes a tile */
+      int tile = tile_alloc(1, cpu);
+      if (tile < 0) {
+        ret = -ENOMEM;
+        break;
+      }
+      g_cpucore[cpu] = task->core;
+      task->cpu  = cpu;
+      task->tile = tile;
+      ret = 0;
+      break;
+    }
+  }
+
+  pthread_mutex_unlock(&g_lock);
+
+  return ret;
+}
+
+cpuid_t mptask_getcpuid(mptask_t *task)
+{
+  return task ? task->cpu : 0;
+}
+
+int mptask_bindobj(mptask_t *task, void *obj)
+{
+  (void)obj;
+  return task ? 0 : -EINVAL;
+}
+
+int mptask_exec(mptask_t *task)
+{
+  if (!task || !task->cpu || task->running) {
+    return -EINVAL;
+  }
+
+  int ret = thread_create(&task->tid, NULL, core_main,
+                          (void *)g_cores[task->core], task->cpu);
+  if (ret != 0) {
+    return -ret;
+  }
+
+  char name[16];
+  snprintf(name, sizeof(name), "Sub%d", task->core);
+  pthread_setname_np(task->tid, name);
+  task->running = true;
+
+  return 0;
+}
+
+int mptask_destroy(mptask_t *task, bool force, int *exitstatus)
+{
+  (void)force;
+
+  if (!task || !task->cpu) {
+    return -EINVAL;
+  }
+
+  if (task->running) {
+    pthread_cancel(task->tid);
+    pthread_join(task->tid, NULL);
+    task->running = false;
+  }
+
+  pthread_mutex_lock(&g_lock);
+  tile_free(task->tile, 1);
+  g_cpucore[task->cpu] = -1;
+  pthread_mutex_unlock(&g_lock);
+
+  task->cpu = 0;
+  if (exitstatus) {
+    *exitstatus = 0;
+  }
+
+  return 0;
+}
+
+} /* extern "C" */
+
+int main(int argc, char **argv)
+{
+  int timeout = 0;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "l:d:t:h")) != -1) {
+    switch (opt) {
+      case 'l':
+        g_latency = strtoul(optarg, NULL, 0);
+        break;
+      case 'd':
+        g_depth = strtoul(optarg, NULL, 0);
+        if ((g_depth == 0) || (MQ_DEPTH_MAX < g_depth)) {
+          usage(argv[0]);
+          return 1;
+        }
+        break;
+      case 't':
+        timeout = atoi(optarg);
+        break;
+      default:
+        usage(argv[0]);
+        return 1;
+    }
+  }
+
+  if (!g_cores[0]) {
+    fprintf(stderr, "mpsim: no MainCore sketch\n");
+    return 1;
+  }
+
+  /* Signals are handled by this thread only */
+  sigset_t set;
+  sigemptyset(&set);
+  sigaddset(&set, SIGINT);
+  sigaddset(&set, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &set, NULL);
+
+  pthread_t tid;
+  int ret = thread_create(&tid, NULL, core_main, (void *)g_cores[0],
+                          MPSIM_MAIN_CPU);
+  if (ret != 0) {
+    fprintf(stderr, "mpsim: cannot start MainCore. %d\n", ret);
+    return 1;
+  }
+  pthread_setname_np(tid, "Main");
+
+  if (timeout > 0) {
+    struct timespec ts = { timeout, 0 };
+    sigtimedwait(&set, NULL, &ts);
+  } else {
+    int sig;
+    sigwait(&set, &sig);
+  }
+
+  fflush(stdout);
+  report();
+
+  /* The cores never return, so exit without the destructors */
+  _exit(0);
+}
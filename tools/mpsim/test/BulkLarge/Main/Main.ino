@@ -0,0 +1,96 @@
+/*
+ *  Main.ino - mpsim test of a record larger than half of the bulk ring buffer
+ *  Copyright 2019 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifdef SUBCORE
+#error "Core selection is wrong!!"
+#endif
+
+#include <MP.h>
+
+/* Both ring buffers fit in 128KByte, so each of them is 65504 bytes */
+#define BULK_SIZE  (60 * 1024)
+#define FIRST_SIZE (40000) /* Moves the position to the middle of the ring */
+#define LARGE_SIZE (45000) /* Fits neither before nor after the position */
+
+int subcore = 1;
+
+static uint8_t data[LARGE_SIZE];
+
+static int transfer(size_t size)
+{
+  int      ret;
+  int8_t   msgid;
+  uint32_t sum = 0;
+  uint32_t result;
+
+  for (size_t i = 0; i < size; i++) {
+    data[i] = (uint8_t)(size + i);
+    sum += data[i];
+  }
+
+  ret = MP.SendBulk(10, data, size, subcore);
+  if (ret < 0) {
+    printf("FAIL: SendBulk(%d) = %d\n", (int)size, ret);
+    return ret;
+  }
+
+  ret = MP.Recv(&msgid, &result, subcore);
+  if (ret < 0) {
+    printf("FAIL: Recv = %d\n", ret);
+    return ret;
+  }
+
+  if (result != sum) {
+    printf("FAIL: size=%d sum=%lu expected=%lu\n", (int)size, result, sum);
+    return -1;
+  }
+
+  return MP.SendBulkWaitComplete(subcore);
+}
+
+void setup()
+{
+  int ret;
+
+  ret = MP.begin(subcore);
+  if (ret < 0) {
+    printf("FAIL: MP.begin = %d\n", ret);
+    return;
+  }
+
+  ret = MP.BulkBegin(subcore, BULK_SIZE);
+  if (ret < 0) {
+    printf("FAIL: MP.BulkBegin = %d\n", ret);
+    return;
+  }
+
+  MP.RecvTimeout(1000);
+
+  /* The ring is empty again after the first record, so the large record
+   * must be sent without -EAGAIN.
+   */
+  if ((transfer(FIRST_SIZE) == 0) && (transfer(LARGE_SIZE) == 0)) {
+    printf("PASS\n");
+  }
+}
+
+void loop()
+{
+  delay(1000);
+}
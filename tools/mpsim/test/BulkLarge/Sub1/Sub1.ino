@@ -0,0 +1,48 @@
+/*
+ *  Sub1.ino - mpsim test of a record larger than half of the bulk ring buffer
+ *  Copyright 2019 Sony Semiconductor Solutions Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#if (SUBCORE != 1)
+#error "Core selection is wrong!!"
+#endif
+
+#include <MP.h>
+
+void setup()
+{
+  MP.begin();
+  MP.BulkBegin();
+}
+
+void loop()
+{
+  int8_t     msgid;
+  MPBulkSpan span;
+  uint32_t   sum = 0;
+
+  if (MP.RecvBulk(&msgid, &span) < 0) {
+    return;
+  }
+
+  for (size_t i = 0; i < span.size; i++) {
+    sum += ((uint8_t *)span.data)[i];
+  }
+  MP.ReleaseBulk(span);
+
+  MP.Send(msgid, sum);
+}